@@ -0,0 +1,39 @@
+import sys
+import json
+
+# Compare two outputs of the kernel microbenchmarks (see make bench), e.g. a
+# baseline and the result of an optimization, printing the speedup of each
+# kernel for each lattice size and probability measured in both.
+#
+# usage: python compare_bench.py baseline.json current.json
+
+
+def load_bench(file_name):
+    with open(file_name) as f:
+        results = json.load(f)['results']
+    return {(r['kernel'], r['L'], r['p']): r for r in results}
+
+
+def compare_bench(baseline_file, current_file):
+    baseline = load_bench(baseline_file)
+    current = load_bench(current_file)
+    print('{:<30} {:>6} {:>8} {:>12} {:>12} {:>8}'.format(
+        'kernel', 'L', 'p', 'base ns/site', 'ns/site', 'speedup'))
+    for key, r in current.items():
+        if key not in baseline:
+            continue
+        b = baseline[key]
+        # the difference is only meaningful beyond the spread of both runs
+        noise = b['ns_per_site_stddev'] + r['ns_per_site_stddev']
+        mark = '' if abs(b['ns_per_site'] - r['ns_per_site']) > noise else ' ~'
+        print('{:<30} {:>6} {:>8} {:>12.3f} {:>12.3f} {:>8.2f}{}'.format(
+            key[0], key[1], key[2], b['ns_per_site'], r['ns_per_site'],
+            b['ns_per_site']/r['ns_per_site'] if r['ns_per_site'] > 0 else float('inf'),
+            mark))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        print('usage: python compare_bench.py baseline.json current.json')
+        sys.exit(1)
+    compare_bench(sys.argv[1], sys.argv[2])
@@ -0,0 +1,91 @@
+"""Thin ctypes wrapper around build/libpercolation.so (see percolation_api.h).
+
+Lattices are numpy int32 arrays of shape (count, rows, columns) (or a single
+(rows, columns) lattice) that are passed to the library without copying.
+Build the library first with `make library`.
+"""
+import os
+import ctypes
+import numpy as np
+
+API_VERSION = 1
+
+_lattices = np.ctypeslib.ndpointer(dtype=np.int32, flags='C_CONTIGUOUS')
+_int8_array = np.ctypeslib.ndpointer(dtype=np.int8, flags='C_CONTIGUOUS')
+
+
+def _load_library(path=None):
+    if path is None:
+        path = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                            '..', 'build', 'libpercolation.so')
+    library = ctypes.CDLL(path)
+    library.percolation_api_version.restype = ctypes.c_int
+    library.percolation_api_version.argtypes = []
+    library.percolation_seed.restype = None
+    library.percolation_seed.argtypes = [ctypes.c_uint64, ctypes.c_uint64]
+    library.percolation_populate.restype = None
+    library.percolation_populate.argtypes = [_lattices, ctypes.c_int, ctypes.c_int,
+                                             ctypes.c_int, ctypes.c_double]
+    library.percolation_label.restype = None
+    library.percolation_label.argtypes = [_lattices, ctypes.c_int, ctypes.c_int,
+                                          ctypes.c_int]
+    library.percolation_percolates.restype = ctypes.c_int
+    library.percolation_percolates.argtypes = [_lattices, ctypes.c_int, ctypes.c_int,
+                                               ctypes.c_int, _int8_array]
+    library.percolation_cluster_statistics.restype = ctypes.c_int
+    library.percolation_cluster_statistics.argtypes = [_lattices, ctypes.c_int,
+                                                       ctypes.c_int, ctypes.c_int,
+                                                       _lattices, _lattices, _lattices]
+    if library.percolation_api_version() != API_VERSION:
+        raise ImportError('{} implements a different interface version'.format(path))
+    return library
+
+
+_library = _load_library()
+
+
+def _shape(lattices):
+    if lattices.ndim == 2:
+        return 1, lattices.shape[0], lattices.shape[1]
+    return lattices.shape
+
+
+def new_lattices(count, L, columns=None):
+    """Allocate count empty lattices of L x columns (square by default)."""
+    return np.zeros((count, L, L if columns is None else columns), dtype=np.int32)
+
+
+def seed(value, stream=0):
+    _library.percolation_seed(value, stream)
+
+
+def populate(lattices, probability):
+    count, rows, columns = _shape(lattices)
+    _library.percolation_populate(lattices, count, rows, columns, probability)
+    return lattices
+
+
+def label(lattices):
+    count, rows, columns = _shape(lattices)
+    _library.percolation_label(lattices, count, rows, columns)
+    return lattices
+
+
+def percolates(lattices):
+    """Return a boolean array telling which labeled lattices percolate."""
+    count, rows, columns = _shape(lattices)
+    percolated = np.empty(count, dtype=np.int8)
+    _library.percolation_percolates(lattices, count, rows, columns, percolated)
+    return percolated.astype(bool)
+
+
+def cluster_statistics(lattices):
+    """Return the cluster sizes, counts and percolating counts aggregated over
+    a batch of labeled lattices."""
+    count, rows, columns = _shape(lattices)
+    sizes = np.empty(rows*columns, dtype=np.int32)
+    counts = np.empty(rows*columns, dtype=np.int32)
+    percolated = np.empty(rows*columns, dtype=np.int32)
+    n = _library.percolation_cluster_statistics(lattices, count, rows, columns,
+                                                sizes, counts, percolated)
+    return sizes[:n], counts[:n], percolated[:n]
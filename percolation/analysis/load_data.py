@@ -1,28 +1,336 @@
+import os
 import re
 import glob
 from operator import itemgetter
 import numpy as np
 
-## %% Load Files %% ##
+## %% Binary Files %% ##
 
-# % Cluster statistics % #
-def get_cluster_statistics_file_list(path, L=None, p_occupation=None):
-    files_full_path = path + '/clusters_*'
+# header of the binary output files (see binary_file_header in io_helpers.h)
+BINARY_HEADER_V1_DTYPE = np.dtype([('magic', 'S8'), ('kind', 'i4'), ('rows', 'i4'),
+                                   ('columns', 'i4'), ('seed', 'u4'), ('date', 'i8'),
+                                   ('length', 'i8'), ('probability', 'f8'),
+                                   ('grid_center', 'f8'), ('grid_decay', 'f8'),
+                                   ('start_probability', 'f8'), ('realizations', 'i4'),
+                                   ('grid_npoints', 'i4'), ('number_trials', 'i4'),
+                                   ('precision', 'i4'), ('bins_per_decade', 'i4'),
+                                   ('exact_sizes', 'i4'), ('source', 'S32')])
+BINARY_HEADER_DTYPE = np.dtype(BINARY_HEADER_V1_DTYPE.descr +
+                               [('depth', 'i4'), ('lattice', 'S16'),
+                                ('reserved', 'V12')])
+
+# data columns stored after the header for each kind of file
+BINARY_COLUMNS = {
+    1: [('lattice', 'i4')],
+    2: [('size', 'i4'), ('count', 'i4'), ('percolated', 'i4')],
+    3: [('critical_probability', 'f8')],
+    4: [('p_occupation', 'f8'), ('n_percolation', 'i4'), ('nsamples', 'i4')],
+    5: [('mass', 'u8'), ('window_size', 'i4')],
+    6: [('p_occupation', 'f8'), ('nsamples', 'i4'),
+        ('mean_cluster_size', 'f8'), ('mean_cluster_size_variance', 'f8'),
+        ('second_moment', 'f8'), ('second_moment_variance', 'f8'),
+        ('strength', 'f8'), ('strength_variance', 'f8')],
+    7: [('size', 'i4'), ('count', 'i4'), ('radius_gyration_squared', 'f8'),
+        ('extent', 'f8')],
+    8: [('radius', 'i4'), ('connected_pairs', 'f8'), ('site_pairs', 'f8')],
+    9: [('critical_probability', 'f8')],
+    10: [('critical_probability', 'f8')],
+}
+
+
+def load_binary_file(file_name):
+    """Memory-map a binary output file.
+
+    Returns the header (as a numpy record) and a dict with the data columns,
+    which are read-only views of the mapped file (no data is copied).
+    """
+    data = np.memmap(file_name, dtype=np.uint8, mode='r')
+    magic = bytes(data[:8])
+    if magic == b'PERCBIN2':
+        header = data[:BINARY_HEADER_DTYPE.itemsize].view(BINARY_HEADER_DTYPE)[0]
+        offset = BINARY_HEADER_DTYPE.itemsize
+    elif magic == b'PERCBIN1':
+        # older files have no depth nor lattice: they are left empty
+        old_header = data[:BINARY_HEADER_V1_DTYPE.itemsize].view(BINARY_HEADER_V1_DTYPE)[0]
+        header = np.zeros((), dtype=BINARY_HEADER_DTYPE)
+        for name in BINARY_HEADER_V1_DTYPE.names:
+            header[name] = old_header[name]
+        header = header[()]
+        offset = BINARY_HEADER_V1_DTYPE.itemsize
+    else:
+        raise ValueError('{} is not a binary output file'.format(file_name))
+    length = int(header['length'])
+    columns = {}
+    for name, dtype in BINARY_COLUMNS[int(header['kind'])]:
+        nbytes = length*np.dtype(dtype).itemsize
+        columns[name] = data[offset:offset + nbytes].view(dtype)
+        offset += nbytes
+    return header, columns
+
+
+def load_profile(file_name):
+    """Read the time spent in each phase from the header of a csv file
+    written with the --profile option.
+
+    Returns a dict mapping each phase to a dict with its seconds (and cycles,
+    cache_misses and branch_misses if hardware counters were measured).
+    """
+    profile = {}
+    with open(file_name) as f:
+        for line in f:
+            if not line.startswith(';'):
+                break
+            m = re.match(r';profile_(?P<phase>[a-z]+)_(?P<quantity>\w+):(?P<value>\S+)', line)
+            if m:
+                profile.setdefault(m.group('phase'), {})[m.group('quantity')] = float(m.group('value'))
+    return profile
+
+
+def load_csv_header_value(file_name, key):
+    """Read the value of a ;key:value header line of a csv file (None if the
+    file has no such line).
+    """
+    with open(file_name) as f:
+        for line in f:
+            if not line.startswith(';'):
+                break
+            if line.startswith(';' + key + ':'):
+                return line.split(':', 1)[1].strip()
+    return None
+
+
+def load_depth(file_name):
+    """Read the number of planes of the cubic lattices a file describes, from
+    its binary header or its ;depth: csv header line (0 for square
+    lattices).
+    """
+    if file_name.endswith('.bin'):
+        header, _ = load_binary_file(file_name)
+        return int(header['depth'])
+    value = load_csv_header_value(file_name, 'depth')
+    return int(value) if value else 0
+
+
+def load_lattice(file_name):
+    """Read the kind of lattice a file describes (such as triangular,
+    honeycomb or bond), from its binary header or its ;lattice: csv header
+    line ('' for square site lattices).
+    """
+    if file_name.endswith('.bin'):
+        header, _ = load_binary_file(file_name)
+        return header['lattice'].decode()
+    value = load_csv_header_value(file_name, 'lattice')
+    return value if value else ''
+
+
+def file_list_pattern(path, prefix, L, p_occupation, extension, lattice=None, depth=None):
+    files_full_path = path + '/' + prefix + '_'
+    if lattice:
+        files_full_path += lattice + '_'
     if L:
-        files_full_path += '{}x{}_*'.format(L, L)
+        files_full_path += '{}x{}'.format(L, L)
+        if depth:
+            files_full_path += 'x{}'.format(depth)
+        files_full_path += '_*'
+    else:
+        files_full_path += '*'
     if p_occupation:
         if type(p_occupation) == type(''):
             files_full_path += '{}*'.format(p_occupation)
         else:
             files_full_path += '{:e}*'.format(p_occupation)
-    files_full_path += '.csv'
+    files_full_path += '.' + extension
+    return files_full_path
+
+
+def file_list(path, prefix, L=None, p_occupation=None, extension='csv', lattice=None,
+              depth=None):
+    """Files written with the given prefix for square lattices of side L (any
+    if None), or for the given kind of lattice (e.g. 'triangular' or 'bond')
+    and depth of cubic lattices; files of other lattices are left out.
+    """
+    name = re.escape(prefix) + '_'
+    if lattice:
+        name += re.escape(lattice) + '_'
+    name += r'\d+x\d+'
+    if depth:
+        name += 'x{}'.format(depth)
+    name = re.compile(name + r'_\d+_')
+    files = glob.glob(file_list_pattern(path, prefix, L, p_occupation, extension, lattice, depth))
+    return [f for f in files if name.match(os.path.basename(f))]
+
+
+# % Sweep containers % #
+
+# headers of the sweep container files (see container.h)
+CONTAINER_HEADER_DTYPE = np.dtype([('magic', 'S8'), ('rows', 'i4'), ('columns', 'i4'),
+                                   ('seed', 'u4'), ('grid_npoints', 'i4'),
+                                   ('grid_center', 'f8'), ('grid_decay', 'f8'),
+                                   ('date', 'i8'), ('bins_per_decade', 'i4'),
+                                   ('exact_sizes', 'i4'), ('reserved', 'S8')])
+
+CONTAINER_RECORD_DTYPE = np.dtype([('magic', 'S4'), ('index', 'i4'), ('probability', 'f8'),
+                                   ('realizations', 'i4'), ('length', 'i4'),
+                                   ('percolation_count', 'i4'), ('reserved', 'i4')])
+
+
+def get_container_file_list(path, L=None):
+    files_full_path = path + '/sweep_*'
+    if L:
+        files_full_path += '{}x{}_*'.format(L, L)
+    files_full_path += '.pcc'
     return glob.glob(files_full_path)
 
 
+def load_container_file(file_name):
+    """Memory-map a sweep container, which may still be being written.
+
+    Returns the header and a list with one record (dict) per grid point,
+    ordered by index; the columns are zero-copy views of the mapped file.
+    """
+    data = np.memmap(file_name, dtype=np.uint8, mode='r')
+    header = data[:CONTAINER_HEADER_DTYPE.itemsize].view(CONTAINER_HEADER_DTYPE)[0]
+    if header['magic'] != b'PERCCTR1':
+        raise ValueError('{} is not a sweep container'.format(file_name))
+    records = {}
+    offset = CONTAINER_HEADER_DTYPE.itemsize
+    while offset + CONTAINER_RECORD_DTYPE.itemsize <= data.size:
+        record = data[offset:offset + CONTAINER_RECORD_DTYPE.itemsize].view(CONTAINER_RECORD_DTYPE)[0]
+        if record['magic'] != b'REC1' or record['length'] < 0:
+            raise ValueError('{} has a corrupt record at byte {}'.format(file_name, offset))
+        length = int(record['length'])
+        offset += CONTAINER_RECORD_DTYPE.itemsize
+        # the last record may not be completely written yet
+        if offset + 3*4*length > data.size:
+            break
+        columns = data[offset:offset + 3*4*length].view('i4').reshape(3, length)
+        offset += 3*4*length
+        records[int(record['index'])] = {'probability': float(record['probability']),
+                                         'realizations': int(record['realizations']),
+                                         'percolation_count': int(record['percolation_count']),
+                                         'size': columns[0], 'count': columns[1],
+                                         'percolated': columns[2]}
+    return header, [records[index] for index in sorted(records)]
+
+
+def load_container_cluster_statistics(file_name):
+    header, records = load_container_file(file_name)
+    size = []
+    count = []
+    percolated = []
+    for record in records:
+        idx = np.argsort(record['size'])
+        record_size, record_count, record_percolated = \
+            unbin_cluster_sizes(record['size'][idx], record['count'][idx] / record['realizations'],
+                                record['percolated'][idx], int(header['bins_per_decade']),
+                                int(header['exact_sizes']))
+        size.append(record_size)
+        count.append(record_count)
+        percolated.append(record_percolated)
+    L = np.array([int(header['rows'])]*len(records))
+    p_occupation = np.array([record['probability'] for record in records])
+    nrealizations = np.array([record['realizations'] for record in records])
+    return size, count, percolated, L, p_occupation, nrealizations
+
+
+CORPUS_HEADER_DTYPE = np.dtype([('magic', 'S8'), ('rows', 'i4'), ('columns', 'i4'),
+                                ('seed', 'u4'), ('with_labels', 'i4'), ('count', 'i8'),
+                                ('index_offset', 'i8'), ('reserved', 'S24')])
+
+
+def load_corpus_file(file_name):
+    """Memory-map a lattice corpus.
+
+    Returns the header, the offset of each realization and the mapped data,
+    to be used with load_corpus_lattice.
+    """
+    data = np.memmap(file_name, dtype=np.uint8, mode='r')
+    header = data[:CORPUS_HEADER_DTYPE.itemsize].view(CORPUS_HEADER_DTYPE)[0]
+    if header['magic'] != b'PERCCRP1':
+        raise ValueError('{} is not a lattice corpus'.format(file_name))
+    words = (int(header['rows'])*int(header['columns']) + 63) // 64
+    if header['index_offset'] > 0:
+        start = int(header['index_offset'])
+        offsets = data[start:start + 8*int(header['count'])].view('i8')
+    else:
+        # the corpus was not closed; scan its records
+        offsets = []
+        offset = CORPUS_HEADER_DTYPE.itemsize
+        while offset + 16 <= data.size:
+            labels_size = int(data[offset + 8:offset + 16].view('i8')[0])
+            size = 16 + 8*words + labels_size + (-labels_size) % 8
+            if offset + size > data.size:
+                break
+            offsets.append(offset)
+            offset += size
+        offsets = np.array(offsets, dtype='i8')
+    return header, offsets, data
+
+
+def load_corpus_lattice(corpus, k):
+    """Return the probability and occupancy (boolean rows x columns array) of
+    realization k of a corpus loaded with load_corpus_file."""
+    header, offsets, data = corpus
+    rows = int(header['rows'])
+    columns = int(header['columns'])
+    offset = int(offsets[k])
+    probability = float(data[offset:offset + 8].view('f8')[0])
+    words = (rows*columns + 63) // 64
+    bits = np.unpackbits(data[offset + 16:offset + 16 + 8*words], bitorder='little')
+    return probability, bits[:rows*columns].reshape(rows, columns).astype(bool)
+
+
+## %% Load Files %% ##
+
+# % Cluster statistics % #
+def unbin_cluster_sizes(size, count, percolated, bins_per_decade, exact_sizes):
+    """Turn logarithmically binned cluster statistics (see cluster_size_bin in
+    clusters.h) into per size values comparable with the exact ones.
+
+    size holds the smallest size of every bin; each bin is represented by its
+    geometric center and its counts are divided by its width. Empty bins are
+    dropped.
+    """
+    if bins_per_decade <= 0 or size.size == 0:
+        return size, count, percolated
+    last = size.size - 1
+    if last < exact_sizes:
+        upper = size[-1] + 1
+    else:
+        upper = int(np.ceil(exact_sizes*10**((last + 1 - exact_sizes)/bins_per_decade)))
+    edges = np.append(size, max(upper, size[-1] + 1))
+    width = np.diff(edges)
+    center = np.sqrt(edges[:-1]*(edges[1:] - 1))
+    idx = np.where(count > 0)[0]
+    return center[idx], count[idx]/width[idx], percolated[idx]
+
+
+def get_cluster_statistics_file_list(path, L=None, p_occupation=None, extension='csv', lattice=None,
+                                     depth=None):
+    return file_list(path, 'clusters', L, p_occupation, extension, lattice, depth)
+
+
+def load_cluster_statistics_binary_file(file_name):
+    header, columns = load_binary_file(file_name)
+    nrealizations = int(header['realizations'])
+    idx = np.argsort(columns['size'])
+    size, count, percolated = unbin_cluster_sizes(columns['size'][idx],
+                                                  columns['count'][idx] / nrealizations,
+                                                  columns['percolated'][idx],
+                                                  int(header['bins_per_decade']),
+                                                  int(header['exact_sizes']))
+    return size, count, percolated, int(header['rows']), \
+        float(header['probability']), nrealizations
+
+
 def load_cluster_statistics_file(file_name):
+    if file_name.endswith('.bin'):
+        return load_cluster_statistics_binary_file(file_name)
     L = 0
     p_occupation = 0
     nrealizations = 0
+    bins_per_decade = 0
+    exact_sizes = 0
     size = []
     count = []
     percolated = []
@@ -37,6 +345,10 @@ def load_cluster_statistics_file(file_name):
             elif line.startswith(';realizations'):
                 m = re.search(r';realizations:(?P<L>\d+)', line)
                 nrealizations = int(m.group(1))
+            elif line.startswith(';bins_per_decade'):
+                bins_per_decade = int(line.split(':')[1])
+            elif line.startswith(';exact_sizes'):
+                exact_sizes = int(line.split(':')[1])
             elif not line.startswith(';'):
                 columns = line.split(',')
                 size.append(int(columns[0]))
@@ -46,7 +358,9 @@ def load_cluster_statistics_file(file_name):
     count = np.asarray(count) / nrealizations
     percolated = np.asarray(percolated)
     idx = np.argsort(size)
-    return size[idx], count[idx], percolated[idx], L, p_occupation, nrealizations
+    size, count, percolated = unbin_cluster_sizes(size[idx], count[idx], percolated[idx],
+                                                  bins_per_decade, exact_sizes)
+    return size, count, percolated, L, p_occupation, nrealizations
 
 
 def load_cluster_statistics_file_list(files):
@@ -62,20 +376,21 @@ def load_cluster_statistics_file_list(files):
 
 
 # % Probability Sweep % #
-def get_probability_sweep_file_list(path, L=None, p_occupation=None):
-    files_full_path = path + '/percolation_probability_*'
-    if L:
-        files_full_path += '{}x{}_*'.format(L, L)
-    if p_occupation:
-        if type(p_occupation) == type(''):
-            files_full_path += '{}*'.format(p_occupation)
-        else:
-            files_full_path += '{:e}*'.format(p_occupation)
-    files_full_path += '.csv'
-    return glob.glob(files_full_path)
+def get_probability_sweep_file_list(path, L=None, p_occupation=None, extension='csv', lattice=None,
+                                    depth=None):
+    return file_list(path, 'percolation_probability', L, p_occupation, extension, lattice, depth)
+
+
+def load_probability_sweep_binary_file(file_name):
+    header, columns = load_binary_file(file_name)
+    p_percolation = columns['n_percolation'] / columns['nsamples']
+    return columns['p_occupation'], p_percolation, columns['n_percolation'], \
+        columns['nsamples'], int(header['rows'])
 
 
 def load_probability_sweep_file(file_name):
+    if file_name.endswith('.bin'):
+        return load_probability_sweep_binary_file(file_name)
     L = 0
     p_occupation = []
     n_percolation = []
@@ -118,16 +433,123 @@ def load_probability_sweep_file_list(files):
     return p_occupation, p_percolation, n_percolation, nsamples, L
 
 
+# % Observables % #
+OBSERVABLES_FIELDS = [name for name, _ in BINARY_COLUMNS[6]]
+
+
+def get_observables_file_list(path, L=None, extension='csv', lattice=None, depth=None):
+    return file_list(path, 'percolation_observables', L, None, extension, lattice, depth)
+
+
+def load_observables_file(file_name):
+    """Return a dict with one array per column (see OBSERVABLES_FIELDS) of
+    the observables of a sweep, plus the standard error of the mean of each
+    observable and the lattice size L."""
+    if file_name.endswith('.bin'):
+        header, columns = load_binary_file(file_name)
+        data = {name: np.asarray(columns[name]) for name in OBSERVABLES_FIELDS}
+        L = int(header['rows'])
+    else:
+        L = 0
+        values = np.loadtxt(file_name, delimiter=',', comments=';', ndmin=2)
+        data = {name: values[:, i] for i, name in enumerate(OBSERVABLES_FIELDS)}
+        with open(file_name) as f:
+            for line in f:
+                if line.startswith(';rows'):
+                    L = int(line.split(':')[1])
+                    break
+    for name in ['mean_cluster_size', 'second_moment', 'strength']:
+        data[name + '_error'] = np.sqrt(data[name + '_variance'] / data['nsamples'])
+    data['L'] = L
+    return data
+
+
+# % Radius of gyration % #
+def get_gyration_file_list(path, L=None, p_occupation=None, extension='csv', lattice=None,
+                           depth=None):
+    return file_list(path, 'gyration', L, p_occupation, extension, lattice, depth)
+
+
+def load_gyration_file(file_name):
+    """Return the cluster sizes (or smallest size of each bin), the number of
+    finite clusters of each size, their mean squared radius of gyration and
+    mean extent, L and the occupation probability."""
+    if file_name.endswith('.bin'):
+        header, columns = load_binary_file(file_name)
+        size, count = columns['size'], columns['count']
+        radius_gyration_squared, extent = columns['radius_gyration_squared'], columns['extent']
+        L, p_occupation = int(header['rows']), float(header['probability'])
+    else:
+        L = 0
+        p_occupation = 0
+        with open(file_name) as f:
+            for line in f:
+                if line.startswith(';rows'):
+                    L = int(line.split(':')[1])
+                elif line.startswith(';probability'):
+                    p_occupation = float(line.split(':')[1])
+        values = np.loadtxt(file_name, delimiter=',', comments=';', ndmin=2)
+        size, count = values[:, 0].astype(int), values[:, 1].astype(int)
+        radius_gyration_squared, extent = values[:, 2], values[:, 3]
+    return size, count, radius_gyration_squared / count, extent / count, L, p_occupation
+
+
+# % Pair connectivity % #
+def get_pair_connectivity_file_list(path, L=None, p_occupation=None, extension='csv', lattice=None,
+                                    depth=None):
+    return file_list(path, 'pair_connectivity', L, p_occupation, extension, lattice, depth)
+
+
+def load_pair_connectivity_file(file_name):
+    """Return the distances r, the pair connectivity g(r), L and the
+    occupation probability."""
+    if file_name.endswith('.bin'):
+        header, columns = load_binary_file(file_name)
+        radius, connected_pairs, site_pairs = \
+            columns['radius'], columns['connected_pairs'], columns['site_pairs']
+        L, p_occupation = int(header['rows']), float(header['probability'])
+        nrealizations = int(header['realizations'])
+    else:
+        with open(file_name) as f:
+            for line in f:
+                if line.startswith(';rows'):
+                    L = int(line.split(':')[1])
+                elif line.startswith(';probability'):
+                    p_occupation = float(line.split(':')[1])
+                elif line.startswith(';nrealizations'):
+                    nrealizations = int(line.split(':')[1])
+        values = np.loadtxt(file_name, delimiter=',', comments=';', ndmin=2)
+        radius, connected_pairs, site_pairs = values[:, 0].astype(int), values[:, 1], values[:, 2]
+    return radius, connected_pairs / (site_pairs * nrealizations), L, p_occupation
+
+
 # % Bisection Search % #
-def get_bisection_critical_search_file_list(path, L=None):
-    files_full_path = path + '/critical_bisection_search_*'
+def get_bisection_critical_search_file_list(path, L=None, extension='csv', lattice=None):
+    return file_list(path, 'critical_bisection_search', L, None, extension, lattice)
+
+
+# gradient and invasion percolation files have the same layout, so the
+# bisection search loaders below read them as well
+def get_gradient_critical_file_list(path, L=None, extension='csv'):
+    files_full_path = path + '/critical_gradient_*'
     if L:
-        files_full_path += '{}x{}*'.format(L, L)
-    files_full_path += '.csv'
+        files_full_path += '{}x*'.format(L)
+    files_full_path += '.' + extension
     return glob.glob(files_full_path)
 
 
+def get_invasion_critical_file_list(path, L=None, extension='csv'):
+    return file_list(path, 'critical_invasion', L, None, extension)
+
+
+def load_bisection_critical_search_binary_file(file_name):
+    header, columns = load_binary_file(file_name)
+    return columns['critical_probability'], int(header['rows']), int(header['number_trials'])
+
+
 def load_bisection_critical_search_file(file_name):
+    if file_name.endswith('.bin'):
+        return load_bisection_critical_search_binary_file(file_name)
     L = 0
     ntrials = 0
     critical_probability = []
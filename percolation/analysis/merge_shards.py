@@ -0,0 +1,177 @@
+import os
+import re
+import sys
+import glob
+import time
+from collections import OrderedDict
+
+# Merge the outputs of a probability sweep or bisection search split in shards
+# (see the --shard option of the programs) into a single result equivalent to
+# one run with all the repetitions of the shards. Only csv results
+# (--format=csv, the default) are merged.
+#
+# usage: python merge_shards.py output_path shard_path [shard_path ...]
+
+
+## %% Read/Write Files %% ##
+
+def read_file(file_name):
+    header = []
+    rows = []
+    with open(file_name) as f:
+        for line in f:
+            if line.startswith(';'):
+                key, _, value = line[1:].rstrip('\n').partition(':')
+                header.append([key, value])
+            elif line.strip():
+                rows.append(line.rstrip('\n').split(','))
+    return header, rows
+
+
+def write_file(file_name, header, rows):
+    with open(file_name, 'w') as f:
+        for key, value in header:
+            if key == 'date':
+                value = time.asctime()
+            f.write(';{}:{}\n'.format(key, value))
+        for row in rows:
+            f.write(','.join(row) + '\n')
+
+
+def set_header_value(header, key, value):
+    for entry in header:
+        if entry[0] == key:
+            entry[1] = value
+
+
+def format_double(x):
+    return '{:.14e}'.format(x)
+
+
+## %% Merge %% ##
+
+# % Cluster statistics % #
+def merge_cluster_statistics(files):
+    header, _ = read_file(files[0])
+    realizations = 0
+    statistics = OrderedDict()
+    for file_name in files:
+        file_header, rows = read_file(file_name)
+        realizations += int(dict(file_header)['realizations'])
+        for size, count, percolated in rows:
+            total = statistics.setdefault(int(size), [0, 0])
+            total[0] += int(count)
+            total[1] += int(percolated)
+    set_header_value(header, 'realizations', str(realizations))
+    rows = [[str(size), str(count), str(percolated)]
+            for size, (count, percolated) in sorted(statistics.items())]
+    return header, rows
+
+
+# % Probability Sweep % #
+def merge_percolation_probability(files):
+    header, rows = read_file(files[0])
+    n_percolation = [0]*len(rows)
+    nsamples = [0]*len(rows)
+    for file_name in files:
+        _, file_rows = read_file(file_name)
+        if len(file_rows) != len(rows) or \
+           any(float(a[0]) != float(b[0]) for a, b in zip(rows, file_rows)):
+            raise ValueError('shards of {} have different grids'.format(file_name))
+        for i, row in enumerate(file_rows):
+            n_percolation[i] += int(row[1])
+            nsamples[i] += int(row[2])
+    rows = [[row[0], str(n_percolation[i]), str(nsamples[i]),
+             format_double(n_percolation[i]/nsamples[i])]
+            for i, row in enumerate(rows)]
+    return header, rows
+
+
+# % Observables % #
+def merge_observables(files):
+    # means and variances of each shard are combined with the pairwise
+    # update of Chan et al.
+    header, rows = read_file(files[0])
+    nsamples = [0]*len(rows)
+    moments = [[[0.0, 0.0] for _ in range(3)] for _ in rows]
+    for file_name in files:
+        _, file_rows = read_file(file_name)
+        if len(file_rows) != len(rows) or \
+           any(float(a[0]) != float(b[0]) for a, b in zip(rows, file_rows)):
+            raise ValueError('shards of {} have different grids'.format(file_name))
+        for i, row in enumerate(file_rows):
+            n = int(row[1])
+            total = nsamples[i] + n
+            if n == 0:
+                continue
+            for k in range(3):
+                mean = float(row[2 + 2*k])
+                sum_squares = float(row[3 + 2*k])*(n - 1)
+                delta = mean - moments[i][k][0]
+                moments[i][k][1] += sum_squares + delta*delta*nsamples[i]*n/total
+                moments[i][k][0] += delta*n/total
+            nsamples[i] = total
+    merged = []
+    for i, row in enumerate(rows):
+        merged_row = [row[0], str(nsamples[i])]
+        for mean, sum_squares in moments[i]:
+            variance = sum_squares/(nsamples[i] - 1) if nsamples[i] > 1 else 0
+            merged_row += [format_double(mean), format_double(variance)]
+        merged.append(merged_row)
+    return header, merged
+
+
+# % Bisection Search % #
+def merge_bisection_critical_search(files):
+    header, _ = read_file(files[0])
+    rows = []
+    for file_name in files:
+        rows += read_file(file_name)[1]
+    set_header_value(header, 'ntrials', str(len(rows)))
+    return header, rows
+
+
+bisection_name = re.compile(r'critical_bisection_search_((?:[a-z]+_)?\d+x\d+(?:x\d+)?)_\d+_')
+
+
+def merge_shards(output_path, shard_paths):
+    groups = OrderedDict()
+    for shard_path in shard_paths:
+        if glob.glob(shard_path + '/*.bin'):
+            raise ValueError('{} has binary results; only shards written with '
+                             '--format=csv can be merged'.format(shard_path))
+        for file_name in sorted(glob.glob(shard_path + '/*.csv')):
+            base_name = os.path.basename(file_name)
+            # bisection results are named after the final seed of each shard,
+            # so they are grouped by lattice (e.g. bond_64x64) only
+            bisection = bisection_name.match(base_name)
+            if bisection:
+                key = ('critical_bisection_search', bisection.group(1))
+            else:
+                key = (None, base_name)
+            groups.setdefault(key, []).append(file_name)
+
+    for (kind, name), files in groups.items():
+        if len(files) != len(shard_paths):
+            print('WARNING: {} is missing from some shards'.format(name))
+        if kind == 'critical_bisection_search':
+            header, rows = merge_bisection_critical_search(files)
+            values = dict(header)
+            name = 'critical_bisection_search_{}_{}_{}.csv'.format(
+                name, values['seed'], format_double(len(rows)))
+        elif name.startswith('clusters_'):
+            header, rows = merge_cluster_statistics(files)
+        elif name.startswith('percolation_probability_'):
+            header, rows = merge_percolation_probability(files)
+        elif name.startswith('percolation_observables_'):
+            header, rows = merge_observables(files)
+        else:
+            continue
+        write_file(os.path.join(output_path, name), header, rows)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) < 3:
+        print('usage: python merge_shards.py output_path shard_path [shard_path ...]')
+        sys.exit(1)
+    merge_shards(sys.argv[1], sys.argv[2:])
@@ -0,0 +1,286 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+
+#define _POSIX_C_SOURCE 200809L
+
+/* headers */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "random.h"
+#include "lattice.h"
+#include "clusters.h"
+#include "math_extra.h"
+#include "cli.h"
+
+/* kernels measured, in the order they run on a lattice */
+enum bench_kernel {
+    BENCH_POPULATE,
+    BENCH_LABEL,
+    BENCH_PERCOLATES,
+    BENCH_STATISTICS,
+    BENCH_AGGREGATE,
+    BENCH_KERNELS
+};
+
+static const char * kernel_names[BENCH_KERNELS] = {
+    "populate_lattice",
+    "label_clusters",
+    "has_percolating_cluster",
+    "cluster_statistics",
+    "aggregate_cluster_statistics"
+};
+
+/* a batch of lattices of one size and probability, with everything the
+   kernels need as input prepared in advance */
+typedef struct {
+    int L;
+    int batch; /* number of lattices timed together */
+    double probability;
+    int * populated; /* populated (not labeled) lattices */
+    int * work; /* lattices the kernels operate on */
+    int * sizes_total_count; /* cluster statistics of each labeled lattice */
+    int ** sizes;
+    int ** sizes_counts;
+    int ** sizes_percolated;
+    int aggregated_total_count; /* statistics aggregated so far */
+    int * aggregated_sizes;
+    int * aggregated_counts;
+    int * aggregated_percolated;
+} bench_batch;
+
+static volatile int sink; /* keeps results of the kernels alive */
+
+static double elapsed_ns(const struct timespec * start, const struct timespec * end)
+{
+    return (end->tv_sec - start->tv_sec)*1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+static void free_batch_statistics(bench_batch * b)
+{
+    int k;
+
+    for (k = 0; k < b->batch; k++) {
+        free(b->sizes[k]);
+        free(b->sizes_counts[k]);
+        free(b->sizes_percolated[k]);
+        b->sizes[k] = NULL;
+        b->sizes_counts[k] = NULL;
+        b->sizes_percolated[k] = NULL;
+    }
+}
+
+/* restore the labeled lattices of the batch (not timed) */
+static void label_batch(bench_batch * b)
+{
+    int k;
+    int sites;
+
+    sites = b->L*b->L;
+    memcpy(b->work, b->populated, ((size_t)b->batch)*sites*sizeof(int));
+    for (k = 0; k < b->batch; k++) {
+        label_clusters(b->work + ((size_t)k)*sites, b->L, b->L);
+    }
+}
+
+/* time one run of a kernel over the whole batch, preparing its input first */
+static double run_sample(int kernel, bench_batch * b)
+{
+    int k;
+    int sites;
+    int result;
+    struct timespec start;
+    struct timespec end;
+
+    sites = b->L*b->L;
+    result = 0;
+
+    switch (kernel) {
+    case BENCH_LABEL:
+        memcpy(b->work, b->populated, ((size_t)b->batch)*sites*sizeof(int));
+        break;
+    case BENCH_STATISTICS:
+        free_batch_statistics(b);
+        break;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (k = 0; k < b->batch; k++) {
+        switch (kernel) {
+        case BENCH_POPULATE:
+            populate_lattice(b->probability, b->work + ((size_t)k)*sites, b->L, b->L, 0);
+            break;
+        case BENCH_LABEL:
+            label_clusters(b->work + ((size_t)k)*sites, b->L, b->L);
+            break;
+        case BENCH_PERCOLATES:
+            result += has_percolating_cluster(b->work + ((size_t)k)*sites, b->L, b->L);
+            break;
+        case BENCH_STATISTICS:
+            cluster_statistics(b->work + ((size_t)k)*sites, b->L, b->L,
+                               &b->sizes_total_count[k], &b->sizes[k],
+                               &b->sizes_counts[k], &b->sizes_percolated[k],
+                               NULL, NULL);
+            break;
+        case BENCH_AGGREGATE:
+            aggregate_cluster_statistics(b->sizes_total_count[k], b->sizes[k],
+                                         b->sizes_counts[k], b->sizes_percolated[k],
+                                         &b->aggregated_total_count,
+                                         &b->aggregated_sizes,
+                                         &b->aggregated_counts,
+                                         &b->aggregated_percolated);
+            break;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    sink += result;
+
+    return elapsed_ns(&start, &end);
+}
+
+/* parse a comma separated list of numbers into a newly allocated array */
+static double * parse_list(const char * text, int * count)
+{
+    char * copy;
+    char * token;
+    double * values;
+    int i;
+
+    *count = 1;
+    for (i = 0; text[i]; i++) {
+        *count += text[i] == ',';
+    }
+    values = (double *)malloc((*count)*sizeof(double));
+    copy = (char *)malloc(strlen(text) + 1);
+    strcpy(copy, text);
+    *count = 0;
+    for (token = strtok(copy, ","); token; token = strtok(NULL, ",")) {
+        values[(*count)++] = atof(token);
+    }
+    free(copy);
+
+    return values;
+}
+
+/* main body function */
+int main(int argc, char ** argv)
+{
+    static const char * default_sizes = "4,16,64,256,1024,4096,8192";
+    static const char * default_probabilities = "0.5,0.5927,0.7";
+    const char * option;
+    double * sizes; /* lattice sizes L to measure */
+    double * probabilities; /* occupation probabilities to measure */
+    int sizes_count;
+    int probabilities_count;
+    int warmup; /* untimed runs of each kernel before measuring */
+    int repetitions; /* timed runs of each kernel */
+    int batch_sites; /* small lattices are timed in batches of at least this many sites */
+    unsigned int random_seed;
+    bench_batch b;
+    running_moments moments;
+    double sample; /* ns per site of one timed run */
+    double minimum;
+    char first;
+    int i, j, kernel, n;
+
+    /* read optional arguments */
+    sizes = parse_list((option = extract_option(&argc, argv, "sizes")) ?
+                       option : default_sizes, &sizes_count);
+    probabilities = parse_list((option = extract_option(&argc, argv, "probabilities")) ?
+                               option : default_probabilities, &probabilities_count);
+    warmup = (option = extract_option(&argc, argv, "warmup")) ? atoi(option) : 2;
+    repetitions = (option = extract_option(&argc, argv, "repetitions")) ? atoi(option) : 10;
+    batch_sites = (option = extract_option(&argc, argv, "batch-sites")) ? atoi(option) : 1 << 16;
+    random_seed = (option = extract_option(&argc, argv, "seed")) ? atoi(option) : 1;
+    if (argc > 1 || repetitions < 1 || warmup < 0) {
+        printf("usage: [--sizes=L1,L2,...] [--probabilities=p1,p2,...] [--warmup=W]"
+               " [--repetitions=R] [--batch-sites=S] [--seed=SEED]\n");
+        return 1;
+    }
+
+    /* results are written to stdout as JSON, progress to stderr */
+    printf("{\n");
+    printf("  \"seed\": %u,\n", random_seed);
+    printf("  \"warmup\": %d,\n", warmup);
+    printf("  \"repetitions\": %d,\n", repetitions);
+    printf("  \"batch_sites\": %d,\n", batch_sites);
+    printf("  \"results\": [");
+    first = 1;
+
+    for (i = 0; i < sizes_count; i++) {
+        b.L = (int)sizes[i];
+        b.batch = batch_sites / (b.L*b.L) > 1 ? batch_sites / (b.L*b.L) : 1;
+        b.populated = (int *)malloc(((size_t)b.batch)*b.L*b.L*sizeof(int));
+        b.work = (int *)malloc(((size_t)b.batch)*b.L*b.L*sizeof(int));
+        b.sizes_total_count = (int *)calloc(b.batch, sizeof(int));
+        b.sizes = (int **)calloc(b.batch, sizeof(int *));
+        b.sizes_counts = (int **)calloc(b.batch, sizeof(int *));
+        b.sizes_percolated = (int **)calloc(b.batch, sizeof(int *));
+
+        for (j = 0; j < probabilities_count; j++) {
+            b.probability = probabilities[j];
+            srand_pcg(random_seed);
+            for (n = 0; n < b.batch; n++) {
+                populate_lattice(b.probability, b.populated + ((size_t)n)*b.L*b.L,
+                                 b.L, b.L, 0);
+            }
+            b.aggregated_total_count = 0;
+            b.aggregated_sizes = NULL;
+            b.aggregated_counts = NULL;
+            b.aggregated_percolated = NULL;
+
+            for (kernel = 0; kernel < BENCH_KERNELS; kernel++) {
+                fprintf(stderr, "L=%d p=%g %s\n", b.L, b.probability, kernel_names[kernel]);
+
+                /* the kernels after labeling need labeled lattices */
+                if (kernel == BENCH_PERCOLATES) {
+                    label_batch(&b);
+                }
+
+                memset(&moments, 0, sizeof(running_moments));
+                minimum = INFINITY;
+                for (n = 0; n < warmup + repetitions; n++) {
+                    sample = run_sample(kernel, &b) / (((double)b.batch)*b.L*b.L);
+                    if (n < warmup) {
+                        continue;
+                    }
+                    running_moments_add(&moments, sample);
+                    minimum = sample < minimum ? sample : minimum;
+                }
+
+                printf("%s\n    {\"kernel\": \"%s\", \"L\": %d, \"p\": %g, \"batch\": %d,"
+                       " \"repetitions\": %d, \"ns_per_site\": %.6g,"
+                       " \"ns_per_site_stddev\": %.6g, \"ns_per_site_min\": %.6g,"
+                       " \"sites_per_second\": %.6g}",
+                       first ? "" : ",", kernel_names[kernel], b.L, b.probability,
+                       b.batch, repetitions, moments.mean,
+                       sqrt(running_moments_variance(&moments)), minimum,
+                       moments.mean > 0 ? 1e9 / moments.mean : 0);
+                first = 0;
+            }
+
+            free_batch_statistics(&b);
+            free(b.aggregated_sizes);
+            free(b.aggregated_counts);
+            free(b.aggregated_percolated);
+        }
+
+        free(b.populated);
+        free(b.work);
+        free(b.sizes_total_count);
+        free(b.sizes);
+        free(b.sizes_counts);
+        free(b.sizes_percolated);
+    }
+
+    printf("\n  ]\n}\n");
+
+    free(sizes);
+    free(probabilities);
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+/* see header file for detailed documentation of each function */
+
+#include "bonds.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "random.h"
+#include "lattice.h"
+
+/* whether the bond at a given row and column of a bit-packed array is open */
+#define BOND_OPEN(bits, words, row, column) \
+    (((bits)[(row)*(words) + ((column) >> 6)] >> ((column) & 63)) & 1)
+
+bond_lattice * allocate_bond_lattice(int rows, int columns)
+{
+    bond_lattice * bonds;
+
+    bonds = (bond_lattice *)malloc(sizeof(bond_lattice));
+    bonds->rows = rows;
+    bonds->columns = columns;
+    bonds->words = (columns + 63)/64;
+    bonds->horizontal = (uint64_t *)allocate_aligned(((long)rows)*bonds->words*sizeof(uint64_t));
+    bonds->vertical = (uint64_t *)allocate_aligned(((long)rows)*bonds->words*sizeof(uint64_t));
+    memset(bonds->horizontal, 0, ((long)rows)*bonds->words*sizeof(uint64_t));
+    memset(bonds->vertical, 0, ((long)rows)*bonds->words*sizeof(uint64_t));
+
+    return bonds;
+}
+
+void free_bond_lattice(bond_lattice * bonds)
+{
+    if (!bonds) {
+        return;
+    }
+
+    free(bonds->horizontal);
+    free(bonds->vertical);
+    free(bonds);
+}
+
+/* 64 bonds, each open with the probability whose first 32 binary digits
+   are given: a bond is open when the uniform number drawn for it is below
+   the probability, which is known at the first digit where they differ;
+   when nested, all 32 digits are drawn even if every bond is decided */
+static uint64_t draw_bond_word(uint32_t digits, char nested)
+{
+    int d;
+    uint64_t random_bits;
+    uint64_t undecided;
+    uint64_t open;
+
+    undecided = ~(uint64_t)0;
+    open = 0;
+    for (d = 31; d >= 0 && (undecided || nested); d--) {
+        random_bits = ((uint64_t)rand_pcg() << 32) | rand_pcg();
+        if ((digits >> d) & 1) {
+            open |= undecided & ~random_bits;
+            undecided &= random_bits;
+        } else {
+            undecided &= ~random_bits;
+        }
+    }
+
+    /* the bonds still undecided drew the probability itself (up to 32
+       digits), and are left closed */
+    return open;
+}
+
+/* open the bonds of an array with the given binary digits of the
+   probability, except those past the last valid row or column */
+static void populate_bond_array(uint64_t * bits, int rows, int valid_rows,
+                                int valid_columns, int words, uint32_t digits,
+                                char all_open, char nested)
+{
+    int i;
+    int w;
+    uint64_t last_word; /* valid bonds of the last word of each row */
+
+    last_word = valid_columns % 64 ? (((uint64_t)1) << (valid_columns % 64)) - 1 : ~(uint64_t)0;
+    for (i = 0; i < rows; i++) {
+        for (w = 0; w < words; w++) {
+            if (i >= valid_rows || 64*w >= valid_columns) {
+                bits[i*words + w] = 0;
+            } else if (all_open) {
+                if (nested) {
+                    /* the same random numbers as at any other probability */
+                    draw_bond_word(digits, nested);
+                }
+                bits[i*words + w] = ~(uint64_t)0;
+            } else {
+                bits[i*words + w] = draw_bond_word(digits, nested);
+            }
+        }
+        if (i < valid_rows && valid_columns > 0) {
+            bits[i*words + (valid_columns - 1)/64] &= last_word;
+        }
+    }
+}
+
+/* open the bonds of both arrays; see populate_bonds */
+static void populate_bond_arrays(double probability, bond_lattice * bonds,
+                                 unsigned int seed, char nested)
+{
+    uint32_t digits; /* first 32 binary digits of the probability */
+    char all_open;
+
+    if (seed > 0) {
+        srand_pcg(seed);
+    }
+
+    all_open = probability >= 1;
+    digits = 0;
+    if (probability > 0 && probability < 1) {
+        digits = ldexp(probability, 32) < UINT32_MAX ? (uint32_t)ldexp(probability, 32) : UINT32_MAX;
+    }
+
+    populate_bond_array(bonds->horizontal, bonds->rows, bonds->rows, bonds->columns - 1,
+                        bonds->words, digits, all_open, nested);
+    populate_bond_array(bonds->vertical, bonds->rows, bonds->rows - 1, bonds->columns,
+                        bonds->words, digits, all_open, nested);
+}
+
+void populate_bonds(double probability, bond_lattice * bonds, unsigned int seed)
+{
+    populate_bond_arrays(probability, bonds, seed, 0);
+}
+
+void populate_bonds_nested(double probability, bond_lattice * bonds, unsigned int seed)
+{
+    populate_bond_arrays(probability, bonds, seed, 1);
+}
+
+static int find_site(int * parents, int site)
+{
+    while (parents[site] != site) {
+        parents[site] = parents[parents[site]];
+        site = parents[site];
+    }
+    return site;
+}
+
+void label_bond_clusters(const bond_lattice * bonds, int * lattice)
+{
+    int i;
+    int j;
+    int k;
+    int rows;
+    int columns;
+    int root_a;
+    int root_b;
+    int label;
+    int * parents; /* union-find forest of the sites */
+
+    rows = bonds->rows;
+    columns = bonds->columns;
+    parents = (int *)allocate_aligned((((long)rows)*columns + 1)*sizeof(int));
+
+    /* join each site with its left and upper neighbors across open bonds;
+       the smallest site is kept as root, so each root is the first site of
+       its cluster */
+    for (i = 0; i < rows; i++) {
+        for (j = 0; j < columns; j++) {
+            k = i*columns + j;
+            parents[k] = k;
+            if (j > 0 && BOND_OPEN(bonds->horizontal, bonds->words, i, j - 1)) {
+                parents[k] = find_site(parents, k - 1);
+            }
+            if (i > 0 && BOND_OPEN(bonds->vertical, bonds->words, i - 1, j)) {
+                root_a = find_site(parents, k);
+                root_b = find_site(parents, k - columns);
+                if (root_a < root_b) {
+                    parents[root_b] = root_a;
+                } else {
+                    parents[root_a] = root_b;
+                }
+            }
+        }
+    }
+
+    /* roots come before the rest of their cluster, so they are labeled first */
+    label = 2;
+    for (k = 0; k < rows*columns; k++) {
+        root_a = find_site(parents, k);
+        lattice[k] = root_a == k ? label++ : lattice[root_a];
+    }
+
+    free(parents);
+}
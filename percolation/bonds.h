@@ -0,0 +1,99 @@
+/*!
+    @file bonds.h
+    @brief This file contains functions for bond percolation on square
+    lattices.
+
+    In bond percolation every site belongs to the lattice, and it is the
+    bonds between neighboring sites that are open with the occupation
+    probability. The horizontal and vertical bonds are stored in bit-packed
+    arrays, one bit per bond and whole 64 bit words per row, so a lattice of
+    L x L sites takes L^2/4 bytes of bonds. The clusters are labeled into an
+    ordinary lattice, with the same conventions as the labeled site lattices
+    (every site has a label, starting from 2), so cluster_statistics and
+    has_percolating_cluster work unchanged on them. The bond percolation
+    threshold of the square lattice is exactly 1/2.
+
+    @author Federico Cerisola
+    @copyright MIT License.
+*/
+
+#ifndef BONDS_H
+#define BONDS_H
+
+#include <stdint.h>
+
+/*! Open bonds of a square lattice. */
+typedef struct bond_lattice {
+    int rows; /*!< the number of rows of sites */
+    int columns; /*!< the number of columns of sites */
+    int words; /*!< the number of 64 bit words of each row of bonds */
+    uint64_t * horizontal; /*!< bit j of row i is the bond between sites (i, j) and (i, j+1) */
+    uint64_t * vertical; /*!< bit j of row i is the bond between sites (i, j) and (i+1, j) */
+} bond_lattice;
+
+/*! Allocate the bonds of a lattice.
+
+    @param rows the number of rows of sites in the lattice.
+    @param columns the number of columns of sites in the lattice.
+    @return A pointer to the allocated bonds, all closed.
+
+    @warning The bonds must be free'd with free_bond_lattice.
+*/
+bond_lattice * allocate_bond_lattice(int rows, int columns);
+
+/*! Free the bonds of a lattice.
+
+    @param bonds pointer to the bonds.
+*/
+void free_bond_lattice(bond_lattice * bonds);
+
+/*! Open each bond of a lattice with the given probability.
+
+    The bonds are drawn 64 at a time, comparing the binary digits of
+    uniform random numbers with those of the probability, one word of
+    random bits per digit, only until every bond of the word is decided.
+    This takes about 8 words of random bits (16 calls to the random number
+    generator) per 64 bonds, instead of one call per bond.
+    The number of random numbers drawn depends on the probability, so the
+    lattices drawn from the same seed at different probabilities are not
+    related (see populate_bonds_nested).
+
+    @param probability the probability of each bond to be open.
+    @param bonds pointer to the bonds to be populated.
+    @param seed the seed used to initialize the random number generator. If
+        seed = 0, the random number generator is not initialized.
+*/
+void populate_bonds(double probability, bond_lattice * bonds, unsigned int seed);
+
+/*! Open each bond of a lattice with the given probability, drawing the same
+    random numbers whatever the probability.
+
+    The bonds are drawn as in populate_bonds, but all 32 words of random bits
+    are drawn for every 64 bonds (64 calls to the random number generator),
+    even once every bond is decided. So the lattices drawn from the same seed
+    are nested: every bond open at a probability is also open at any higher
+    one, as the bisection search needs.
+
+    @param probability the probability of each bond to be open.
+    @param bonds pointer to the bonds to be populated.
+    @param seed the seed used to initialize the random number generator. If
+        seed = 0, the random number generator is not initialized.
+
+    @see populate_bonds
+*/
+void populate_bonds_nested(double probability, bond_lattice * bonds, unsigned int seed);
+
+/*! Label the clusters of sites joined by open bonds.
+
+    The sites are scanned once in row-major order, joining each one with its
+    left and upper neighbors across open bonds in a union-find forest, and
+    then numbered.
+
+    @param bonds pointer to the bonds.
+    @param lattice array of rows*columns elements where the label of the
+        cluster of each site is stored, starting from 2 and numbered in the
+        order of their first site.
+*/
+void label_bond_clusters(const bond_lattice * bonds, int * lattice);
+
+#endif /* BONDS_H */
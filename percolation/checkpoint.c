@@ -0,0 +1,263 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+/* see header file for detailed documentation of each function */
+
+#include "checkpoint.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "random.h"
+#include "io_helpers.h"
+
+#define CHECKPOINT_MAGIC "PERCCKP4"
+#define CHECKPOINT_SWEEP 1
+#define CHECKPOINT_BISECTION 2
+
+/* header common to every checkpoint */
+typedef struct {
+    char magic[8];
+    int kind;
+    int rows;
+    int columns;
+    unsigned int seed;
+    int bins_per_decade; /* binning of the accumulated cluster sizes (0 if exact) */
+    int exact_sizes;
+    char lattice[16]; /* kind of lattice set with set_output_lattice (empty for square site lattices) */
+    pcg32_random_t rng;
+} checkpoint_header;
+
+/* open a temporary file next to the checkpoint and write its header */
+static FILE * open_checkpoint(const char * path, char ** temporary_path, int kind,
+                              int rows, int columns, unsigned int seed)
+{
+    FILE * file_handler;
+    checkpoint_header header;
+
+    *temporary_path = (char *)malloc((strlen(path) + 5)*sizeof(char));
+    sprintf(*temporary_path, "%s.tmp", path);
+
+    file_handler = fopen(*temporary_path, "wb");
+    if (!file_handler) {
+        free(*temporary_path);
+        return NULL;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, 8);
+    header.kind = kind;
+    header.rows = rows;
+    header.columns = columns;
+    header.seed = seed;
+    get_cluster_size_binning(&header.bins_per_decade, &header.exact_sizes);
+    if (get_output_lattice()) {
+        strncpy(header.lattice, get_output_lattice(), sizeof(header.lattice) - 1);
+    }
+    get_state_pcg(&header.rng);
+    fwrite(&header, sizeof(header), 1, file_handler);
+
+    return file_handler;
+}
+
+/* close the temporary file and move it in place of the checkpoint */
+static char close_checkpoint(const char * path, char * temporary_path,
+                             FILE * file_handler)
+{
+    char success;
+
+    success = !ferror(file_handler);
+    success = (fclose(file_handler) == 0) && success;
+    if (success) {
+        remove(path);
+        success = rename(temporary_path, path) == 0;
+    }
+    if (!success) {
+        remove(temporary_path);
+    }
+    free(temporary_path);
+
+    return success;
+}
+
+/* open a checkpoint, validate its header against the current run and
+   restore the RNG state */
+static FILE * read_checkpoint_header(const char * path, int kind, int rows,
+                                     int columns, unsigned int * seed)
+{
+    int bins_per_decade;
+    int exact_sizes;
+    FILE * file_handler;
+    checkpoint_header header;
+
+    file_handler = fopen(path, "rb");
+    if (!file_handler) {
+        return NULL;
+    }
+
+    if (fread(&header, sizeof(header), 1, file_handler) != 1 ||
+        memcmp(header.magic, CHECKPOINT_MAGIC, 8) != 0 || header.kind != kind ||
+        header.rows != rows || header.columns != columns) {
+        fclose(file_handler);
+        return NULL;
+    }
+
+    /* exact and binned cluster sizes cannot be accumulated together */
+    get_cluster_size_binning(&bins_per_decade, &exact_sizes);
+    if (header.bins_per_decade != bins_per_decade ||
+        (bins_per_decade > 0 && header.exact_sizes != exact_sizes)) {
+        fclose(file_handler);
+        return NULL;
+    }
+
+    /* nor can the results of different lattices (e.g. sites and bonds) */
+    header.lattice[sizeof(header.lattice) - 1] = '\0';
+    if (strcmp(header.lattice, get_output_lattice() ? get_output_lattice() : "") != 0) {
+        fclose(file_handler);
+        return NULL;
+    }
+
+    *seed = header.seed;
+    set_state_pcg(&header.rng);
+
+    return file_handler;
+}
+
+char write_sweep_checkpoint(const char * path, int rows, int columns,
+                            unsigned int seed, const sweep_point * points,
+                            int npoints, int current, int current_target,
+                            double current_elapsed)
+{
+    int i;
+    char * temporary_path;
+    FILE * file_handler;
+
+    file_handler = open_checkpoint(path, &temporary_path, CHECKPOINT_SWEEP,
+                                   rows, columns, seed);
+    if (!file_handler) {
+        return 0;
+    }
+
+    fwrite(&npoints, sizeof(int), 1, file_handler);
+    fwrite(&current, sizeof(int), 1, file_handler);
+    fwrite(&current_target, sizeof(int), 1, file_handler);
+    fwrite(&current_elapsed, sizeof(double), 1, file_handler);
+    for (i = 0; i < npoints; i++) {
+        fwrite(&points[i].probability, sizeof(double), 1, file_handler);
+        fwrite(&points[i].percolation_count, sizeof(int), 1, file_handler);
+        fwrite(&points[i].realizations, sizeof(int), 1, file_handler);
+        fwrite(&points[i].mean_cluster_size, sizeof(running_moments), 1, file_handler);
+        fwrite(&points[i].second_moment, sizeof(running_moments), 1, file_handler);
+        fwrite(&points[i].strength, sizeof(running_moments), 1, file_handler);
+        fwrite(&points[i].cluster_sizes_total_count, sizeof(int), 1, file_handler);
+        fwrite(points[i].cluster_sizes, sizeof(int),
+               points[i].cluster_sizes_total_count, file_handler);
+        fwrite(points[i].cluster_sizes_counts, sizeof(int),
+               points[i].cluster_sizes_total_count, file_handler);
+        fwrite(points[i].cluster_sizes_percolated, sizeof(int),
+               points[i].cluster_sizes_total_count, file_handler);
+    }
+
+    return close_checkpoint(path, temporary_path, file_handler);
+}
+
+char read_sweep_checkpoint(const char * path, int rows, int columns,
+                           unsigned int * seed, sweep_point ** points,
+                           int * npoints, int * current, int * current_target,
+                           double * current_elapsed)
+{
+    int i;
+    int count;
+    char success;
+    FILE * file_handler;
+
+    file_handler = read_checkpoint_header(path, CHECKPOINT_SWEEP, rows, columns, seed);
+    if (!file_handler) {
+        return 0;
+    }
+
+    success = fread(npoints, sizeof(int), 1, file_handler) == 1 &&
+              fread(current, sizeof(int), 1, file_handler) == 1 &&
+              fread(current_target, sizeof(int), 1, file_handler) == 1 &&
+              fread(current_elapsed, sizeof(double), 1, file_handler) == 1;
+    if (!success) {
+        fclose(file_handler);
+        return 0;
+    }
+
+    *points = (sweep_point *)malloc((*npoints)*sizeof(sweep_point));
+    for (i = 0; i < *npoints; i++) {
+        sweep_point_init(&(*points)[i], 0);
+    }
+    for (i = 0; i < *npoints && success; i++) {
+        success = fread(&(*points)[i].probability, sizeof(double), 1, file_handler) == 1 &&
+                  fread(&(*points)[i].percolation_count, sizeof(int), 1, file_handler) == 1 &&
+                  fread(&(*points)[i].realizations, sizeof(int), 1, file_handler) == 1 &&
+                  fread(&(*points)[i].mean_cluster_size, sizeof(running_moments), 1, file_handler) == 1 &&
+                  fread(&(*points)[i].second_moment, sizeof(running_moments), 1, file_handler) == 1 &&
+                  fread(&(*points)[i].strength, sizeof(running_moments), 1, file_handler) == 1 &&
+                  fread(&count, sizeof(int), 1, file_handler) == 1;
+        if (!success || count == 0) {
+            continue;
+        }
+        (*points)[i].cluster_sizes_total_count = count;
+        (*points)[i].cluster_sizes = (int *)malloc(count*sizeof(int));
+        (*points)[i].cluster_sizes_counts = (int *)malloc(count*sizeof(int));
+        (*points)[i].cluster_sizes_percolated = (int *)malloc(count*sizeof(int));
+        success = fread((*points)[i].cluster_sizes, sizeof(int), count, file_handler) == (size_t)count &&
+                  fread((*points)[i].cluster_sizes_counts, sizeof(int), count, file_handler) == (size_t)count &&
+                  fread((*points)[i].cluster_sizes_percolated, sizeof(int), count, file_handler) == (size_t)count;
+    }
+    fclose(file_handler);
+
+    if (!success) {
+        for (i = 0; i < *npoints; i++) {
+            sweep_point_clear(&(*points)[i]);
+        }
+        free(*points);
+        *points = NULL;
+    }
+
+    return success;
+}
+
+char write_bisection_checkpoint(const char * path, int rows, int columns,
+                                unsigned int seed, const double * critical_points,
+                                int number_trials, int trials_done)
+{
+    char * temporary_path;
+    FILE * file_handler;
+
+    file_handler = open_checkpoint(path, &temporary_path, CHECKPOINT_BISECTION,
+                                   rows, columns, seed);
+    if (!file_handler) {
+        return 0;
+    }
+
+    fwrite(&number_trials, sizeof(int), 1, file_handler);
+    fwrite(&trials_done, sizeof(int), 1, file_handler);
+    fwrite(critical_points, sizeof(double), trials_done, file_handler);
+
+    return close_checkpoint(path, temporary_path, file_handler);
+}
+
+char read_bisection_checkpoint(const char * path, int rows, int columns,
+                               unsigned int * seed, double * critical_points,
+                               int number_trials, int * trials_done)
+{
+    int saved_number_trials;
+    char success;
+    FILE * file_handler;
+
+    file_handler = read_checkpoint_header(path, CHECKPOINT_BISECTION, rows, columns, seed);
+    if (!file_handler) {
+        return 0;
+    }
+
+    success = fread(&saved_number_trials, sizeof(int), 1, file_handler) == 1 &&
+              saved_number_trials == number_trials &&
+              fread(trials_done, sizeof(int), 1, file_handler) == 1 &&
+              *trials_done <= number_trials &&
+              fread(critical_points, sizeof(double), *trials_done, file_handler) == (size_t)*trials_done;
+    fclose(file_handler);
+
+    return success;
+}
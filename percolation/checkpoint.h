@@ -0,0 +1,114 @@
+/*!
+    @file checkpoint.h
+    @brief This file contains functions to save and restore the progress of
+    long runs, so that they can be resumed after being interrupted.
+
+    Checkpoints are compact binary files that also store the state of the
+    global random number generator, so that a resumed run produces exactly the
+    same results as an uninterrupted one. They are written to a temporary file
+    which is then renamed, so an interruption while writing never corrupts the
+    previous checkpoint.
+
+    A checkpoint also records the binning of the cluster sizes (see
+    set_cluster_size_binning) and the kind of lattice (see
+    set_output_lattice, e.g. "bond" for bond percolation), and is only
+    restored by a run with the same binning and lattice.
+
+    @author Federico Cerisola
+    @copyright MIT License.
+*/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "sweep.h"
+
+/*! Save the progress of a probability sweep.
+
+    @param path path to the checkpoint file. If the file exists it will be
+        overwritten.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param seed the random number generator seed used at the beginning of the
+        probability sweep.
+    @param points the accumulated results of every point of the grid,
+        including the cluster statistics of those not yet written out.
+    @param npoints the number of points in the grid.
+    @param current the index of the point being sampled.
+    @param current_target the target number of repetitions of the point being
+        sampled.
+    @param current_elapsed the time already spent sampling the current point.
+    @return A boolean indicating whether the checkpoint was saved.
+*/
+char write_sweep_checkpoint(const char * path, int rows, int columns,
+                            unsigned int seed, const sweep_point * points,
+                            int npoints, int current, int current_target,
+                            double current_elapsed);
+
+/*! Restore the progress of a probability sweep.
+
+    The global random number generator is set to the saved state.
+
+    @param path path to the checkpoint file.
+    @param rows the number of rows in the lattice, which must match the saved one.
+    @param columns the number of columns in the lattice, which must match the
+        saved one.
+    @param seed pointer where to store the seed used at the beginning of the
+        sweep.
+    @param points pointer where to store the newly allocated array of grid
+        points.
+    @param npoints pointer where to store the number of points in the grid.
+    @param current pointer where to store the index of the point being sampled.
+    @param current_target pointer where to store the target number of
+        repetitions of the point being sampled.
+    @param current_elapsed pointer where to store the time already spent
+        sampling the current point.
+    @return A boolean indicating whether the checkpoint was restored.
+
+    @warning points and the statistics in them must be manually free'd by the
+        user.
+*/
+char read_sweep_checkpoint(const char * path, int rows, int columns,
+                           unsigned int * seed, sweep_point ** points,
+                           int * npoints, int * current, int * current_target,
+                           double * current_elapsed);
+
+/*! Save the progress of a critical point bisection search.
+
+    @param path path to the checkpoint file. If the file exists it will be
+        overwritten.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param seed the random number generator seed of the next trial.
+    @param critical_points the critical points estimated so far.
+    @param number_trials the total number of trials of the search.
+    @param trials_done the number of trials already finished.
+    @return A boolean indicating whether the checkpoint was saved.
+*/
+char write_bisection_checkpoint(const char * path, int rows, int columns,
+                                unsigned int seed, const double * critical_points,
+                                int number_trials, int trials_done);
+
+/*! Restore the progress of a critical point bisection search.
+
+    The global random number generator is set to the saved state.
+
+    @param path path to the checkpoint file.
+    @param rows the number of rows in the lattice, which must match the saved one.
+    @param columns the number of columns in the lattice, which must match the
+        saved one.
+    @param seed pointer where to store the random number generator seed of the
+        next trial.
+    @param critical_points array where to store the critical points estimated
+        so far.
+    @param number_trials the total number of trials of the search, which must
+        match the saved one.
+    @param trials_done pointer where to store the number of trials already
+        finished.
+    @return A boolean indicating whether the checkpoint was restored.
+*/
+char read_bisection_checkpoint(const char * path, int rows, int columns,
+                               unsigned int * seed, double * critical_points,
+                               int number_trials, int * trials_done);
+
+#endif /* CHECKPOINT_H */
@@ -0,0 +1,52 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+/* see header file for detailed documentation of each function */
+
+#include "cli.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* remove the i-th argument from argv shifting the remaining ones */
+static void remove_argument(int * argc, char ** argv, int i)
+{
+    for (; i < *argc - 1; i++) {
+        argv[i] = argv[i + 1];
+    }
+    (*argc)--;
+    argv[*argc] = NULL;
+}
+
+const char * extract_option(int * argc, char ** argv, const char * name)
+{
+    int i;
+    size_t name_length;
+    const char * value;
+
+    name_length = strlen(name);
+    for (i = 1; i < *argc; i++) {
+        if (strncmp(argv[i], "--", 2) != 0 ||
+            strncmp(argv[i] + 2, name, name_length) != 0 ||
+            argv[i][2 + name_length] != '=') {
+            continue;
+        }
+        value = argv[i] + 3 + name_length;
+        remove_argument(argc, argv, i);
+        return value;
+    }
+
+    return NULL;
+}
+
+char extract_flag(int * argc, char ** argv, const char * name)
+{
+    int i;
+
+    for (i = 1; i < *argc; i++) {
+        if (strncmp(argv[i], "--", 2) == 0 && strcmp(argv[i] + 2, name) == 0) {
+            remove_argument(argc, argv, i);
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,37 @@
+/*!
+    @file cli.h
+    @brief This file contains helper functions for parsing optional command
+    line arguments.
+
+    @author Federico Cerisola
+    @copyright MIT License.
+*/
+
+#ifndef CLI_H
+#define CLI_H
+
+/*! Extract an optional argument of the form --name=value from the command line.
+
+    The matching argument is removed from argv and argc is updated accordingly,
+    so that the remaining positional arguments can be parsed as usual.
+
+    @param argc pointer to the number of command line arguments.
+    @param argv the command line arguments.
+    @param name the name of the option (without the leading dashes).
+    @return A pointer to the value of the option or NULL if the option was not
+        given.
+*/
+const char * extract_option(int * argc, char ** argv, const char * name);
+
+/*! Extract an optional flag of the form --name from the command line.
+
+    The matching argument is removed from argv and argc is updated accordingly.
+
+    @param argc pointer to the number of command line arguments.
+    @param argv the command line arguments.
+    @param name the name of the flag (without the leading dashes).
+    @return A boolean indicating whether the flag was given.
+*/
+char extract_flag(int * argc, char ** argv, const char * name);
+
+#endif /* CLI_H */
@@ -5,8 +5,34 @@
 #include "clusters.h"
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include "lattice.h"
 
-void label_clusters(int * lattice, int rows, int columns)
+/* add an occupied site to the geometry of its cluster */
+static void add_site_to_geometry(cluster_geometry * geometry, int row, int column)
+{
+    if (geometry->size == 0) {
+        geometry->min_row = row;
+        geometry->max_row = row;
+        geometry->min_column = column;
+        geometry->max_column = column;
+    }
+    geometry->size += 1;
+    geometry->sum_rows += row;
+    geometry->sum_columns += column;
+    geometry->sum_rows_squared += ((double)row)*row;
+    geometry->sum_columns_squared += ((double)column)*column;
+    geometry->min_row = row < geometry->min_row ? row : geometry->min_row;
+    geometry->max_row = row > geometry->max_row ? row : geometry->max_row;
+    geometry->min_column = column < geometry->min_column ? column : geometry->min_column;
+    geometry->max_column = column > geometry->max_column ? column : geometry->max_column;
+}
+
+/* Hoshen-Kopelman labelling; if geometry is not NULL the geometry of each
+   cluster is accumulated at its final label while resolving the temporary
+   labels, so it costs no extra pass over the lattice */
+static void hoshen_kopelman(int * lattice, int rows, int columns,
+                            cluster_geometry * geometry)
 {
     int i;
     int lattice_size;
@@ -19,7 +45,7 @@ void label_clusters(int * lattice, int rows, int columns)
     lattice_size = rows*columns;
 
     /* allocate and initialize auxilliary label storing array */
-    labels = (int *) malloc((lattice_size/2 + 3)*sizeof(int));
+    labels = (int *)allocate_aligned((lattice_size/2 + 3)*sizeof(int));
     for (i = 0; i < lattice_size/2 + 3; i++) {
         labels[i] = i;
     }
@@ -110,12 +136,164 @@ void label_clusters(int * lattice, int rows, int columns)
         }
         labels[current_label] = current_label;
         lattice[i] = current_label;
+        if (geometry && current_label) {
+            add_site_to_geometry(&geometry[current_label], i / columns, i % columns);
+        }
     }
 
     /* free used memory */
     free(labels);
 }
 
+void label_clusters(int * lattice, int rows, int columns)
+{
+    hoshen_kopelman(lattice, rows, columns, NULL);
+}
+
+/* root of a provisional label in a union-find forest, halving the path */
+static int find_label(int * parents, int label)
+{
+    while (parents[label] != label) {
+        parents[label] = parents[parents[label]];
+        label = parents[label];
+    }
+    return label;
+}
+
+void label_clusters_runs(int * lattice, int rows, int columns)
+{
+    int i;
+    int j;
+    int k;
+    int q;
+    int start;
+    int row;
+    int run_count;
+    int previous_count;
+    int * runs; /* start, end (exclusive) and provisional label of each run in a row */
+    int * previous_runs; /* same for the previous row */
+    int * swap;
+    int * parents; /* union-find forest of the provisional labels */
+    int label_count;
+    int next_label;
+    int root_a;
+    int root_b;
+
+    runs = (int *)allocate_aligned(3*(columns/2 + 1)*sizeof(int));
+    previous_runs = (int *)allocate_aligned(3*(columns/2 + 1)*sizeof(int));
+    parents = (int *)allocate_aligned((((long)rows)*(columns/2 + 1) + 1)*sizeof(int));
+
+    /* provisional labels start from 1, so that 0 still marks empty sites */
+    label_count = 1;
+    previous_count = 0;
+    for (i = 0; i < rows; i++) {
+        row = i*columns;
+
+        /* split the row in runs, each with a new provisional label */
+        run_count = 0;
+        j = 0;
+        while (j < columns) {
+            if (lattice[row + j] == 0) {
+                j++;
+                continue;
+            }
+            start = j;
+            while (j < columns && lattice[row + j]) {
+                j++;
+            }
+            runs[3*run_count] = start;
+            runs[3*run_count + 1] = j;
+            runs[3*run_count + 2] = label_count;
+            parents[label_count] = label_count;
+            label_count++;
+            run_count++;
+        }
+
+        /* join each run with the runs of the previous row it overlaps; the
+           smallest label is kept as root so that roots come first */
+        q = 0;
+        for (k = 0; k < run_count; k++) {
+            while (q < previous_count && previous_runs[3*q + 1] <= runs[3*k]) {
+                q++;
+            }
+            for (j = q; j < previous_count && previous_runs[3*j] < runs[3*k + 1]; j++) {
+                root_a = find_label(parents, runs[3*k + 2]);
+                root_b = find_label(parents, previous_runs[3*j + 2]);
+                if (root_a < root_b) {
+                    parents[root_b] = root_a;
+                } else {
+                    parents[root_a] = root_b;
+                }
+            }
+            for (j = runs[3*k]; j < runs[3*k + 1]; j++) {
+                lattice[row + j] = runs[3*k + 2];
+            }
+        }
+
+        swap = previous_runs;
+        previous_runs = runs;
+        runs = swap;
+        previous_count = run_count;
+    }
+
+    /* number the clusters consecutively from 2, as label_clusters does, so
+       that labels stay below rows*columns/2 + 3 */
+    for (k = 1; k < label_count; k++) {
+        parents[k] = find_label(parents, k);
+    }
+    next_label = 2;
+    for (k = 1; k < label_count; k++) {
+        parents[k] = parents[k] == k ? -(next_label++) : parents[parents[k]];
+    }
+    for (i = 0; i < rows*columns; i++) {
+        if (lattice[i]) {
+            lattice[i] = -parents[lattice[i]];
+        }
+    }
+
+    free(runs);
+    free(previous_runs);
+    free(parents);
+}
+
+int label_clusters_geometry(int * lattice, int rows, int columns,
+                            cluster_geometry ** geometry)
+{
+    int i;
+    int label_count;
+    int cluster_count;
+
+    /* one accumulator per possible label */
+    label_count = rows*columns/2 + 3;
+    *geometry = (cluster_geometry *)calloc(label_count, sizeof(cluster_geometry));
+    hoshen_kopelman(lattice, rows, columns, *geometry);
+
+    /* keep only the labels that ended up as clusters */
+    cluster_count = 0;
+    for (i = 0; i < label_count; i++) {
+        if ((*geometry)[i].size == 0) {
+            continue;
+        }
+        (*geometry)[i].label = i;
+        (*geometry)[cluster_count] = (*geometry)[i];
+        cluster_count++;
+    }
+    *geometry = realloc(*geometry, (cluster_count > 0 ? cluster_count : 1)*sizeof(cluster_geometry));
+
+    return cluster_count;
+}
+
+double cluster_radius_of_gyration_squared(const cluster_geometry * geometry)
+{
+    double mean_row;
+    double mean_column;
+
+    mean_row = geometry->sum_rows/geometry->size;
+    mean_column = geometry->sum_columns/geometry->size;
+    return (geometry->sum_rows_squared + geometry->sum_columns_squared)/geometry->size -
+           mean_row*mean_row - mean_column*mean_column;
+}
+
 char has_percolating_cluster(const int * lattice, int rows, int columns)
 {
     int i;
@@ -149,6 +327,71 @@ char has_percolating_cluster(const int * lattice, int rows, int columns)
     return 0;
 }
 
+/* flood the sites reachable from the given seeds that are not yet marked,
+   returning whether the flood reached the opposite side */
+static char flood_to_opposite_side(int * lattice, int rows, int columns,
+                                   int * stack, char vertical, int mark)
+{
+    int k;
+    int site;
+    int row;
+    int column;
+    int count;
+    int seeds;
+
+    /* seed with the occupied sites of the first row (or column) */
+    count = 0;
+    seeds = vertical ? columns : rows;
+    for (k = 0; k < seeds; k++) {
+        site = vertical ? k : k*columns;
+        if (lattice[site] != 0 && lattice[site] != mark) {
+            lattice[site] = mark;
+            stack[count++] = site;
+        }
+    }
+
+    while (count > 0) {
+        site = stack[--count];
+        row = site / columns;
+        column = site % columns;
+        if ((vertical && row == rows - 1) || (!vertical && column == columns - 1)) {
+            return 1;
+        }
+        if (row > 0 && lattice[site - columns] != 0 && lattice[site - columns] != mark) {
+            lattice[site - columns] = mark;
+            stack[count++] = site - columns;
+        }
+        if (row < rows - 1 && lattice[site + columns] != 0 && lattice[site + columns] != mark) {
+            lattice[site + columns] = mark;
+            stack[count++] = site + columns;
+        }
+        if (column > 0 && lattice[site - 1] != 0 && lattice[site - 1] != mark) {
+            lattice[site - 1] = mark;
+            stack[count++] = site - 1;
+        }
+        if (column < columns - 1 && lattice[site + 1] != 0 && lattice[site + 1] != mark) {
+            lattice[site + 1] = mark;
+            stack[count++] = site + 1;
+        }
+    }
+
+    return 0;
+}
+
+char lattice_percolates(int * lattice, int rows, int columns)
+{
+    int * stack;
+    char percolates;
+
+    /* every site is pushed at most once per flood */
+    stack = (int *)malloc(rows*columns*sizeof(int));
+    percolates = flood_to_opposite_side(lattice, rows, columns, stack, 1, 2) ||
+                 flood_to_opposite_side(lattice, rows, columns, stack, 0, 3);
+    free(stack);
+
+    return percolates;
+}
+
 void cluster_statistics(const int * lattice, int rows, int columns,
                         int * cluster_sizes_total_count, int ** cluster_sizes,
                         int ** cluster_sizes_counts, int ** cluster_sizes_percolated,
@@ -156,21 +399,22 @@ void cluster_statistics(const int * lattice, int rows, int columns,
 {
     int i;
     int j;
-    char percolated;
     int lattice_size;
     int cluster_labels_total_count; /* total number of different cluster labels */
     int * cluster_labels_indices; /* indices mapping each cluster label to a count value */
     int * cluster_labels_sizes; /* size of cluster for each label (via above index mapping */
     char * cluster_labels_percolated; /* whether the matching cluster (labeled via the above index mapping) has percolated */
+    char * cluster_labels_borders; /* last row and column touched by each cluster (via the above index mapping) */
     int * cluster_sizes_indices; /* indices mapping for each cluster size to a size value */
 
-    /* assign each label their total node count; stored via an index mapping */
+    /* assign each label their total node count; stored via an index mapping;
+       the labels of bond lattices go up to one per site */
     lattice_size = rows*columns;
     cluster_labels_total_count = 0;
-    cluster_labels_indices = (int *)malloc((lattice_size/2 + 3)*sizeof(int));
-    cluster_labels_sizes = (int *)malloc((lattice_size/2 + 3)*sizeof(int));
-    cluster_sizes_indices = (int *)malloc((lattice_size + 1)*sizeof(int));
-    for (i = 0; i < lattice_size/2 + 3; i++) {
+    cluster_labels_indices = (int *)allocate_aligned((lattice_size + 3)*sizeof(int));
+    cluster_labels_sizes = (int *)allocate_aligned((lattice_size + 3)*sizeof(int));
+    cluster_sizes_indices = (int *)allocate_aligned((lattice_size + 1)*sizeof(int));
+    for (i = 0; i < lattice_size + 3; i++) {
         cluster_labels_indices[i] = -1;
         cluster_labels_sizes[i] = 0;
     }
@@ -193,44 +437,36 @@ void cluster_statistics(const int * lattice, int rows, int columns,
     /* finish initialization */
     cluster_sizes_indices[lattice_size] = -1;
 
-    /* determine which clusters have percolated */
+    /* determine which clusters have percolated: mark the clusters touching
+       the last row (bit 1) and last column (bit 2), then look for them in
+       the first row and column */
     cluster_labels_percolated = (char *)malloc(cluster_labels_total_count*sizeof(char));
+    cluster_labels_borders = (char *)malloc(cluster_labels_total_count*sizeof(char));
     for (i = 0; i < cluster_labels_total_count; i++) {
         cluster_labels_percolated[i] = 0;
+        cluster_labels_borders[i] = 0;
     }
-    percolated = 0;
-    /* compare first and last row labels */
-    for (i = 0; i < columns; i++) {
-        if (percolated) {
-            break;
+    for (j = 0; j < columns; j++) {
+        if (lattice[(rows-1)*columns + j]) {
+            cluster_labels_borders[cluster_labels_indices[lattice[(rows-1)*columns + j]]] |= 1;
         }
-        if (lattice[i] == 0) {
-            continue;
+    }
+    for (j = 0; j < rows; j++) {
+        if (lattice[j*columns + columns - 1]) {
+            cluster_labels_borders[cluster_labels_indices[lattice[j*columns + columns - 1]]] |= 2;
         }
-        for (j = 0; j < columns; j++) {
-            if (lattice[i] == lattice[(rows-1)*columns + j]) {
-                cluster_labels_percolated[cluster_labels_indices[lattice[i]]] = 1;
-                percolated = 1;
-                break;
-            }
+    }
+    for (i = 0; i < columns; i++) {
+        if (lattice[i] && (cluster_labels_borders[cluster_labels_indices[lattice[i]]] & 1)) {
+            cluster_labels_percolated[cluster_labels_indices[lattice[i]]] = 1;
         }
     }
-    /* compare first and last column labels */
     for (i = 0; i < rows; i++) {
-        if (percolated) {
-            break;
-        }
-        if (lattice[i*columns] == 0) {
-            continue;
-        }
-        for (j = 0; j < rows; j++) {
-            if (lattice[i*columns] == lattice[j*columns + columns - 1]) {
-                cluster_labels_percolated[cluster_labels_indices[lattice[i*columns]]] = 1;
-                percolated = 1;
-                break;
-            }
+        if (lattice[i*columns] && (cluster_labels_borders[cluster_labels_indices[lattice[i*columns]]] & 2)) {
+            cluster_labels_percolated[cluster_labels_indices[lattice[i*columns]]] = 1;
         }
     }
+    free(cluster_labels_borders);
 
     free(cluster_labels_indices);
 
@@ -328,3 +564,223 @@ void aggregate_cluster_statistics(int cluster_sizes_total_count_to_merge,
     *cluster_sizes_counts = realloc(*cluster_sizes_counts, (*cluster_sizes_total_count)*sizeof(int));
     *cluster_sizes_percolated = realloc(*cluster_sizes_percolated, (*cluster_sizes_total_count)*sizeof(int));
 }
+
+int cluster_size_bin(int size, int bins_per_decade, int exact_sizes)
+{
+    if (size <= exact_sizes) {
+        return size - 1;
+    }
+    /* the small offset keeps sizes that fall exactly on an edge (e.g. powers
+       of ten) in the upper bin despite rounding errors */
+    return exact_sizes + (int)floor(bins_per_decade*log10(((double)size)/exact_sizes) + 1e-9);
+}
+
+int cluster_size_bin_lower_edge(int bin, int bins_per_decade, int exact_sizes)
+{
+    int size;
+
+    if (bin < exact_sizes) {
+        return bin + 1;
+    }
+    size = (int)ceil(exact_sizes*pow(10, ((double)(bin - exact_sizes))/bins_per_decade));
+    if (size <= exact_sizes) {
+        size = exact_sizes + 1;
+    }
+    /* correct rounding errors so that the edge agrees with cluster_size_bin */
+    while (size > exact_sizes + 1 && cluster_size_bin(size - 1, bins_per_decade, exact_sizes) >= bin) {
+        size--;
+    }
+    while (cluster_size_bin(size, bins_per_decade, exact_sizes) < bin) {
+        size++;
+    }
+    return size;
+}
+
+int cluster_size_minimum_exact_sizes(int bins_per_decade)
+{
+    return (int)ceil(1/(pow(10, 1.0/bins_per_decade) - 1));
+}
+
+/* find the root of a site in a union-find forest with path halving */
+static int find_root(int * parents, int site)
+{
+    while (parents[site] != site) {
+        parents[site] = parents[parents[site]];
+        site = parents[site];
+    }
+    return site;
+}
+
+void label_nested_boxes(const int * lattice, int size, const int * box_sizes,
+                        int box_count, int ** boxes)
+{
+    int i;
+    int j;
+    int k;
+    int l;
+    int site;
+    int neighbour;
+    int root;
+    int root_neighbour;
+    int offset; /* position of the first row and column of the current box */
+    int offset_previous;
+    int l_previous;
+    int next_label;
+    int * parents; /* union-find forest; -1 for sites not yet added */
+    int * root_labels; /* compact label of each root in the current box */
+    const int di[4] = {-1, 1, 0, 0};
+    const int dj[4] = {0, 0, -1, 1};
+
+    parents = (int *)allocate_aligned(((size_t)size)*size*sizeof(int));
+    root_labels = (int *)allocate_aligned(((size_t)size)*size*sizeof(int));
+    for (i = 0; i < size*size; i++) {
+        parents[i] = -1;
+        root_labels[i] = 0;
+    }
+
+    l_previous = 0;
+    offset_previous = size/2;
+    for (k = 0; k < box_count; k++) {
+        l = box_sizes[k];
+        offset = (size - l)/2;
+
+        /* add the sites of the ring between the previous box and this one */
+        for (i = offset; i < offset + l; i++) {
+            for (j = offset; j < offset + l; j++) {
+                if (i >= offset_previous && i < offset_previous + l_previous &&
+                    j >= offset_previous && j < offset_previous + l_previous) {
+                    j = offset_previous + l_previous - 1;
+                    continue;
+                }
+                site = i*size + j;
+                if (lattice[site] == 0) {
+                    continue;
+                }
+                parents[site] = site;
+                for (neighbour = 0; neighbour < 4; neighbour++) {
+                    if (i + di[neighbour] < 0 || i + di[neighbour] >= size ||
+                        j + dj[neighbour] < 0 || j + dj[neighbour] >= size) {
+                        continue;
+                    }
+                    if (parents[site + di[neighbour]*size + dj[neighbour]] < 0) {
+                        continue;
+                    }
+                    root = find_root(parents, site);
+                    root_neighbour = find_root(parents, site + di[neighbour]*size + dj[neighbour]);
+                    if (root < root_neighbour) {
+                        parents[root_neighbour] = root;
+                    } else {
+                        parents[root] = root_neighbour;
+                    }
+                }
+            }
+        }
+
+        /* write compact labels of the box starting from 2 */
+        next_label = 2;
+        for (i = 0; i < l; i++) {
+            for (j = 0; j < l; j++) {
+                site = (offset + i)*size + offset + j;
+                if (parents[site] < 0) {
+                    boxes[k][i*l + j] = 0;
+                    continue;
+                }
+                root = find_root(parents, site);
+                if (root_labels[root] == 0) {
+                    root_labels[root] = next_label;
+                    next_label++;
+                }
+                boxes[k][i*l + j] = root_labels[root];
+            }
+        }
+
+        /* reset the compact labels for the next box */
+        for (i = 0; i < l*l; i++) {
+            if (boxes[k][i]) {
+                root_labels[find_root(parents, (offset + i/l)*size + offset + i%l)] = 0;
+            }
+        }
+
+        l_previous = l;
+        offset_previous = offset;
+    }
+
+    free(parents);
+    free(root_labels);
+}
+
+int gradient_percolation_front(const int * lattice, int rows, int columns,
+                               int * front_columns)
+{
+    int i;
+    int j;
+    int k;
+    int site;
+    int neighbour;
+    int row;
+    int column;
+    int front_label;
+    int front_size;
+    int stack_size;
+    int * stack;
+    char * outside; /* empty sites connected to the last column */
+
+    stack = (int *)malloc(rows*columns*sizeof(int));
+    outside = (char *)calloc(rows*columns, sizeof(char));
+
+    /* flood the empty sites from the last column, through nearest and
+       next-nearest neighbours */
+    stack_size = 0;
+    for (i = 0; i < rows; i++) {
+        site = i*columns + columns - 1;
+        if (lattice[site] == 0) {
+            outside[site] = 1;
+            stack[stack_size++] = site;
+        }
+    }
+    while (stack_size > 0) {
+        site = stack[--stack_size];
+        row = site / columns;
+        column = site % columns;
+        for (i = row - 1; i <= row + 1; i++) {
+            for (j = column - 1; j <= column + 1; j++) {
+                if (i < 0 || i >= rows || j < 0 || j >= columns) {
+                    continue;
+                }
+                neighbour = i*columns + j;
+                if (lattice[neighbour] == 0 && !outside[neighbour]) {
+                    outside[neighbour] = 1;
+                    stack[stack_size++] = neighbour;
+                }
+            }
+        }
+    }
+
+    /* the cluster connected to the first column */
+    front_label = 0;
+    for (i = 0; i < rows && front_label == 0; i++) {
+        front_label = lattice[i*columns];
+    }
+
+    /* its sites next to the outside empty region form the front */
+    front_size = 0;
+    for (k = 0; front_label != 0 && k < rows*columns; k++) {
+        if (lattice[k] != front_label) {
+            continue;
+        }
+        row = k / columns;
+        column = k % columns;
+        if ((row > 0 && outside[k - columns]) ||
+            (row < rows - 1 && outside[k + columns]) ||
+            (column > 0 && outside[k - 1]) ||
+            (column < columns - 1 && outside[k + 1])) {
+            front_columns[column] += 1;
+            front_size += 1;
+        }
+    }
+
+    free(stack);
+    free(outside);
+
+    return front_size;
+}
@@ -10,6 +10,20 @@
 #ifndef CLUSTERS_H
 #define CLUSTERS_H
 
+/*! Geometry of a single cluster, accumulated while labeling. */
+typedef struct {
+    int label; /*!< label of the cluster in the labeled lattice */
+    int size; /*!< number of sites in the cluster */
+    double sum_rows; /*!< sum of the row of each site */
+    double sum_columns; /*!< sum of the column of each site */
+    double sum_rows_squared; /*!< sum of the squared row of each site */
+    double sum_columns_squared; /*!< sum of the squared column of each site */
+    int min_row; /*!< first row of the bounding box */
+    int max_row; /*!< last row of the bounding box */
+    int min_column; /*!< first column of the bounding box */
+    int max_column; /*!< last column of the bounding box */
+} cluster_geometry;
+
 /*!  Search for and label clusters in a lattice.
 
     This function implements the Hoshen-Kopelman algorithm [1] for labelling
@@ -26,6 +40,53 @@
 */
 void label_clusters(int * lattice, int rows, int columns);
 
+/*! Search for and label clusters in a lattice, joining whole runs of
+    occupied sites at a time.
+
+    Each row is split in runs of consecutive occupied sites, and only the
+    runs that overlap in consecutive rows are joined (with a union-find
+    forest), so dense lattices need far fewer label operations than in
+    label_clusters. The labels identify the same clusters as the ones given
+    by label_clusters, although their values may differ.
+
+    @param lattice pointer to the lattice to be analyzed.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+
+    @see label_clusters
+*/
+void label_clusters_runs(int * lattice, int rows, int columns);
+
+/*! Search for and label clusters in a lattice, also accumulating the
+    geometry of each cluster.
+
+    The labels are the same as the ones given by label_clusters. The sums
+    and bounding box of every cluster are accumulated in the same pass in
+    which label_clusters resolves its temporary labels, so this adds little
+    to the cost of labelling.
+
+    @param lattice pointer to the lattice to be analyzed.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param geometry pointer where to store the array with the geometry of
+        each cluster.
+    @return The number of clusters (elements of the geometry array).
+
+    @warning geometry must be manually free'd by the user.
+*/
+int label_clusters_geometry(int * lattice, int rows, int columns,
+                            cluster_geometry ** geometry);
+
+/*! Get the squared radius of gyration of a cluster.
+
+    @param geometry pointer to the geometry of the cluster.
+    @return The mean squared distance of the sites of the cluster to its
+        center of mass.
+
+    @see label_clusters_geometry
+*/
+double cluster_radius_of_gyration_squared(const cluster_geometry * geometry);
+
 /*! Determine whether a lattice has a percolating cluster.
 
     @param lattice pointer to lattice to be analyzed. The lattice must already
@@ -39,6 +100,25 @@ void label_clusters(int * lattice, int rows, int columns);
 */
 char has_percolating_cluster(const int * lattice, int rows, int columns);
 
+/*! Find whether a populated lattice has a percolating cluster, without
+    labeling it.
+
+    The clusters touching the first row are flooded until one of them reaches
+    the last row, and then the same is done from the first column to the last
+    one. Only the sites connected to the first row or column are visited, and
+    the search stops as soon as a percolating cluster is found.
+
+    @param lattice pointer to the populated lattice to be analyzed. Its values
+        are overwritten, so it is left neither populated nor labeled.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @return A boolean indicating whether the lattice has a percolating cluster
+        or not.
+
+    @see has_percolating_cluster for the same test on a labeled lattice.
+*/
+char lattice_percolates(int * lattice, int rows, int columns);
+
 /*! Perform cluster sizes statistics.
 
     @param lattice pointer to lattice to be analyzed. The lattice must already
@@ -100,4 +180,89 @@ void aggregate_cluster_statistics(int cluster_sizes_total_count_to_merge,
                                   int ** cluster_sizes_counts,
                                   int ** cluster_sizes_percolated);
 
+/*! Get the logarithmic bin of a cluster size.
+
+    Sizes up to exact_sizes have a bin of their own; larger sizes are grouped
+    in bins of equal width in log10(size), bins_per_decade of them per decade,
+    starting at exact_sizes. Bins are numbered consecutively from 0 (the bin
+    of size 1).
+
+    @param size the cluster size.
+    @param bins_per_decade the number of logarithmic bins per decade.
+    @param exact_sizes the largest size that is not binned. It must be at
+        least cluster_size_minimum_exact_sizes(bins_per_decade), so that no
+        bin is empty of integer sizes.
+    @return The index of the bin.
+*/
+int cluster_size_bin(int size, int bins_per_decade, int exact_sizes);
+
+/*! Get the smallest cluster size of a logarithmic bin.
+
+    @param bin the index of the bin.
+    @param bins_per_decade the number of logarithmic bins per decade.
+    @param exact_sizes the largest size that is not binned.
+    @return The smallest size that falls in the bin.
+
+    @see cluster_size_bin
+*/
+int cluster_size_bin_lower_edge(int bin, int bins_per_decade, int exact_sizes);
+
+/*! Get the smallest exact region for which every logarithmic bin contains
+    at least one integer size.
+
+    @param bins_per_decade the number of logarithmic bins per decade.
+    @return The minimum value of exact_sizes.
+*/
+int cluster_size_minimum_exact_sizes(int bins_per_decade);
+
+/*! Label clusters in concentric sub-boxes of a lattice.
+
+    The sub-boxes are centered in the lattice and labeled incrementally, from
+    the smallest to the largest, with a union-find structure: each box only
+    adds the ring of sites not contained in the previous one, so the whole
+    series is labeled in a single pass over the lattice. Connectivity is
+    restricted to each box, i.e. two sites are in the same cluster of a box
+    only if they are connected through sites inside that box.
+
+    @param lattice pointer to the populated (not labeled) lattice.
+    @param size the number of rows and columns of the square lattice.
+    @param box_sizes the sizes of the sub-boxes, in increasing order and none
+        larger than size.
+    @param box_count the number of sub-boxes.
+    @param boxes array of pointers to square lattices of the matching size
+        where the labeled sub-boxes will be stored. The labels are compatible
+        with the ones returned by label_clusters.
+
+    @see cluster_statistics for a function that can be applied to each of the
+        labeled boxes.
+*/
+void label_nested_boxes(const int * lattice, int size, const int * box_sizes,
+                        int box_count, int ** boxes);
+
+/*! Find the front of the cluster connected to the first column of a
+    gradient percolation lattice.
+
+    The front (hull) is made of the sites of that cluster that are nearest
+    neighbours of an empty site connected to the last column through empty
+    sites. Empty sites are connected also through next-nearest neighbours,
+    which is the dual of the nearest-neighbour connectivity of occupied
+    sites, so the front does not include the perimeter of holes enclosed by
+    the cluster.
+
+    @param lattice pointer to the labeled lattice, as populated by
+        populate_lattice_gradient with a fully occupied first column and an
+        empty last column.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param front_columns array of size columns where the number of front
+        sites found in each column is added.
+
+    @return the number of sites in the front.
+
+    @see populate_lattice_gradient for a function that populates a gradient
+        lattice.
+*/
+int gradient_percolation_front(const int * lattice, int rows, int columns,
+                               int * front_columns);
+
 #endif /* CLUSTERS_H */
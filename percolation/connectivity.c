@@ -0,0 +1,178 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+/* see header file for detailed documentation of each function */
+
+#include "connectivity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "math_extra.h"
+
+/* smallest power of two not smaller than n */
+static int next_power_of_two(int n)
+{
+    int power;
+
+    for (power = 1; power < n; power <<= 1);
+    return power;
+}
+
+void accumulate_pair_connectivity(const int * lattice, int rows, int columns,
+                                  double * connected_pairs)
+{
+    int i;
+    int j;
+    int k;
+    int label;
+    int lattice_size;
+    int label_count;
+    int * cluster_sizes; /* size of the cluster of each label */
+    int * cluster_starts; /* position of the first site of each label in sites */
+    int * sites; /* occupied sites sorted by label */
+    int fft_rows; /* zero padded dimensions, so the transforms do not wrap around */
+    int fft_columns;
+    int fft_threshold; /* clusters larger than this are transformed */
+    int pending; /* large cluster waiting to be packed with another one */
+    int dy;
+    int dx;
+    int ky;
+    int kx;
+    double * transform; /* complex transform of up to two clusters */
+    double * power; /* sum of the power spectra of the large clusters */
+    double * mirror;
+    char any_large;
+
+    lattice_size = rows*columns;
+    label_count = lattice_size/2 + 3;
+
+    /* sort occupied sites by label */
+    cluster_sizes = (int *)calloc(label_count, sizeof(int));
+    cluster_starts = (int *)malloc(label_count*sizeof(int));
+    for (i = 0; i < lattice_size; i++) {
+        cluster_sizes[lattice[i]] += lattice[i] != 0;
+    }
+    cluster_starts[0] = 0;
+    for (label = 1; label < label_count; label++) {
+        cluster_starts[label] = cluster_starts[label - 1] + cluster_sizes[label - 1];
+    }
+    sites = (int *)malloc((cluster_starts[label_count - 1] + cluster_sizes[label_count - 1] + 1)*sizeof(int));
+    for (i = 0; i < lattice_size; i++) {
+        if (lattice[i]) {
+            sites[cluster_starts[lattice[i]]++] = i;
+        }
+    }
+    for (label = 0; label < label_count; label++) {
+        cluster_starts[label] -= cluster_sizes[label];
+    }
+
+    /* counting the pairs of a cluster directly costs its size squared */
+    fft_rows = next_power_of_two(2*rows - 1);
+    fft_columns = next_power_of_two(2*columns - 1);
+    fft_threshold = (int)sqrt(((double)fft_rows)*fft_columns*log2(((double)fft_rows)*fft_columns));
+
+    transform = NULL;
+    power = NULL;
+    pending = 0;
+    any_large = 0;
+    for (label = 2; label < label_count; label++) {
+        if (cluster_sizes[label] == 0) {
+            continue;
+        }
+
+        /* small cluster; count its pairs directly */
+        if (cluster_sizes[label] <= fft_threshold) {
+            for (i = cluster_starts[label]; i < cluster_starts[label] + cluster_sizes[label]; i++) {
+                for (j = cluster_starts[label]; j < cluster_starts[label] + cluster_sizes[label]; j++) {
+                    dy = sites[j]/columns - sites[i]/columns;
+                    dx = sites[j]%columns - sites[i]%columns;
+                    connected_pairs[(dy + rows - 1)*(2*columns - 1) + dx + columns - 1] += 1;
+                }
+            }
+            continue;
+        }
+
+        /* large cluster; pack it with the next one as real and imaginary parts */
+        if (!any_large) {
+            transform = (double *)calloc(2*fft_rows*fft_columns, sizeof(double));
+            power = (double *)calloc(2*fft_rows*fft_columns, sizeof(double));
+            any_large = 1;
+        }
+        if (!pending) {
+            pending = label;
+            continue;
+        }
+        for (k = 0; k < 2; k++) {
+            j = k == 0 ? pending : label;
+            for (i = cluster_starts[j]; i < cluster_starts[j] + cluster_sizes[j]; i++) {
+                transform[2*((sites[i]/columns)*fft_columns + sites[i]%columns) + k] = 1;
+            }
+        }
+        pending = 0;
+
+        /* the sum of the power spectra of the real and imaginary parts is the
+           symmetrized power spectrum of the packed transform */
+        fft_2d(transform, fft_rows, fft_columns, 0);
+        for (ky = 0; ky < fft_rows; ky++) {
+            for (kx = 0; kx < fft_columns; kx++) {
+                mirror = transform + 2*(((fft_rows - ky) % fft_rows)*fft_columns +
+                                        (fft_columns - kx) % fft_columns);
+                k = 2*(ky*fft_columns + kx);
+                power[k] += 0.5*(transform[k]*transform[k] + transform[k + 1]*transform[k + 1] +
+                                 mirror[0]*mirror[0] + mirror[1]*mirror[1]);
+            }
+        }
+        memset(transform, 0, 2*fft_rows*fft_columns*sizeof(double));
+    }
+
+    /* last large cluster without a partner */
+    if (pending) {
+        for (i = cluster_starts[pending]; i < cluster_starts[pending] + cluster_sizes[pending]; i++) {
+            transform[2*((sites[i]/columns)*fft_columns + sites[i]%columns)] = 1;
+        }
+        fft_2d(transform, fft_rows, fft_columns, 0);
+        for (k = 0; k < 2*fft_rows*fft_columns; k += 2) {
+            power[k] += transform[k]*transform[k] + transform[k + 1]*transform[k + 1];
+        }
+    }
+
+    /* autocorrelation of the large clusters from their total power spectrum */
+    if (any_large) {
+        fft_2d(power, fft_rows, fft_columns, 1);
+        for (dy = -(rows - 1); dy < rows; dy++) {
+            for (dx = -(columns - 1); dx < columns; dx++) {
+                k = 2*(((dy + fft_rows) % fft_rows)*fft_columns + (dx + fft_columns) % fft_columns);
+                connected_pairs[(dy + rows - 1)*(2*columns - 1) + dx + columns - 1] += round(power[k]);
+            }
+        }
+    }
+
+    free(cluster_sizes);
+    free(cluster_starts);
+    free(sites);
+    free(transform);
+    free(power);
+}
+
+int radial_pair_connectivity(const double * connected_pairs, int rows, int columns,
+                             double ** radial_connected_pairs,
+                             double ** radial_site_pairs)
+{
+    int r;
+    int dy;
+    int dx;
+    int radius_count;
+
+    radius_count = (int)round(sqrt(((double)(rows - 1))*(rows - 1) +
+                                   ((double)(columns - 1))*(columns - 1))) + 1;
+    *radial_connected_pairs = (double *)calloc(radius_count, sizeof(double));
+    *radial_site_pairs = (double *)calloc(radius_count, sizeof(double));
+    for (dy = -(rows - 1); dy < rows; dy++) {
+        for (dx = -(columns - 1); dx < columns; dx++) {
+            r = (int)round(sqrt(((double)dy)*dy + ((double)dx)*dx));
+            (*radial_connected_pairs)[r] += connected_pairs[(dy + rows - 1)*(2*columns - 1) + dx + columns - 1];
+            (*radial_site_pairs)[r] += ((double)(rows - abs(dy)))*(columns - abs(dx));
+        }
+    }
+
+    return radius_count;
+}
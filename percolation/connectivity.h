@@ -0,0 +1,62 @@
+/*!
+    @file connectivity.h
+    @brief This file contains functions to compute the two-point (pair)
+    connectivity of a labeled lattice, i.e. the probability that two sites a
+    given distance apart belong to the same cluster.
+
+    @author Federico Cerisola
+    @copyright MIT License.
+*/
+
+#ifndef CONNECTIVITY_H
+#define CONNECTIVITY_H
+
+/*! Accumulate, for every displacement, the number of pairs of sites of a
+    lattice that belong to the same cluster.
+
+    The count is the sum over clusters of the autocorrelation of the
+    indicator function of each cluster. Large clusters are handled with Fast
+    Fourier Transforms of the zero padded lattice, packing two clusters in
+    each complex transform and adding up their power spectra, so that a
+    single inverse transform per lattice gives their total autocorrelation.
+    Clusters too small for a transform to pay off have their pairs counted
+    directly.
+
+    @param lattice pointer to the lattice, with all clusters labeled.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param connected_pairs array of (2*rows - 1)*(2*columns - 1) elements
+        where the number of ordered pairs of sites (a, b) in the same cluster
+        with b - a = (dy, dx) is added at position
+        (dy + rows - 1)*(2*columns - 1) + dx + columns - 1. Every occupied
+        site is paired with itself at zero displacement.
+
+    @see label_clusters for a function that labels clusters in a lattice.
+*/
+void accumulate_pair_connectivity(const int * lattice, int rows, int columns,
+                                  double * connected_pairs);
+
+/*! Radially average the pair connectivity.
+
+    Displacements are grouped by their length rounded to the nearest
+    integer r.
+
+    @param connected_pairs array accumulated with
+        accumulate_pair_connectivity.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param radial_connected_pairs pointer where to store the array with the
+        number of connected pairs at each distance r.
+    @param radial_site_pairs pointer where to store the array with the number
+        of ordered pairs of sites of a single lattice at each distance r.
+    @return The number of distances (elements of the arrays), starting from
+        r = 0.
+
+    @warning radial_connected_pairs and radial_site_pairs must be manually
+        free'd by the user.
+*/
+int radial_pair_connectivity(const double * connected_pairs, int rows, int columns,
+                             double ** radial_connected_pairs,
+                             double ** radial_site_pairs);
+
+#endif /* CONNECTIVITY_H */
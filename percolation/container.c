@@ -0,0 +1,246 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+/* see header file for detailed documentation of each function */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "container.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <float.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "io_helpers.h"
+
+/* header at the beginning of the container */
+typedef struct {
+    char magic[8];
+    int32_t rows;
+    int32_t columns;
+    uint32_t seed;
+    int32_t grid_npoints;
+    double grid_center;
+    double grid_decay;
+    int64_t date;
+    int32_t bins_per_decade; /* logarithmic binning of the cluster sizes (0 if exact) */
+    int32_t exact_sizes;
+    char reserved[8];
+} container_header;
+
+/* header of each record */
+typedef struct {
+    char magic[4];
+    int32_t index;
+    double probability;
+    int32_t realizations;
+    int32_t length;
+    int32_t percolation_count;
+    int32_t reserved;
+} container_record_header;
+
+/* record waiting in the queue to be written */
+typedef struct container_record {
+    container_record_header header;
+    int * cluster_sizes;
+    int * cluster_sizes_counts;
+    int * cluster_sizes_percolated;
+    struct container_record * next;
+} container_record;
+
+struct sweep_container {
+    FILE * file_handler;
+    pthread_t writer; /* background thread writing the queued records */
+    pthread_mutex_t lock; /* protects the queue and the closing flag */
+    pthread_cond_t queued; /* signaled when records are queued or on closing */
+    container_record * head; /* first record to be written */
+    container_record * tail; /* last record queued */
+    char closing; /* whether no more records will be queued */
+};
+
+/* consume the queue writing each record as soon as it is available */
+static void * container_writer(void * arg)
+{
+    sweep_container * container;
+    container_record * record;
+
+    container = (sweep_container *)arg;
+    for (;;) {
+        pthread_mutex_lock(&container->lock);
+        while (!container->head && !container->closing) {
+            pthread_cond_wait(&container->queued, &container->lock);
+        }
+        record = container->head;
+        if (record) {
+            container->head = record->next;
+            if (!container->head) {
+                container->tail = NULL;
+            }
+        }
+        pthread_mutex_unlock(&container->lock);
+
+        if (!record) {
+            break;
+        }
+
+        fwrite(&record->header, sizeof(container_record_header), 1, container->file_handler);
+        fwrite(record->cluster_sizes, sizeof(int32_t), record->header.length, container->file_handler);
+        fwrite(record->cluster_sizes_counts, sizeof(int32_t), record->header.length, container->file_handler);
+        fwrite(record->cluster_sizes_percolated, sizeof(int32_t), record->header.length, container->file_handler);
+        fflush(container->file_handler);
+
+        free(record->cluster_sizes);
+        free(record->cluster_sizes_counts);
+        free(record->cluster_sizes_percolated);
+        free(record);
+    }
+
+    return NULL;
+}
+
+/* check that an existing container was written by the same run, and find
+   the end of its last complete record, dropping a record left half written
+   (e.g. by a crash); returns the end of the records, or -1 if the container
+   does not match */
+static long find_container_end(FILE * file_handler, const container_header * expected)
+{
+    long end;
+    long file_size;
+    container_header header;
+    container_record_header record;
+
+    fseek(file_handler, 0, SEEK_END);
+    file_size = ftell(file_handler);
+    rewind(file_handler);
+    if (fread(&header, sizeof(header), 1, file_handler) != 1 ||
+        memcmp(header.magic, expected->magic, 8) != 0 ||
+        header.rows != expected->rows || header.columns != expected->columns ||
+        header.seed != expected->seed || header.grid_npoints != expected->grid_npoints ||
+        header.bins_per_decade != expected->bins_per_decade ||
+        header.exact_sizes != expected->exact_sizes) {
+        return -1;
+    }
+
+    end = sizeof(header);
+    while (fread(&record, sizeof(record), 1, file_handler) == 1 &&
+           memcmp(record.magic, "REC1", 4) == 0 && record.length >= 0 &&
+           end + (long)sizeof(record) + 3L*sizeof(int32_t)*record.length <= file_size) {
+        end += sizeof(record) + 3L*sizeof(int32_t)*record.length;
+        fseek(file_handler, end, SEEK_SET);
+    }
+
+    return end;
+}
+
+sweep_container * open_sweep_container(const char * path, int rows, int columns,
+                                       unsigned int seed, int grid_points,
+                                       double probability_center, double decay,
+                                       char append)
+{
+    char * file_full_path;
+    long end; /* end of the last complete record of an appended container */
+    sweep_container * container;
+    container_header header;
+
+    file_full_path = (char *)malloc((strlen(path) + 160)*sizeof(char));
+    sprintf(file_full_path, "%s/sweep_%dx%d_%u_%.*e.pcc", path, rows, columns,
+            seed, DBL_DIG-1, (double)grid_points);
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "PERCCTR1", 8);
+    header.rows = rows;
+    header.columns = columns;
+    header.seed = seed;
+    header.grid_npoints = grid_points;
+    header.grid_center = probability_center;
+    header.grid_decay = decay;
+    header.date = time(NULL);
+    get_cluster_size_binning(&header.bins_per_decade, &header.exact_sizes);
+
+    /* an appended container keeps its header and its complete records;
+       otherwise (or if there is none yet) it is written from scratch */
+    container = (sweep_container *)malloc(sizeof(sweep_container));
+    container->file_handler = append ? fopen(file_full_path, "r+b") : NULL;
+    if (container->file_handler) {
+        end = find_container_end(container->file_handler, &header);
+        if (end < 0 || fflush(container->file_handler) != 0 ||
+            ftruncate(fileno(container->file_handler), end) != 0) {
+            fclose(container->file_handler);
+            free(file_full_path);
+            free(container);
+            return NULL;
+        }
+        fseek(container->file_handler, end, SEEK_SET);
+    } else {
+        container->file_handler = fopen(file_full_path, "wb");
+        if (container->file_handler) {
+            fwrite(&header, sizeof(header), 1, container->file_handler);
+            fflush(container->file_handler);
+        }
+    }
+    free(file_full_path);
+    if (!container->file_handler) {
+        free(container);
+        return NULL;
+    }
+
+    container->head = NULL;
+    container->tail = NULL;
+    container->closing = 0;
+    pthread_mutex_init(&container->lock, NULL);
+    pthread_cond_init(&container->queued, NULL);
+    pthread_create(&container->writer, NULL, container_writer, container);
+
+    return container;
+}
+
+void append_sweep_container(sweep_container * container, int index,
+                            sweep_point * point)
+{
+    container_record * record;
+
+    record = (container_record *)malloc(sizeof(container_record));
+    memset(&record->header, 0, sizeof(record->header));
+    memcpy(record->header.magic, "REC1", 4);
+    record->header.index = index;
+    record->header.probability = point->probability;
+    record->header.realizations = point->realizations;
+    record->header.length = point->cluster_sizes_total_count;
+    record->header.percolation_count = point->percolation_count;
+    record->cluster_sizes = point->cluster_sizes;
+    record->cluster_sizes_counts = point->cluster_sizes_counts;
+    record->cluster_sizes_percolated = point->cluster_sizes_percolated;
+    record->next = NULL;
+
+    /* the statistics now belong to the record */
+    point->cluster_sizes_total_count = 0;
+    point->cluster_sizes = NULL;
+    point->cluster_sizes_counts = NULL;
+    point->cluster_sizes_percolated = NULL;
+
+    pthread_mutex_lock(&container->lock);
+    if (container->tail) {
+        container->tail->next = record;
+    } else {
+        container->head = record;
+    }
+    container->tail = record;
+    pthread_cond_signal(&container->queued);
+    pthread_mutex_unlock(&container->lock);
+}
+
+void close_sweep_container(sweep_container * container)
+{
+    pthread_mutex_lock(&container->lock);
+    container->closing = 1;
+    pthread_cond_signal(&container->queued);
+    pthread_mutex_unlock(&container->lock);
+
+    pthread_join(container->writer, NULL);
+    pthread_mutex_destroy(&container->lock);
+    pthread_cond_destroy(&container->queued);
+    fclose(container->file_handler);
+    free(container);
+}
@@ -0,0 +1,86 @@
+/*!
+    @file container.h
+    @brief This file contains functions to write the cluster statistics of a
+    whole probability sweep to a single append-only container file.
+
+    The container starts with a fixed size header with the run parameters
+    followed by one record per grid point. Each record has a fixed size
+    header (index, probability, realizations, percolation count and number of
+    different cluster sizes) followed by the sizes, counts and percolated
+    columns, all in native byte order:
+
+        file header (64 bytes):
+            char magic[8] ("PERCCTR1"), int32 rows, int32 columns,
+            uint32 seed, int32 grid_npoints, double grid_center,
+            double grid_decay, int64 date, int32 bins_per_decade,
+            int32 exact_sizes, char reserved[8]
+        record header (32 bytes):
+            char magic[4] ("REC1"), int32 index, double probability,
+            int32 realizations, int32 length, int32 percolation_count,
+            int32 reserved
+        record data:
+            int32 sizes[length], int32 counts[length], int32 percolated[length]
+
+    Records are written by a background thread, so that the sampling never
+    waits on the filesystem, and each one is flushed as soon as it is
+    written, so the container can be read while the run is still in
+    progress. A reader should ignore a trailing record that is not complete,
+    reject any record that does not start with "REC1" and, if the same index
+    appears more than once (e.g. after resuming from
+    a checkpoint), keep the last one.
+
+    @author Federico Cerisola
+    @copyright MIT License.
+*/
+
+#ifndef CONTAINER_H
+#define CONTAINER_H
+
+#include "sweep.h"
+
+/*! Opaque handle to an open container with its writer thread. */
+typedef struct sweep_container sweep_container;
+
+/*! Open a container for the results of a probability sweep.
+
+    @param path path to the folder where the container will be written.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param seed the random number generator seed used at the beginning of the
+        probability sweep.
+    @param grid_points the number of points in the probability grid.
+    @param probability_center center of the probability grid.
+    @param decay exponential decay coefficient of the probability grid.
+    @param append boolean indicating whether to append to an existing
+        container (e.g. when resuming) instead of overwriting it. The
+        existing container must have been written with the same size, seed,
+        grid and binning; a record left incomplete at its end (e.g. by a
+        crash) is dropped before appending.
+    @return A pointer to the open container, or NULL if it could not be opened
+        (or the existing container does not match).
+*/
+sweep_container * open_sweep_container(const char * path, int rows, int columns,
+                                       unsigned int seed, int grid_points,
+                                       double probability_center, double decay,
+                                       char append);
+
+/*! Queue the results of a grid point to be appended to the container.
+
+    The cluster statistics of the point are handed over to the writer thread,
+    which frees them once written; the point is left without cluster
+    statistics but keeps its counters.
+
+    @param container pointer to the open container.
+    @param index the index of the point in the grid.
+    @param point pointer to the sweep point to be written.
+*/
+void append_sweep_container(sweep_container * container, int index,
+                            sweep_point * point);
+
+/*! Write all the pending records and close the container.
+
+    @param container pointer to the open container, which is free'd.
+*/
+void close_sweep_container(sweep_container * container);
+
+#endif /* CONTAINER_H */
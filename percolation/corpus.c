@@ -0,0 +1,306 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+/* see header file for detailed documentation of each function */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "corpus.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "clusters.h"
+
+/* header at the beginning of the corpus */
+typedef struct {
+    char magic[8];
+    int32_t rows;
+    int32_t columns;
+    uint32_t seed;
+    int32_t with_labels;
+    int64_t count;
+    int64_t index_offset;
+    char reserved[24];
+} corpus_header;
+
+/* header of each record */
+typedef struct {
+    double probability;
+    int64_t labels_size;
+} corpus_record_header;
+
+struct lattice_corpus {
+    corpus_header header;
+    FILE * file_handler; /* open for writing (NULL when reading) */
+    int64_t * offsets; /* offset of each record */
+    int64_t capacity; /* allocated size of offsets */
+    int64_t position; /* end of the last record written */
+    uint64_t * occupancy; /* scratch space for the bit-packed occupancy */
+    unsigned char * labels; /* scratch space for the compressed labels */
+    int * canonical; /* scratch space to renumber the labels */
+    const unsigned char * data; /* mapped file (NULL when writing) */
+    size_t data_size;
+};
+
+/* number of 64 bit words needed to store the occupancy */
+static int64_t occupancy_words(const corpus_header * header)
+{
+    return (((int64_t)header->rows)*header->columns + 63)/64;
+}
+
+lattice_corpus * create_lattice_corpus(const char * file_name, int rows,
+                                       int columns, unsigned int seed,
+                                       char with_labels)
+{
+    lattice_corpus * corpus;
+    int lattice_size;
+
+    corpus = (lattice_corpus *)calloc(1, sizeof(lattice_corpus));
+    corpus->file_handler = fopen(file_name, "wb");
+    if (!corpus->file_handler) {
+        free(corpus);
+        return NULL;
+    }
+
+    lattice_size = rows*columns;
+    memcpy(corpus->header.magic, "PERCCRP1", 8);
+    corpus->header.rows = rows;
+    corpus->header.columns = columns;
+    corpus->header.seed = seed;
+    corpus->header.with_labels = with_labels;
+    fwrite(&corpus->header, sizeof(corpus_header), 1, corpus->file_handler);
+    corpus->position = sizeof(corpus_header);
+
+    corpus->capacity = 1024;
+    corpus->offsets = (int64_t *)malloc(corpus->capacity*sizeof(int64_t));
+    corpus->occupancy = (uint64_t *)malloc(occupancy_words(&corpus->header)*sizeof(uint64_t));
+    if (with_labels) {
+        /* a label never takes more than 5 bytes as a variable length integer */
+        corpus->labels = (unsigned char *)malloc((5*((size_t)lattice_size) + 8)*sizeof(unsigned char));
+        corpus->canonical = (int *)malloc((lattice_size/2 + 3)*sizeof(int));
+    }
+
+    return corpus;
+}
+
+void append_lattice_corpus(lattice_corpus * corpus, const int * lattice,
+                           double probability)
+{
+    int i;
+    int lattice_size;
+    int next_label;
+    unsigned int label;
+    int64_t words;
+    int64_t padding;
+    corpus_record_header record;
+    const uint64_t zero = 0;
+
+    lattice_size = corpus->header.rows*corpus->header.columns;
+    words = occupancy_words(&corpus->header);
+
+    /* pack occupancy bits */
+    memset(corpus->occupancy, 0, words*sizeof(uint64_t));
+    for (i = 0; i < lattice_size; i++) {
+        if (lattice[i]) {
+            corpus->occupancy[i/64] |= ((uint64_t)1) << (i%64);
+        }
+    }
+
+    /* renumber clusters in order of first appearance and encode the label
+       of each occupied site as a variable length integer */
+    record.probability = probability;
+    record.labels_size = 0;
+    if (corpus->header.with_labels) {
+        for (i = 0; i < lattice_size/2 + 3; i++) {
+            corpus->canonical[i] = -1;
+        }
+        next_label = 0;
+        for (i = 0; i < lattice_size; i++) {
+            if (lattice[i] == 0) {
+                continue;
+            }
+            if (corpus->canonical[lattice[i]] < 0) {
+                corpus->canonical[lattice[i]] = next_label;
+                next_label++;
+            }
+            label = corpus->canonical[lattice[i]];
+            while (label >= 0x80) {
+                corpus->labels[record.labels_size++] = (label & 0x7f) | 0x80;
+                label >>= 7;
+            }
+            corpus->labels[record.labels_size++] = label;
+        }
+    }
+
+    if (corpus->header.count == corpus->capacity) {
+        corpus->capacity *= 2;
+        corpus->offsets = realloc(corpus->offsets, corpus->capacity*sizeof(int64_t));
+    }
+    corpus->offsets[corpus->header.count] = corpus->position;
+    corpus->header.count++;
+
+    padding = (8 - record.labels_size % 8) % 8;
+    fwrite(&record, sizeof(record), 1, corpus->file_handler);
+    fwrite(corpus->occupancy, sizeof(uint64_t), words, corpus->file_handler);
+    fwrite(corpus->labels, 1, record.labels_size, corpus->file_handler);
+    fwrite(&zero, 1, padding, corpus->file_handler);
+    corpus->position += sizeof(record) + words*sizeof(uint64_t) + record.labels_size + padding;
+}
+
+lattice_corpus * open_lattice_corpus(const char * file_name)
+{
+    int fd;
+    struct stat file_stat;
+    lattice_corpus * corpus;
+    corpus_record_header record;
+    int64_t position;
+    int64_t record_size;
+
+    fd = open(file_name, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &file_stat) != 0 || (size_t)file_stat.st_size < sizeof(corpus_header)) {
+        close(fd);
+        return NULL;
+    }
+
+    corpus = (lattice_corpus *)calloc(1, sizeof(lattice_corpus));
+    corpus->data_size = file_stat.st_size;
+    corpus->data = (const unsigned char *)mmap(NULL, corpus->data_size, PROT_READ,
+                                               MAP_SHARED, fd, 0);
+    close(fd);
+    if (corpus->data == MAP_FAILED) {
+        free(corpus);
+        return NULL;
+    }
+
+    memcpy(&corpus->header, corpus->data, sizeof(corpus_header));
+    if (memcmp(corpus->header.magic, "PERCCRP1", 8) != 0) {
+        munmap((void *)corpus->data, corpus->data_size);
+        free(corpus);
+        return NULL;
+    }
+
+    /* a corpus that was not closed has no index; rebuild it by scanning */
+    if (corpus->header.index_offset > 0) {
+        corpus->offsets = (int64_t *)(corpus->data + corpus->header.index_offset);
+    } else {
+        corpus->capacity = 1024;
+        corpus->offsets = (int64_t *)malloc(corpus->capacity*sizeof(int64_t));
+        corpus->header.count = 0;
+        position = sizeof(corpus_header);
+        while (position + (int64_t)sizeof(record) <= (int64_t)corpus->data_size) {
+            memcpy(&record, corpus->data + position, sizeof(record));
+            record_size = sizeof(record) + occupancy_words(&corpus->header)*sizeof(uint64_t) +
+                          record.labels_size + (8 - record.labels_size % 8) % 8;
+            if (position + record_size > (int64_t)corpus->data_size) {
+                break;
+            }
+            if (corpus->header.count == corpus->capacity) {
+                corpus->capacity *= 2;
+                corpus->offsets = realloc(corpus->offsets, corpus->capacity*sizeof(int64_t));
+            }
+            corpus->offsets[corpus->header.count] = position;
+            corpus->header.count++;
+            position += record_size;
+        }
+    }
+
+    return corpus;
+}
+
+long lattice_corpus_info(const lattice_corpus * corpus, int * rows, int * columns,
+                         unsigned int * seed, char * with_labels)
+{
+    if (rows) {
+        *rows = corpus->header.rows;
+    }
+    if (columns) {
+        *columns = corpus->header.columns;
+    }
+    if (seed) {
+        *seed = corpus->header.seed;
+    }
+    if (with_labels) {
+        *with_labels = corpus->header.with_labels;
+    }
+    return corpus->header.count;
+}
+
+double lattice_corpus_probability(const lattice_corpus * corpus, long index)
+{
+    corpus_record_header record;
+
+    memcpy(&record, corpus->data + corpus->offsets[index], sizeof(record));
+    return record.probability;
+}
+
+double read_lattice_corpus(const lattice_corpus * corpus, long index,
+                           int * lattice, char labeled)
+{
+    int i;
+    int lattice_size;
+    int shift;
+    unsigned int label;
+    corpus_record_header record;
+    const uint64_t * occupancy;
+    const unsigned char * labels;
+
+    lattice_size = corpus->header.rows*corpus->header.columns;
+    memcpy(&record, corpus->data + corpus->offsets[index], sizeof(record));
+    occupancy = (const uint64_t *)(corpus->data + corpus->offsets[index] + sizeof(record));
+
+    if (labeled && corpus->header.with_labels) {
+        labels = (const unsigned char *)(occupancy + occupancy_words(&corpus->header));
+        for (i = 0; i < lattice_size; i++) {
+            if (!((occupancy[i/64] >> (i%64)) & 1)) {
+                lattice[i] = 0;
+                continue;
+            }
+            label = 0;
+            shift = 0;
+            do {
+                label |= ((unsigned int)(*labels & 0x7f)) << shift;
+                shift += 7;
+            } while (*(labels++) & 0x80);
+            lattice[i] = label + 2;
+        }
+        return record.probability;
+    }
+
+    for (i = 0; i < lattice_size; i++) {
+        lattice[i] = (occupancy[i/64] >> (i%64)) & 1;
+    }
+    if (labeled) {
+        label_clusters(lattice, corpus->header.rows, corpus->header.columns);
+    }
+
+    return record.probability;
+}
+
+void close_lattice_corpus(lattice_corpus * corpus)
+{
+    if (corpus->file_handler) {
+        /* write the index at the end and update the header */
+        corpus->header.index_offset = corpus->position;
+        fwrite(corpus->offsets, sizeof(int64_t), corpus->header.count, corpus->file_handler);
+        fseek(corpus->file_handler, 0, SEEK_SET);
+        fwrite(&corpus->header, sizeof(corpus_header), 1, corpus->file_handler);
+        fclose(corpus->file_handler);
+        free(corpus->offsets);
+    } else {
+        if (corpus->header.index_offset == 0) {
+            free(corpus->offsets);
+        }
+        munmap((void *)corpus->data, corpus->data_size);
+    }
+    free(corpus->occupancy);
+    free(corpus->labels);
+    free(corpus->canonical);
+    free(corpus);
+}
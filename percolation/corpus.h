@@ -0,0 +1,113 @@
+/*!
+    @file corpus.h
+    @brief This file contains functions to store lattice realizations in a
+    compact corpus file and to replay them later without regenerating them.
+
+    The occupancy of each realization is stored bit-packed (one bit per site)
+    and, optionally, its final cluster labels are stored compressed: clusters
+    are renumbered in order of first appearance and the label of each
+    occupied site is written as a variable length integer. A corpus file is
+    laid out as:
+
+        header (64 bytes):
+            char magic[8] ("PERCCRP1"), int32 rows, int32 columns,
+            uint32 seed, int32 with_labels, int64 count, int64 index_offset,
+            char reserved[24]
+        records, each aligned to 8 bytes:
+            double probability, int64 labels_size,
+            uint64 occupancy[ceil(rows*columns/64)], uint8 labels[labels_size]
+        index (written when the corpus is closed):
+            int64 offset[count]
+
+    The file is memory-mapped for reading, so that access to any realization
+    takes constant time. If a corpus was not properly closed (and has no
+    index) the records are scanned once when opening it.
+
+    @author Federico Cerisola
+    @copyright MIT License.
+*/
+
+#ifndef CORPUS_H
+#define CORPUS_H
+
+/*! Opaque handle to a corpus open for writing or reading. */
+typedef struct lattice_corpus lattice_corpus;
+
+/*! Create a new corpus file.
+
+    @param file_name path to the corpus file. If the file exists it will be
+        overwritten.
+    @param rows the number of rows in the lattices.
+    @param columns the number of columns in the lattices.
+    @param seed the random number generator seed used to generate the lattices.
+    @param with_labels boolean indicating whether to also store the final
+        cluster labels of each realization.
+    @return A pointer to the corpus, or NULL if the file could not be created.
+*/
+lattice_corpus * create_lattice_corpus(const char * file_name, int rows,
+                                       int columns, unsigned int seed,
+                                       char with_labels);
+
+/*! Append a realization to a corpus.
+
+    @param corpus pointer to a corpus created with create_lattice_corpus.
+    @param lattice pointer to the lattice to be stored; any non zero site is
+        considered occupied. If the corpus stores labels the lattice must
+        already have all clusters labeled.
+    @param probability the probability used to populate the lattice.
+
+    @see label_clusters for a function that labels clusters in a lattice.
+*/
+void append_lattice_corpus(lattice_corpus * corpus, const int * lattice,
+                           double probability);
+
+/*! Open an existing corpus for reading.
+
+    @param file_name path to the corpus file.
+    @return A pointer to the corpus, or NULL if the file is not a valid corpus.
+*/
+lattice_corpus * open_lattice_corpus(const char * file_name);
+
+/*! Get the parameters of a corpus.
+
+    @param corpus pointer to the corpus.
+    @param rows pointer to integer where to store the number of rows.
+    @param columns pointer to integer where to store the number of columns.
+    @param seed pointer to integer where to store the seed.
+    @param with_labels pointer where to store whether labels are available.
+    @return The number of realizations in the corpus.
+*/
+long lattice_corpus_info(const lattice_corpus * corpus, int * rows, int * columns,
+                         unsigned int * seed, char * with_labels);
+
+/*! Get the probability of a realization of a corpus without reading it.
+
+    @param corpus pointer to a corpus opened with open_lattice_corpus.
+    @param index the index of the realization.
+    @return The probability used to populate the lattice, read from the
+        header of its record.
+*/
+double lattice_corpus_probability(const lattice_corpus * corpus, long index);
+
+/*! Read a realization from a corpus.
+
+    @param corpus pointer to a corpus opened with open_lattice_corpus.
+    @param index the index of the realization.
+    @param lattice pointer to the lattice where the realization will be
+        written.
+    @param labeled boolean indicating whether to return the labeled lattice.
+        If the corpus does not store labels the lattice is labeled here with
+        label_clusters; otherwise the stored labels are used (starting from
+        2, like label_clusters).
+    @return The probability used to populate the lattice.
+*/
+double read_lattice_corpus(const lattice_corpus * corpus, long index,
+                           int * lattice, char labeled);
+
+/*! Close a corpus, writing its index if it was open for writing.
+
+    @param corpus pointer to the corpus, which is free'd.
+*/
+void close_lattice_corpus(lattice_corpus * corpus);
+
+#endif /* CORPUS_H */
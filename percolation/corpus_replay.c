@@ -0,0 +1,108 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+
+/* headers */
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "lattice.h"
+#include "io_helpers.h"
+#include "sweep.h"
+#include "corpus.h"
+#include "cli.h"
+
+/* main body function */
+int main(int argc, char ** argv)
+{
+    lattice_corpus * corpus; /* stored realizations */
+    long count; /* number of realizations in the corpus */
+    int rows;
+    int columns;
+    unsigned int random_seed; /* seed used to generate the corpus */
+    int * lattice; /* lattice array */
+    int N; /* number of different probabilities in the corpus */
+    sweep_point * points; /* accumulated statistics for each probability */
+    double * probability_grid;
+    int * percolation_counts;
+    int * nrepetitions_final;
+    const char * format_option;
+    long first;
+    long n;
+    int i;
+
+    /* read optional arguments */
+    if ((format_option = extract_option(&argc, argv, "format")) &&
+        !set_output_format(format_option)) {
+        printf("--format must be either csv or binary\n");
+        return 1;
+    }
+    if (extract_flag(&argc, argv, "huge-pages") && !set_lattice_huge_pages(1)) {
+        printf("huge pages are not available, using regular pages\n");
+    }
+
+    /* read input arguments */
+    if (argc < 2) {
+        printf("usage: corpus [--format=csv|binary] [--huge-pages]\n");
+        return 1;
+    }
+    corpus = open_lattice_corpus(argv[1]);
+    if (!corpus) {
+        printf("could not open the corpus %s\n", argv[1]);
+        return 1;
+    }
+    count = lattice_corpus_info(corpus, &rows, &columns, &random_seed, NULL);
+    lattice = allocate_lattice(rows, columns, 0);
+
+    /* consecutive realizations with the same probability form one point */
+    N = 0;
+    points = NULL;
+    first = 0;
+    for (n = 1; n <= count; n++) {
+        if (n < count && lattice_corpus_probability(corpus, n) ==
+                         lattice_corpus_probability(corpus, first)) {
+            continue;
+        }
+        points = realloc(points, (N + 1)*sizeof(sweep_point));
+        sweep_point_init(&points[N], lattice_corpus_probability(corpus, first));
+        sweep_point_replay(&points[N], corpus, first, n - first, lattice);
+        write_probability_sweep_cluster_statistics_to_file("print/data",
+                                                            points[N].cluster_sizes,
+                                                            points[N].cluster_sizes_counts,
+                                                            points[N].cluster_sizes_percolated,
+                                                            points[N].cluster_sizes_total_count,
+                                                            rows, columns,
+                                                            points[N].probability,
+                                                            random_seed,
+                                                            points[N].realizations,
+                                                            0, 0, 0);
+        sweep_point_clear(&points[N]);
+        printf("replayed %ld realizations with p = %f\n", n - first, points[N].probability);
+        N++;
+        first = n;
+    }
+
+    probability_grid = (double *)malloc(N*sizeof(double));
+    percolation_counts = (int *)malloc(N*sizeof(int));
+    nrepetitions_final = (int *)malloc(N*sizeof(int));
+    for (i = 0; i < N; i++) {
+        probability_grid[i] = points[i].probability;
+        percolation_counts[i] = points[i].percolation_count;
+        nrepetitions_final[i] = points[i].realizations;
+    }
+    write_probability_sweep_percolation_probability("print/data", probability_grid,
+                                                    percolation_counts, N, 0, 0,
+                                                    nrepetitions_final, rows, columns,
+                                                    random_seed);
+    sweep_points_write_observables("print/data", points, N, 0, 0, rows, columns,
+                                   random_seed);
+
+    /* free memory before leaving */
+    close_lattice_corpus(corpus);
+    free(lattice);
+    free(points);
+    free(probability_grid);
+    free(percolation_counts);
+    free(nrepetitions_final);
+
+    return 0;
+}
@@ -11,6 +11,12 @@
 #include "lattice.h"
 #include "clusters.h"
 #include "io_helpers.h"
+#include "profiling.h"
+#include "checkpoint.h"
+#include "dispatch.h"
+#include "status.h"
+#include "cli.h"
+#include "bonds.h"
 
 /* main body function */
 int main(int argc, char ** argv)
@@ -27,6 +33,67 @@ int main(int argc, char ** argv)
     int * lattice; /* lattice array */
     char percolated; /* whether the lattice has percolated */
     int output_interval;
+    const char * checkpoint_path; /* where to periodically save the progress (NULL for none) */
+    const char * checkpoint_option;
+    time_t checkpoint_interval; /* seconds between checkpoints */
+    time_t checkpoint_time; /* when to save the next checkpoint */
+    char resume; /* whether to resume from the checkpoint */
+    int trials_done; /* number of trials already finished when resuming */
+    const char * shard_option;
+    const char * format_option;
+    int shard_index; /* index of this process when the search is split in shards */
+    int shard_count; /* number of processes the search is split in */
+    char * output_path; /* folder where the results are written */
+    char profile; /* whether to measure the time spent in each phase */
+    phase_profile run_profile; /* time spent in each phase */
+    const char * status_path; /* file where the progress is reported (NULL for none) */
+    const char * status_option;
+    double status_interval; /* seconds between rewrites of the status file */
+    run_status * status;
+    const char * tuning_path; /* file with the cached kernel choices (NULL for none) */
+    char autotune; /* whether to time the kernels missing from the tuning file */
+    char bond_percolation; /* whether bonds are populated instead of sites */
+    bond_lattice * bonds; /* open bonds of the lattice (NULL for site percolation) */
+
+    /* read optional arguments */
+    checkpoint_path = extract_option(&argc, argv, "checkpoint");
+    checkpoint_interval = 600;
+    if ((checkpoint_option = extract_option(&argc, argv, "checkpoint-interval"))) {
+        checkpoint_interval = atol(checkpoint_option);
+    }
+    resume = extract_flag(&argc, argv, "resume");
+    if (resume && !checkpoint_path) {
+        printf("--resume needs the --checkpoint file to resume from\n");
+        return 1;
+    }
+    shard_index = 0;
+    shard_count = 1;
+    if ((shard_option = extract_option(&argc, argv, "shard")) &&
+        (sscanf(shard_option, "%d/%d", &shard_index, &shard_count) != 2 ||
+         shard_index < 0 || shard_index >= shard_count)) {
+        printf("--shard must be given as INDEX/COUNT with 0 <= INDEX < COUNT\n");
+        return 1;
+    }
+    if ((format_option = extract_option(&argc, argv, "format")) &&
+        !set_output_format(format_option)) {
+        printf("--format must be either csv or binary\n");
+        return 1;
+    }
+    if (extract_flag(&argc, argv, "huge-pages") && !set_lattice_huge_pages(1)) {
+        printf("huge pages are not available, using regular pages\n");
+    }
+    profile = extract_flag(&argc, argv, "profile");
+    if (profile && !enable_profiling()) {
+        printf("hardware counters are not available, profiling wall time only\n");
+    }
+    tuning_path = extract_option(&argc, argv, "tuning");
+    autotune = extract_flag(&argc, argv, "autotune");
+    bond_percolation = extract_flag(&argc, argv, "bonds");
+    status_path = extract_option(&argc, argv, "status");
+    status_interval = 10;
+    if ((status_option = extract_option(&argc, argv, "status-interval"))) {
+        status_interval = atof(status_option);
+    }
 
     /* read input arguments; if none provided fallback to default values */
     if (argc == 4 || argc == 5) {
@@ -45,6 +112,13 @@ int main(int argc, char ** argv)
         random_seed = (unsigned int)time(NULL);
     }
 
+    /* each shard takes its share of the trials */
+    output_path = (char *)"print/data";
+    if (shard_count > 1) {
+        N = N/shard_count + (shard_index < N % shard_count);
+        output_path = create_shard_output_path(output_path, shard_index);
+    }
+
     /* initialilze variable values */
     p_critical = (double *)malloc(N*sizeof(double));
     p_critical_average = 0;
@@ -54,15 +128,68 @@ int main(int argc, char ** argv)
     /* allocate lattice without initializing its values */
     lattice = allocate_lattice(L, L, 0);
 
+    /* bonds are populated instead of sites, and the files are named after them */
+    bonds = NULL;
+    if (bond_percolation) {
+        bonds = allocate_bond_lattice(L, L);
+        set_output_lattice("bond");
+    }
+
+    /* continue from the saved state, including the random number generator */
+    trials_done = 0;
+    if (resume) {
+        if (!read_bisection_checkpoint(checkpoint_path, L, L, &random_seed,
+                                       p_critical, N, &trials_done)) {
+            printf("could not resume from checkpoint %s\n", checkpoint_path);
+            return 1;
+        }
+        for (n = 0; n < trials_done; n++) {
+            p_critical_average += p_critical[n];
+        }
+        printf("resuming from iter %d/%d\n", trials_done, N);
+    }
+    checkpoint_time = time(NULL) + checkpoint_interval;
+
+    /* pick the fastest kernels for this lattice size */
+    if (!prepare_kernel_tuning(tuning_path, autotune, L, L)) {
+        printf("could not use the tuning file %s\n", tuning_path);
+        return 1;
+    }
+
+    /* the progress is periodically reported for monitoring */
+    status = NULL;
+    if (status_path) {
+        status = open_run_status(status_path, "critical_point_bisection_search",
+                                 L, L, status_interval);
+        if (!status) {
+            printf("could not write the status file %s\n", status_path);
+            return 1;
+        }
+    }
+
     /* search critical point */
-    for (n = 0; n < N; n++) {
+    profile_init(&run_profile);
+    PROFILE_START();
+    for (n = trials_done; n < N; n++) {
         p = 0.5;
 
         for (i = 2; i <= precision; i++) {
-            srand_pcg(random_seed);
-            populate_lattice(p, lattice, L, L, 0);
-            label_clusters(lattice, L, L);
-            percolated = has_percolating_cluster(lattice, L, L);
+            srand_pcg_stream(random_seed, shard_index);
+            if (bonds) {
+                populate_bonds_nested(p, bonds, 0);
+                PROFILE_PHASE(&run_profile, PHASE_GENERATION);
+                label_bond_clusters(bonds, lattice);
+                PROFILE_PHASE(&run_profile, PHASE_LABELING);
+                percolated = has_percolating_cluster(lattice, L, L);
+                PROFILE_PHASE(&run_profile, PHASE_PERCOLATION);
+            } else {
+                /* every generation kernel draws the same sites from the
+                   same seed, so the lattices of a trial stay nested */
+                select_kernels(L, L, p);
+                dispatch_populate(p, lattice, L, L);
+                PROFILE_PHASE(&run_profile, PHASE_GENERATION);
+                percolated = dispatch_percolates(lattice, L, L, &run_profile);
+            }
             if (percolated) {
                 p = p - 1.0/pow(2, i);
             } else {
@@ -75,22 +202,53 @@ int main(int argc, char ** argv)
 
         random_seed = rand_pcg();
 
+        update_run_status(status, precision - 1, n, N,
+                          ((long)(N - n - 1))*(precision - 1), (n + 1.0)/N);
+
+        /* periodically save the progress */
+        if (checkpoint_path && time(NULL) >= checkpoint_time) {
+            if (!write_bisection_checkpoint(checkpoint_path, L, L, random_seed,
+                                            p_critical, N, n+1)) {
+                printf("WARNING: could not write the checkpoint %s ...\n", checkpoint_path);
+            }
+            checkpoint_time = time(NULL) + checkpoint_interval;
+            PROFILE_PHASE(&run_profile, PHASE_OUTPUT);
+        }
+
         /* progress report to stdout */
-        if ((n+1) % output_interval == 0) {
+        if (output_interval > 0 && (n+1) % output_interval == 0) {
             printf("finished iter %d/%d\n", n+1, N);
         }
     }
 
+    close_run_status(status);
+
     p_critical_average = p_critical_average / N;
 
     /* return estimated value and write results to file */
     printf("p critical average: %f\n", p_critical_average);
-    write_critical_point_bisection_search_results("print/data", p_critical, N,
+    PROFILE_START();
+    set_output_profile(profile ? &run_profile : NULL);
+    write_critical_point_bisection_search_results(output_path, p_critical, N,
                                                   precision, L, L, 0.5, random_seed);
+    PROFILE_PHASE(&run_profile, PHASE_OUTPUT);
+    if (profile) {
+        printf("time spent in each phase:\n");
+        print_profile(&run_profile);
+    }
 
     /* free memory before leaving */
     free(p_critical);
     free(lattice);
+    free_bond_lattice(bonds);
+    if (shard_count > 1) {
+        free(output_path);
+    }
+
+    /* the run is complete, so its checkpoint is no longer needed */
+    if (checkpoint_path) {
+        remove(checkpoint_path);
+    }
 
     return 0;
 }
@@ -0,0 +1,361 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+/* see header file for detailed documentation of each function */
+
+#include "cubic.h"
+#include <stdlib.h>
+#include <string.h>
+#include "lattice.h"
+
+/* faces of the cube touched by a cluster */
+#define FACE_X_LOW 1 /* first column */
+#define FACE_X_HIGH 2 /* last column */
+#define FACE_Y_LOW 4 /* first row */
+#define FACE_Y_HIGH 8 /* last row */
+#define FACE_Z_LOW 16 /* first plane */
+#define FACE_Z_HIGH 32 /* last plane */
+
+/* a cluster percolates if it touches both faces along some axis */
+#define SPANS(faces) ((((faces) & 3) == 3) || (((faces) & 12) == 12) || (((faces) & 48) == 48))
+
+/* a finished cluster that is not counted by size in the counts array */
+typedef struct {
+    int size;
+    char percolated;
+} finished_cluster;
+
+struct cubic_labeler {
+    int size;
+    int plane; /* index of the next plane to be labeled */
+    int * previous; /* labels of the last labeled plane */
+    int * current; /* plane being populated and labeled */
+    int labels; /* labels in use in the equivalence table */
+    int * parent; /* parent of each label (itself for the roots) */
+    int * mass; /* sites in the cluster of each root label */
+    unsigned char * faces; /* faces touched by the cluster of each root label */
+    int * renumbered; /* new label of each root that reaches the last plane (-1 otherwise) */
+    int * renumbered_mass; /* mass of the renumbered labels */
+    unsigned char * renumbered_faces; /* faces of the renumbered labels */
+    int * counts; /* finished non percolating clusters of each size up to size^2 */
+    finished_cluster * large; /* the other finished clusters (larger or percolating) */
+    int large_count;
+    int large_capacity;
+};
+
+cubic_labeler * create_cubic_labeler(int size)
+{
+    int i;
+    int area;
+    cubic_labeler * labeler;
+
+    if (size < 1 || size > CUBIC_MAX_SIZE) {
+        return NULL;
+    }
+
+    /* a plane adds at most size^2 labels to the size^2 of the previous one */
+    area = size*size;
+    labeler = (cubic_labeler *)malloc(sizeof(cubic_labeler));
+    labeler->size = size;
+    labeler->plane = 0;
+    labeler->previous = allocate_lattice(size, size, 0);
+    labeler->current = allocate_lattice(size, size, 0);
+    labeler->labels = 0;
+    labeler->parent = (int *)allocate_aligned(2*area*sizeof(int));
+    labeler->mass = (int *)allocate_aligned(2*area*sizeof(int));
+    labeler->faces = (unsigned char *)allocate_aligned(2*area*sizeof(unsigned char));
+    labeler->renumbered = (int *)allocate_aligned(2*area*sizeof(int));
+    labeler->renumbered_mass = (int *)allocate_aligned(2*area*sizeof(int));
+    labeler->renumbered_faces = (unsigned char *)allocate_aligned(2*area*sizeof(unsigned char));
+    for (i = 0; i < 2*area; i++) {
+        labeler->renumbered[i] = -1;
+    }
+    labeler->counts = (int *)allocate_aligned((area + 1)*sizeof(int));
+    memset(labeler->counts, 0, (area + 1)*sizeof(int));
+    labeler->large = NULL;
+    labeler->large_count = 0;
+    labeler->large_capacity = 0;
+
+    return labeler;
+}
+
+void free_cubic_labeler(cubic_labeler * labeler)
+{
+    if (!labeler) {
+        return;
+    }
+
+    free(labeler->previous);
+    free(labeler->current);
+    free(labeler->parent);
+    free(labeler->mass);
+    free(labeler->faces);
+    free(labeler->renumbered);
+    free(labeler->renumbered_mass);
+    free(labeler->renumbered_faces);
+    free(labeler->counts);
+    free(labeler->large);
+    free(labeler);
+}
+
+int * cubic_labeler_plane(cubic_labeler * labeler)
+{
+    return labeler->current;
+}
+
+/* root of a label, halving the path to it */
+static int find_root(int * parent, int label)
+{
+    while (parent[label] != label) {
+        parent[label] = parent[parent[label]];
+        label = parent[label];
+    }
+    return label;
+}
+
+/* merge the clusters of two labels, keeping the smaller root */
+static int link_labels(cubic_labeler * labeler, int label, int other)
+{
+    int swap;
+
+    label = find_root(labeler->parent, label);
+    other = find_root(labeler->parent, other);
+    if (label == other) {
+        return label;
+    }
+    if (other < label) {
+        swap = label;
+        label = other;
+        other = swap;
+    }
+    labeler->parent[other] = label;
+    labeler->mass[label] += labeler->mass[other];
+    labeler->faces[label] |= labeler->faces[other];
+
+    return label;
+}
+
+/* add a cluster that no further plane can reach to the statistics */
+static void finish_cluster(cubic_labeler * labeler, int mass, unsigned char faces)
+{
+    char percolated;
+
+    percolated = SPANS(faces);
+    if (!percolated && mass <= labeler->size*labeler->size) {
+        labeler->counts[mass] += 1;
+        return;
+    }
+
+    if (labeler->large_count == labeler->large_capacity) {
+        labeler->large_capacity = labeler->large_capacity > 0 ? 2*labeler->large_capacity : 16;
+        labeler->large = realloc(labeler->large,
+                                 labeler->large_capacity*sizeof(finished_cluster));
+    }
+    labeler->large[labeler->large_count].size = mass;
+    labeler->large[labeler->large_count].percolated = percolated;
+    labeler->large_count++;
+}
+
+void label_cubic_plane(cubic_labeler * labeler)
+{
+    int i;
+    int j;
+    int k;
+    int size;
+    int label;
+    int root;
+    int live; /* labels that reach this plane */
+    int * plane;
+    int * swap;
+    int * swap_mass;
+    unsigned char * swap_faces;
+    unsigned char plane_faces;
+    unsigned char row_faces;
+
+    size = labeler->size;
+    plane = labeler->current;
+    plane_faces = (labeler->plane == 0 ? FACE_Z_LOW : 0) |
+                  (labeler->plane == size - 1 ? FACE_Z_HIGH : 0);
+
+    /* link every occupied site to its left and upper neighbors in this plane
+       and to the one below it in the previous plane */
+    for (i = 0; i < size; i++) {
+        row_faces = plane_faces | (i == 0 ? FACE_Y_LOW : 0) | (i == size - 1 ? FACE_Y_HIGH : 0);
+        for (j = 0; j < size; j++) {
+            k = i*size + j;
+            if (!plane[k]) {
+                continue;
+            }
+
+            label = -1;
+            if (j > 0 && plane[k-1]) {
+                label = plane[k-1] - 2;
+            }
+            if (i > 0 && plane[k-size]) {
+                label = label < 0 ? plane[k-size] - 2 :
+                                    link_labels(labeler, label, plane[k-size] - 2);
+            }
+            if (labeler->plane > 0 && labeler->previous[k]) {
+                label = label < 0 ? labeler->previous[k] - 2 :
+                                    link_labels(labeler, label, labeler->previous[k] - 2);
+            }
+            if (label < 0) {
+                label = labeler->labels++;
+                labeler->parent[label] = label;
+                labeler->mass[label] = 0;
+                labeler->faces[label] = 0;
+            } else {
+                label = find_root(labeler->parent, label);
+            }
+
+            labeler->mass[label] += 1;
+            labeler->faces[label] |= row_faces | (j == 0 ? FACE_X_LOW : 0) |
+                                     (j == size - 1 ? FACE_X_HIGH : 0);
+            plane[k] = label + 2;
+        }
+    }
+
+    labeler->plane++;
+    swap = labeler->previous;
+    labeler->previous = labeler->current;
+    labeler->current = swap;
+
+    /* after the last plane every cluster is finished */
+    if (labeler->plane == size) {
+        for (label = 0; label < labeler->labels; label++) {
+            if (labeler->parent[label] == label) {
+                finish_cluster(labeler, labeler->mass[label], labeler->faces[label]);
+            }
+        }
+        labeler->labels = 0;
+        return;
+    }
+
+    /* renumber the labels that reach this plane in order of appearance, so
+       the table only keeps them */
+    live = 0;
+    for (k = 0; k < size*size; k++) {
+        if (!plane[k]) {
+            continue;
+        }
+        root = find_root(labeler->parent, plane[k] - 2);
+        if (labeler->renumbered[root] < 0) {
+            labeler->renumbered[root] = live;
+            labeler->renumbered_mass[live] = labeler->mass[root];
+            labeler->renumbered_faces[live] = labeler->faces[root];
+            live++;
+        }
+        plane[k] = labeler->renumbered[root] + 2;
+    }
+
+    /* the clusters that do not reach this plane are finished */
+    for (label = 0; label < labeler->labels; label++) {
+        if (labeler->parent[label] == label && labeler->renumbered[label] < 0) {
+            finish_cluster(labeler, labeler->mass[label], labeler->faces[label]);
+        }
+        labeler->renumbered[label] = -1;
+    }
+
+    for (label = 0; label < live; label++) {
+        labeler->parent[label] = label;
+    }
+    swap_mass = labeler->mass;
+    labeler->mass = labeler->renumbered_mass;
+    labeler->renumbered_mass = swap_mass;
+    swap_faces = labeler->faces;
+    labeler->faces = labeler->renumbered_faces;
+    labeler->renumbered_faces = swap_faces;
+    labeler->labels = live;
+}
+
+static int compare_finished_clusters(const void * a, const void * b)
+{
+    const finished_cluster * cluster_a = (const finished_cluster *)a;
+    const finished_cluster * cluster_b = (const finished_cluster *)b;
+
+    return (cluster_a->size > cluster_b->size) - (cluster_a->size < cluster_b->size);
+}
+
+/* append a size to the statistics arrays, merging it with the last one if
+   they are equal */
+static void append_cluster_size(int size, int count, int percolated,
+                                int * cluster_sizes_total_count, int * cluster_sizes,
+                                int * cluster_sizes_counts, int * cluster_sizes_percolated)
+{
+    int last;
+
+    last = *cluster_sizes_total_count - 1;
+    if (last >= 0 && cluster_sizes[last] == size) {
+        cluster_sizes_counts[last] += count;
+        cluster_sizes_percolated[last] += percolated;
+        return;
+    }
+    cluster_sizes[last + 1] = size;
+    cluster_sizes_counts[last + 1] = count;
+    cluster_sizes_percolated[last + 1] = percolated;
+    *cluster_sizes_total_count += 1;
+}
+
+void cubic_cluster_statistics(cubic_labeler * labeler,
+                              int * cluster_sizes_total_count,
+                              int ** cluster_sizes, int ** cluster_sizes_counts,
+                              int ** cluster_sizes_percolated)
+{
+    int j;
+    int size;
+    int area;
+    int different_sizes;
+
+    area = labeler->size*labeler->size;
+    different_sizes = labeler->large_count;
+    for (size = 1; size <= area; size++) {
+        different_sizes += labeler->counts[size] > 0;
+    }
+    qsort(labeler->large, labeler->large_count, sizeof(finished_cluster),
+          compare_finished_clusters);
+
+    /* merge the counted sizes with the other clusters, in increasing order */
+    *cluster_sizes_total_count = 0;
+    *cluster_sizes = (int *)malloc((different_sizes + 1)*sizeof(int));
+    *cluster_sizes_counts = (int *)malloc((different_sizes + 1)*sizeof(int));
+    *cluster_sizes_percolated = (int *)malloc((different_sizes + 1)*sizeof(int));
+    j = 0;
+    for (size = 1; size <= area; size++) {
+        for (; j < labeler->large_count && labeler->large[j].size <= size; j++) {
+            append_cluster_size(labeler->large[j].size, 1, labeler->large[j].percolated,
+                                cluster_sizes_total_count, *cluster_sizes,
+                                *cluster_sizes_counts, *cluster_sizes_percolated);
+        }
+        if (labeler->counts[size] > 0) {
+            append_cluster_size(size, labeler->counts[size], 0,
+                                cluster_sizes_total_count, *cluster_sizes,
+                                *cluster_sizes_counts, *cluster_sizes_percolated);
+            labeler->counts[size] = 0;
+        }
+    }
+    for (; j < labeler->large_count; j++) {
+        append_cluster_size(labeler->large[j].size, 1, labeler->large[j].percolated,
+                            cluster_sizes_total_count, *cluster_sizes,
+                            *cluster_sizes_counts, *cluster_sizes_percolated);
+    }
+
+    /* start the next lattice */
+    labeler->plane = 0;
+    labeler->labels = 0;
+    labeler->large_count = 0;
+}
+
+void sample_cubic_lattice(cubic_labeler * labeler, double probability,
+                          int * cluster_sizes_total_count, int ** cluster_sizes,
+                          int ** cluster_sizes_counts, int ** cluster_sizes_percolated)
+{
+    int k;
+
+    for (k = 0; k < labeler->size; k++) {
+        populate_lattice(probability, cubic_labeler_plane(labeler), labeler->size,
+                         labeler->size, 0);
+        label_cubic_plane(labeler);
+    }
+
+    cubic_cluster_statistics(labeler, cluster_sizes_total_count, cluster_sizes,
+                             cluster_sizes_counts, cluster_sizes_percolated);
+}
@@ -0,0 +1,114 @@
+/*!
+    @file cubic.h
+    @brief This file contains functions to label the clusters of site
+    percolation on simple cubic lattices, streaming the lattice one plane at
+    a time.
+
+    A cubic lattice of side L is never stored whole (as int, L = 1024 would
+    take 4 GB): its planes are populated and labeled one after the other,
+    with a Hoshen-Kopelman pass that links each site to its left and upper
+    neighbors in the same plane and to the site below it in the previous
+    plane. Only two planes of labels and the equivalence table of the labels
+    still present in the last plane are kept. After each plane the clusters
+    that do not reach it are finished, so their size is added to the
+    statistics of the lattice and their labels are recycled; the table is
+    renumbered to the labels of the plane, so it never holds more than
+    2 L^2 entries.
+
+    A cluster percolates when it touches two opposite faces of the cube,
+    along any of the three axes (as in two dimensions, where it may span
+    either the rows or the columns).
+
+    @author Federico Cerisola
+    @copyright MIT License.
+*/
+
+#ifndef CUBIC_H
+#define CUBIC_H
+
+/*! Largest side of the cubic lattices, so that the cluster sizes fit in an
+    int. */
+#define CUBIC_MAX_SIZE 1290
+
+/*! Opaque handle to the planes and equivalence table of a cubic lattice
+    being labeled. */
+typedef struct cubic_labeler cubic_labeler;
+
+/*! Allocate the planes and tables to label cubic lattices.
+
+    @param size the side L of the cubic lattices (at most CUBIC_MAX_SIZE).
+    @return A pointer to the newly allocated labeler, or NULL if the size is
+        not valid.
+*/
+cubic_labeler * create_cubic_labeler(int size);
+
+/*! Free a labeler.
+
+    @param labeler pointer to the labeler.
+*/
+void free_cubic_labeler(cubic_labeler * labeler);
+
+/*! Get the plane where the next plane of the lattice has to be populated.
+
+    @param labeler pointer to the labeler.
+    @return A pointer to a size*size lattice, to be populated with 1 for the
+        occupied sites and 0 for the empty ones before calling
+        label_cubic_plane.
+*/
+int * cubic_labeler_plane(cubic_labeler * labeler);
+
+/*! Label the plane populated in cubic_labeler_plane, linking it to the
+    previous one, and finish the clusters that do not reach it.
+
+    After labeling, the plane holds the labels of its sites (starting at 2),
+    which are only valid until the next plane is labeled.
+
+    @param labeler pointer to the labeler.
+*/
+void label_cubic_plane(cubic_labeler * labeler);
+
+/*! Get the cluster statistics of a lattice once all of its planes have been
+    labeled, and start the next lattice.
+
+    @param labeler pointer to the labeler.
+    @param cluster_sizes_total_count pointer to integer where to store the
+        total number of different cluster sizes present in the lattice.
+    @param cluster_sizes array where to store the sizes of the clusters, in
+        increasing order.
+    @param cluster_sizes_counts array where to store the number of clusters
+        of each size.
+    @param cluster_sizes_percolated array where to store the number of
+        percolating clusters of each size.
+
+    @warning The arrays must be manually free'd by the user.
+    @see cluster_statistics for the same statistics of a square lattice.
+*/
+void cubic_cluster_statistics(cubic_labeler * labeler,
+                              int * cluster_sizes_total_count,
+                              int ** cluster_sizes, int ** cluster_sizes_counts,
+                              int ** cluster_sizes_percolated);
+
+/*! Populate a cubic lattice plane by plane with the given probability,
+    label it and get its cluster statistics.
+
+    The planes are populated with populate_lattice, so the lattice is the
+    same as populating its size^3 sites at once, plane after plane in
+    row-major order.
+
+    @param labeler pointer to the labeler.
+    @param probability the probability of each site to be occupied.
+    @param cluster_sizes_total_count pointer to integer where to store the
+        total number of different cluster sizes present in the lattice.
+    @param cluster_sizes array where to store the sizes of the clusters.
+    @param cluster_sizes_counts array where to store the number of clusters
+        of each size.
+    @param cluster_sizes_percolated array where to store the number of
+        percolating clusters of each size.
+
+    @warning The arrays must be manually free'd by the user.
+*/
+void sample_cubic_lattice(cubic_labeler * labeler, double probability,
+                          int * cluster_sizes_total_count, int ** cluster_sizes,
+                          int ** cluster_sizes_counts, int ** cluster_sizes_percolated);
+
+#endif /* CUBIC_H */
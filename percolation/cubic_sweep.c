@@ -0,0 +1,138 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+
+/* headers */
+#include <stdlib.h>
+#include <time.h>
+#include <stdio.h>
+
+#include "random.h"
+#include "math_extra.h"
+#include "lattice.h"
+#include "io_helpers.h"
+#include "cubic.h"
+#include "sweep.h"
+#include "status.h"
+#include "cli.h"
+
+/* sample a cubic lattice with the labeler given as data */
+static void sample_cubic_realization(void * data, double probability,
+                                     int * cluster_sizes_total_count,
+                                     int ** cluster_sizes, int ** cluster_sizes_counts,
+                                     int ** cluster_sizes_percolated)
+{
+    sample_cubic_lattice((cubic_labeler *)data, probability, cluster_sizes_total_count,
+                         cluster_sizes, cluster_sizes_counts, cluster_sizes_percolated);
+}
+
+/* main body function */
+int main(int argc, char ** argv)
+{
+    int L; /* side of the cubic lattice */
+    unsigned int random_seed; /* random number generator seed */
+    int N; /* number of discrete probability value to tests */
+    double probability_center; /* value where to center the discrete probability values grid */
+    double decay; /* exponential decay coefficient of the probability grid */
+    int grid_rounding_digits; /* to how many digits should the probabilities in the grid be rounded to */
+    double * probability_grid; /* discrete grid of probability values to test */
+    int nrepetitions; /* the number of repetitions to take for each probability */
+    cubic_labeler * labeler; /* planes and equivalence table of the lattice being labeled */
+    sweep_point * points; /* accumulated statistics for each probability */
+    const char * format_option;
+    const char * bins_option;
+    const char * status_path; /* file where the progress is reported (NULL for none) */
+    const char * status_option;
+    int bins_per_decade; /* logarithmic bins per decade of the cluster sizes (0 if exact) */
+    int exact_sizes; /* largest cluster size that is not binned */
+    double status_interval; /* minimum seconds between rewrites of the status file */
+    run_status * status; /* status file of the run (NULL if none) */
+    int i;
+
+    /* read optional arguments */
+    if ((format_option = extract_option(&argc, argv, "format")) &&
+        !set_output_format(format_option)) {
+        printf("--format must be either csv or binary\n");
+        return 1;
+    }
+    if (extract_flag(&argc, argv, "huge-pages") && !set_lattice_huge_pages(1)) {
+        printf("huge pages are not available, using regular pages\n");
+    }
+    bins_per_decade = 0;
+    exact_sizes = 10;
+    if ((bins_option = extract_option(&argc, argv, "log-bins"))) {
+        bins_per_decade = atoi(bins_option);
+    }
+    if ((bins_option = extract_option(&argc, argv, "exact-sizes"))) {
+        exact_sizes = atoi(bins_option);
+    }
+    if (bins_per_decade > 0) {
+        exact_sizes = sweep_set_log_bins(bins_per_decade, exact_sizes);
+        set_cluster_size_binning(bins_per_decade, exact_sizes);
+    }
+    status_path = extract_option(&argc, argv, "status");
+    status_interval = 10;
+    if ((status_option = extract_option(&argc, argv, "status-interval"))) {
+        status_interval = atof(status_option);
+    }
+
+    /* read input arguments */
+    if (argc < 7) {
+        printf("usage: L ngrid pcenter decay rounding nrepetitions (seed)"
+               " [--format=csv|binary] [--huge-pages] [--log-bins=B] [--exact-sizes=S]"
+               " [--status=FILE] [--status-interval=SECONDS]\n");
+        return 1;
+    }
+    L = atoi(argv[1]);
+    N = atoi(argv[2]);
+    probability_center = atof(argv[3]);
+    decay = atof(argv[4]);
+    grid_rounding_digits = atoi(argv[5]);
+    nrepetitions = atoi(argv[6]);
+    if (argc == 8) {
+        random_seed = atoi(argv[7]);
+    } else {
+        random_seed = (unsigned int)time(NULL);
+    }
+    if (L < 1 || L > CUBIC_MAX_SIZE) {
+        printf("L must be between 1 and %d\n", CUBIC_MAX_SIZE);
+        return 1;
+    }
+
+    /* initialize remaining variables */
+    probability_grid = create_exponential_centered_grid(0, 1, probability_center, N, decay, grid_rounding_digits);
+    points = (sweep_point *)malloc(N*sizeof(sweep_point));
+    for (i = 0; i < N; i++) {
+        sweep_point_init(&points[i], probability_grid[i]);
+    }
+
+    srand_pcg(random_seed);
+
+    /* allocate the two planes that are kept of each lattice */
+    labeler = create_cubic_labeler(L);
+
+    status = NULL;
+    if (status_path) {
+        status = open_run_status(status_path, "cubic_sweep", L, L*L, status_interval);
+        if (!status) {
+            printf("could not write the status file %s\n", status_path);
+            return 1;
+        }
+    }
+
+    /* the files are named after the three sides of the lattice */
+    set_output_depth(L);
+
+    /* calculate cluster statistics per probability */
+    sweep_points_run(points, N, probability_center, decay, nrepetitions,
+                     sample_cubic_realization, labeler, ((long)L)*L*L, L, L,
+                     random_seed, status);
+
+    close_run_status(status);
+
+    /* free memory before leaving */
+    free_cubic_labeler(labeler);
+    free(points);
+    free(probability_grid);
+
+    return 0;
+}
@@ -0,0 +1,375 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+/* see header file for detailed documentation of each function */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "dispatch.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "random.h"
+#include "lattice.h"
+#include "clusters.h"
+
+/* lattices are timed in batches of at least this many sites */
+#define TUNING_BATCH_SITES 65536
+
+typedef void (*generation_function)(double probability, int * lattice,
+                                    int rows, int columns, unsigned int seed);
+typedef void (*labeling_function)(int * lattice, int rows, int columns);
+
+static const generation_function generation_functions[GENERATION_KERNELS] = {
+    populate_lattice,
+    populate_lattice_threshold
+};
+
+static const char * generation_names[GENERATION_KERNELS] = {
+    "populate_lattice",
+    "populate_lattice_threshold"
+};
+
+static const labeling_function labeling_functions[LABELING_KERNELS] = {
+    label_clusters,
+    label_clusters_runs
+};
+
+static const char * labeling_names[LABELING_KERNELS] = {
+    "label_clusters",
+    "label_clusters_runs"
+};
+
+static const char * spanning_names[SPANNING_KERNELS] = {
+    "has_percolating_cluster",
+    "lattice_percolates"
+};
+
+/* kinds of kernels timed when tuning */
+enum kernel_family {
+    FAMILY_GENERATION,
+    FAMILY_LABELING,
+    FAMILY_SPANNING
+};
+
+/* probabilities at which the kernels are timed for each lattice size */
+static const double tuning_probabilities[] = {0.05, 0.2, 0.4, 0.5, 0.6, 0.8, 0.95};
+
+/* fastest kernels for a lattice size and probability */
+typedef struct {
+    int rows;
+    int columns;
+    double probability;
+    int generation;
+    int labeling;
+    int spanning;
+    char reported; /* whether the choice was printed when first used */
+} tuning_cell;
+
+static tuning_cell * tuning_cells = NULL;
+static int tuning_cells_count = 0;
+
+/* kernels used by the dispatch functions */
+static int selected_generation = GENERATION_BERNOULLI;
+static int selected_labeling = LABELING_HOSHEN_KOPELMAN;
+static int selected_spanning = SPANNING_LABELS;
+
+static int kernel_index(const char ** names, int count, const char * name)
+{
+    int k;
+
+    for (k = 0; k < count; k++) {
+        if (strcmp(names[k], name) == 0) {
+            return k;
+        }
+    }
+    return -1;
+}
+
+static tuning_cell * find_tuning_cell(int rows, int columns, double probability)
+{
+    int k;
+
+    for (k = 0; k < tuning_cells_count; k++) {
+        if (tuning_cells[k].rows == rows && tuning_cells[k].columns == columns &&
+            fabs(tuning_cells[k].probability - probability) < 1e-9) {
+            return &tuning_cells[k];
+        }
+    }
+    return NULL;
+}
+
+static void add_tuning_cell(const tuning_cell * cell)
+{
+    tuning_cell * existing;
+
+    existing = find_tuning_cell(cell->rows, cell->columns, cell->probability);
+    if (existing) {
+        *existing = *cell;
+        return;
+    }
+    tuning_cells = realloc(tuning_cells, (tuning_cells_count + 1)*sizeof(tuning_cell));
+    tuning_cells[tuning_cells_count++] = *cell;
+}
+
+char load_kernel_tuning(const char * path)
+{
+    FILE * file_handler;
+    char line[256];
+    char generation[64];
+    char labeling[64];
+    char spanning[64];
+    tuning_cell cell;
+
+    file_handler = fopen(path, "r");
+    if (!file_handler) {
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), file_handler)) {
+        /* header lines and kernels unknown to this build are skipped */
+        if (sscanf(line, "%d,%d,%lf,%63[^,],%63[^,],%63s", &cell.rows, &cell.columns,
+                   &cell.probability, generation, labeling, spanning) != 6) {
+            continue;
+        }
+        cell.generation = kernel_index(generation_names, GENERATION_KERNELS, generation);
+        cell.labeling = kernel_index(labeling_names, LABELING_KERNELS, labeling);
+        cell.spanning = kernel_index(spanning_names, SPANNING_KERNELS, spanning);
+        if (cell.generation < 0 || cell.labeling < 0 || cell.spanning < 0) {
+            continue;
+        }
+        cell.reported = 0;
+        add_tuning_cell(&cell);
+    }
+
+    fclose(file_handler);
+
+    return 1;
+}
+
+char save_kernel_tuning(const char * path)
+{
+    FILE * file_handler;
+    int k;
+
+    file_handler = fopen(path, "w");
+    if (!file_handler) {
+        return 0;
+    }
+
+    fprintf(file_handler, ";kernel_tuning\n");
+    fprintf(file_handler, "rows,columns,probability,generation,labeling,spanning\n");
+    for (k = 0; k < tuning_cells_count; k++) {
+        fprintf(file_handler, "%d,%d,%g,%s,%s,%s\n", tuning_cells[k].rows,
+                tuning_cells[k].columns, tuning_cells[k].probability,
+                generation_names[tuning_cells[k].generation],
+                labeling_names[tuning_cells[k].labeling],
+                spanning_names[tuning_cells[k].spanning]);
+    }
+
+    return fclose(file_handler) == 0;
+}
+
+static double elapsed_seconds(const struct timespec * start)
+{
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec)*1e-9;
+}
+
+/* fastest of the given number of runs of a kernel over a batch of lattices;
+   populated holds the input of the kernels that need one */
+static double time_kernel(enum kernel_family family, int kernel, double probability,
+                          const int * populated, int * work, int rows,
+                          int columns, int batch, int repetitions)
+{
+    int n;
+    int k;
+    long sites;
+    double seconds;
+    double fastest;
+    struct timespec start;
+
+    sites = ((long)rows)*columns;
+    fastest = INFINITY;
+    /* the first run is a warm up and is not timed */
+    for (n = 0; n <= repetitions; n++) {
+        if (family != FAMILY_GENERATION) {
+            memcpy(work, populated, batch*sites*sizeof(int));
+        }
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (k = 0; k < batch; k++) {
+            if (family == FAMILY_GENERATION) {
+                generation_functions[kernel](probability, work + k*sites, rows, columns, 0);
+            } else if (family == FAMILY_LABELING) {
+                labeling_functions[kernel](work + k*sites, rows, columns);
+            } else if (kernel == SPANNING_LABELS) {
+                labeling_functions[selected_labeling](work + k*sites, rows, columns);
+                has_percolating_cluster(work + k*sites, rows, columns);
+            } else {
+                lattice_percolates(work + k*sites, rows, columns);
+            }
+        }
+        seconds = elapsed_seconds(&start);
+        if (n > 0 && seconds < fastest) {
+            fastest = seconds;
+        }
+    }
+
+    return fastest;
+}
+
+void tune_kernels(int rows, int columns, int repetitions)
+{
+    int i;
+    int k;
+    int batch;
+    long sites;
+    int * populated;
+    int * work;
+    double seconds;
+    double fastest;
+    int labeling; /* selected labeling kernel, changed while tuning */
+    tuning_cell cell;
+    pcg32_random_t rng;
+
+    sites = ((long)rows)*columns;
+    batch = TUNING_BATCH_SITES/sites > 1 ? TUNING_BATCH_SITES/sites : 1;
+    populated = (int *)malloc(batch*sites*sizeof(int));
+    work = (int *)malloc(batch*sites*sizeof(int));
+    get_state_pcg(&rng);
+    labeling = selected_labeling;
+
+    for (i = 0; i < (int)(sizeof(tuning_probabilities)/sizeof(double)); i++) {
+        if (find_tuning_cell(rows, columns, tuning_probabilities[i])) {
+            continue;
+        }
+        cell.rows = rows;
+        cell.columns = columns;
+        cell.probability = tuning_probabilities[i];
+        cell.reported = 0;
+        for (k = 0; k < batch; k++) {
+            populate_lattice(cell.probability, populated + k*sites, rows, columns, 0);
+        }
+
+        fastest = INFINITY;
+        for (k = 0; k < GENERATION_KERNELS; k++) {
+            seconds = time_kernel(FAMILY_GENERATION, k, cell.probability, populated, work,
+                                  rows, columns, batch, repetitions);
+            if (seconds < fastest) {
+                fastest = seconds;
+                cell.generation = k;
+            }
+        }
+        fastest = INFINITY;
+        for (k = 0; k < LABELING_KERNELS; k++) {
+            seconds = time_kernel(FAMILY_LABELING, k, cell.probability, populated, work,
+                                  rows, columns, batch, repetitions);
+            if (seconds < fastest) {
+                fastest = seconds;
+                cell.labeling = k;
+            }
+        }
+        /* spanning through labels uses the labeling kernel just chosen */
+        selected_labeling = cell.labeling;
+        fastest = INFINITY;
+        for (k = 0; k < SPANNING_KERNELS; k++) {
+            seconds = time_kernel(FAMILY_SPANNING, k, cell.probability, populated, work,
+                                  rows, columns, batch, repetitions);
+            if (seconds < fastest) {
+                fastest = seconds;
+                cell.spanning = k;
+            }
+        }
+
+        printf("tuned %dx%d at p = %g: %s, %s, %s\n", rows, columns,
+               cell.probability, generation_names[cell.generation],
+               labeling_names[cell.labeling], spanning_names[cell.spanning]);
+        add_tuning_cell(&cell);
+    }
+
+    selected_labeling = labeling;
+    set_state_pcg(&rng);
+    free(populated);
+    free(work);
+}
+
+char prepare_kernel_tuning(const char * path, char tune, int rows, int columns)
+{
+    if (path && !load_kernel_tuning(path) && !tune) {
+        return 0;
+    }
+    if (tune) {
+        tune_kernels(rows, columns, 3);
+        if (path) {
+            return save_kernel_tuning(path);
+        }
+    }
+    return 1;
+}
+
+void select_kernels(int rows, int columns, double probability)
+{
+    int k;
+    tuning_cell * nearest;
+
+    nearest = NULL;
+    for (k = 0; k < tuning_cells_count; k++) {
+        if (tuning_cells[k].rows != rows || tuning_cells[k].columns != columns) {
+            continue;
+        }
+        if (!nearest || fabs(tuning_cells[k].probability - probability) <
+                        fabs(nearest->probability - probability)) {
+            nearest = &tuning_cells[k];
+        }
+    }
+    if (!nearest) {
+        selected_generation = GENERATION_BERNOULLI;
+        selected_labeling = LABELING_HOSHEN_KOPELMAN;
+        selected_spanning = SPANNING_LABELS;
+        return;
+    }
+
+    if (!nearest->reported) {
+        printf("using %s, %s and %s for %dx%d near p = %g\n",
+               generation_names[nearest->generation],
+               labeling_names[nearest->labeling],
+               spanning_names[nearest->spanning], rows, columns,
+               nearest->probability);
+        nearest->reported = 1;
+    }
+    selected_generation = nearest->generation;
+    selected_labeling = nearest->labeling;
+    selected_spanning = nearest->spanning;
+}
+
+void dispatch_populate(double probability, int * lattice, int rows, int columns)
+{
+    generation_functions[selected_generation](probability, lattice, rows, columns, 0);
+}
+
+void dispatch_label(int * lattice, int rows, int columns)
+{
+    labeling_functions[selected_labeling](lattice, rows, columns);
+}
+
+char dispatch_percolates(int * lattice, int rows, int columns,
+                         phase_profile * profile)
+{
+    char percolated;
+
+    if (selected_spanning == SPANNING_FLOOD) {
+        percolated = lattice_percolates(lattice, rows, columns);
+        PROFILE_PHASE(profile, PHASE_PERCOLATION);
+        return percolated;
+    }
+
+    labeling_functions[selected_labeling](lattice, rows, columns);
+    PROFILE_PHASE(profile, PHASE_LABELING);
+    percolated = has_percolating_cluster(lattice, rows, columns);
+    PROFILE_PHASE(profile, PHASE_PERCOLATION);
+
+    return percolated;
+}
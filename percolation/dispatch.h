@@ -0,0 +1,141 @@
+/*!
+    @file dispatch.h
+    @brief This file contains a dispatch layer that picks the fastest
+    generation, labeling and spanning kernels for each lattice size and
+    occupation probability.
+
+    Which kernel is fastest depends on the regime: labeling whole runs pays
+    off in dense lattices, and flooding from the borders is cheaper than
+    labeling when only spanning matters. The candidates are timed on representative
+    probabilities for the lattice size of a run (or the choices are read from
+    a cached tuning file), and then the kernels tuned for the nearest
+    probability are used at every point of the run.
+
+    Until a size is tuned the original kernels (populate_lattice,
+    label_clusters and has_percolating_cluster) are used. Since the
+    generation kernels draw the same lattices, tuned runs give the same
+    results as untuned ones for a given seed.
+
+    @author Federico Cerisola
+    @copyright MIT License.
+*/
+
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include "profiling.h"
+
+/*! Candidate kernels to populate lattices.
+
+    Only kernels that draw exactly the same lattice from the same random
+    numbers are candidates, so the kernel choices never change the
+    realizations of a seed, nor the nesting of the lattices drawn at
+    different probabilities from the same seed (as in the bisection search).
+    populate_lattice_sparse is therefore not dispatched.
+*/
+enum generation_kernel {
+    GENERATION_BERNOULLI = 0, /*!< populate_lattice */
+    GENERATION_THRESHOLD, /*!< populate_lattice_threshold */
+    GENERATION_KERNELS
+};
+
+/*! Candidate kernels to label clusters. */
+enum labeling_kernel {
+    LABELING_HOSHEN_KOPELMAN = 0, /*!< label_clusters */
+    LABELING_RUNS, /*!< label_clusters_runs */
+    LABELING_KERNELS
+};
+
+/*! Candidate kernels to find whether a lattice percolates. */
+enum spanning_kernel {
+    SPANNING_LABELS = 0, /*!< labeling followed by has_percolating_cluster */
+    SPANNING_FLOOD, /*!< lattice_percolates */
+    SPANNING_KERNELS
+};
+
+/*! Read the kernel choices saved by save_kernel_tuning.
+
+    @param path path to the tuning file.
+    @return A boolean indicating whether the file could be read.
+*/
+char load_kernel_tuning(const char * path);
+
+/*! Save the kernel choices of every tuned size and probability.
+
+    @param path path to the tuning file. If the file exists it will be
+        overwritten.
+    @return A boolean indicating whether the file was written.
+*/
+char save_kernel_tuning(const char * path);
+
+/*! Time every candidate kernel for a lattice size at each representative
+    probability that was not tuned yet, keeping the fastest ones.
+
+    The state of the global random number generator is restored afterwards,
+    so tuning does not change the realizations drawn by the run. The choices
+    are printed to stdout.
+
+    @param rows the number of rows of the lattices.
+    @param columns the number of columns of the lattices.
+    @param repetitions number of timed runs of each kernel (the fastest one is
+        kept).
+*/
+void tune_kernels(int rows, int columns, int repetitions);
+
+/*! Read the cached choices, tune the missing ones and save them, as
+    requested by the command line of a program.
+
+    @param path path to the tuning file, or NULL for none.
+    @param tune whether to time the kernels that are not in the tuning file.
+    @param rows the number of rows of the lattices.
+    @param columns the number of columns of the lattices.
+    @return A boolean indicating whether the tuning file could be read (when
+        not tuning) and written (when tuning).
+*/
+char prepare_kernel_tuning(const char * path, char tune, int rows, int columns);
+
+/*! Select the kernels used by the dispatch functions, from those tuned for
+    the nearest probability with the same lattice size.
+
+    The choices of each tuned size and probability are printed to stdout the
+    first time they are used.
+
+    @param rows the number of rows of the lattices.
+    @param columns the number of columns of the lattices.
+    @param probability the occupation probability of the lattices.
+*/
+void select_kernels(int rows, int columns, double probability);
+
+/*! Populate a lattice with the selected generation kernel.
+
+    @param probability the probability of each site to be occupied.
+    @param lattice a pointer to the lattice to be populated.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+*/
+void dispatch_populate(double probability, int * lattice, int rows, int columns);
+
+/*! Label the clusters of a lattice with the selected labeling kernel.
+
+    @param lattice pointer to the lattice to be analyzed.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+*/
+void dispatch_label(int * lattice, int rows, int columns);
+
+/*! Find whether a populated lattice percolates with the selected spanning
+    kernel.
+
+    @param lattice pointer to the populated lattice. It is left labeled only
+        if the selected kernel labels it.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param profile pointer to the profile where the labeling and percolation
+        phases are accumulated.
+    @return A boolean indicating whether the lattice has a percolating cluster
+        or not.
+*/
+char dispatch_percolates(int * lattice, int rows, int columns,
+                         phase_profile * profile);
+
+#endif /* DISPATCH_H */
@@ -0,0 +1,115 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+
+/* headers */
+#include <stdlib.h>
+#include <time.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "random.h"
+#include "lattice.h"
+#include "clusters.h"
+#include "io_helpers.h"
+#include "cli.h"
+
+/* main body function */
+int main(int argc, char ** argv)
+{
+    int L; /* length of the front (number of rows) */
+    int W; /* length of the gradient (number of columns) */
+    int N; /* number of trials */
+    int * lattice; /* lattice array */
+    int * front_columns; /* number of front sites in each column */
+    int front_size;
+    unsigned int random_seed; /* random number generator seed */
+    double * p_critical; /* critical probability estimated from each front */
+    double p_critical_average;
+    double p_critical_variance;
+    int output_interval;
+    const char * format_option;
+    int j, n;
+
+    /* read optional arguments */
+    if ((format_option = extract_option(&argc, argv, "format")) &&
+        !set_output_format(format_option)) {
+        printf("--format must be either csv or binary\n");
+        return 1;
+    }
+    if (extract_flag(&argc, argv, "huge-pages") && !set_lattice_huge_pages(1)) {
+        printf("huge pages are not available, using regular pages\n");
+    }
+
+    /* read input arguments */
+    if (argc < 4) {
+        printf("usage: L W ntrials (seed) [--format=csv|binary] [--huge-pages]\n");
+        return 1;
+    }
+    L = atoi(argv[1]);
+    W = atoi(argv[2]);
+    N = atoi(argv[3]);
+    if (argc == 5) {
+        random_seed = atoi(argv[4]);
+    } else {
+        random_seed = (unsigned int)time(NULL);
+    }
+    if (W < 2) {
+        printf("the gradient length W must be at least 2\n");
+        return 1;
+    }
+
+    p_critical = (double *)malloc(N*sizeof(double));
+    front_columns = (int *)malloc(W*sizeof(int));
+
+    output_interval = N / 10;
+
+    srand_pcg(random_seed);
+
+    /* allocate lattice */
+    lattice = allocate_lattice(L, W, 0);
+
+    /* the occupation probability goes from 1 in the first column to 0 in
+       the last one, and p_c is the mean occupation probability at the front
+       of the cluster connected to the first column */
+    for (n = 0; n < N; n++) {
+        populate_lattice_gradient(1.0, 0.0, lattice, L, W, 0);
+        label_clusters(lattice, L, W);
+        for (j = 0; j < W; j++) {
+            front_columns[j] = 0;
+        }
+        front_size = gradient_percolation_front(lattice, L, W, front_columns);
+        p_critical[n] = 0;
+        for (j = 0; j < W; j++) {
+            p_critical[n] += front_columns[j]*(1.0 - ((double)j)/(W - 1));
+        }
+        p_critical[n] = p_critical[n] / front_size;
+
+        /* print progress to stdout */
+        if (output_interval > 0 && (n+1) % output_interval == 0) {
+            printf("finished with trial %d out of %d\n", n+1, N);
+        }
+    }
+
+    p_critical_average = 0;
+    for (n = 0; n < N; n++) {
+        p_critical_average += p_critical[n];
+    }
+    p_critical_average = p_critical_average / N;
+    p_critical_variance = 0;
+    for (n = 0; n < N; n++) {
+        p_critical_variance += (p_critical[n] - p_critical_average)*(p_critical[n] - p_critical_average);
+    }
+    p_critical_variance = N > 1 ? p_critical_variance / (N - 1) : 0;
+
+    /* return estimated value and write results to file */
+    printf("p critical average: %f +- %f\n", p_critical_average,
+           sqrt(p_critical_variance / N));
+    write_critical_point_gradient_results("print/data", p_critical, N, L, W,
+                                          random_seed);
+
+    free(lattice);
+    free(front_columns);
+    free(p_critical);
+
+    return 0;
+}
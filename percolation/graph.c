@@ -0,0 +1,357 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+/* see header file for detailed documentation of each function */
+
+#include "graph.h"
+#include <stdlib.h>
+#include <string.h>
+#include "lattice.h"
+
+/* stores the neighbors of a site of a lattice and returns how many it has */
+typedef int (*grid_neighbors)(int row, int column, int rows, int columns,
+                              int * neighbors);
+
+static site_graph * allocate_site_graph(int nodes)
+{
+    site_graph * graph;
+
+    graph = (site_graph *)malloc(sizeof(site_graph));
+    graph->nodes = nodes;
+    graph->rows = 1;
+    graph->columns = nodes;
+    graph->offsets = (int *)calloc(nodes + 1, sizeof(int));
+    graph->neighbors = NULL;
+    graph->boundary_pairs = 0;
+    graph->boundary_offsets = (int *)calloc(2*GRAPH_MAX_BOUNDARY_PAIRS + 1, sizeof(int));
+    graph->boundary_nodes = NULL;
+
+    return graph;
+}
+
+site_graph * create_site_graph(int nodes, int edges, const int * endpoints)
+{
+    int k;
+    int * next; /* where the next neighbor of each node is stored */
+    site_graph * graph;
+
+    graph = allocate_site_graph(nodes);
+
+    /* count the neighbors of each node, then place them */
+    for (k = 0; k < edges; k++) {
+        if (endpoints[2*k] != endpoints[2*k + 1]) {
+            graph->offsets[endpoints[2*k] + 1] += 1;
+            graph->offsets[endpoints[2*k + 1] + 1] += 1;
+        }
+    }
+    for (k = 0; k < nodes; k++) {
+        graph->offsets[k + 1] += graph->offsets[k];
+    }
+    graph->neighbors = (int *)malloc((graph->offsets[nodes] + 1)*sizeof(int));
+    next = (int *)malloc((nodes + 1)*sizeof(int));
+    memcpy(next, graph->offsets, (nodes + 1)*sizeof(int));
+    for (k = 0; k < edges; k++) {
+        if (endpoints[2*k] != endpoints[2*k + 1]) {
+            graph->neighbors[next[endpoints[2*k]]++] = endpoints[2*k + 1];
+            graph->neighbors[next[endpoints[2*k + 1]]++] = endpoints[2*k];
+        }
+    }
+    free(next);
+
+    return graph;
+}
+
+char add_graph_boundary_pair(site_graph * graph, int count, const int * boundary,
+                             int opposite_count, const int * opposite)
+{
+    int start;
+    int b;
+
+    if (graph->boundary_pairs == GRAPH_MAX_BOUNDARY_PAIRS) {
+        return 0;
+    }
+
+    b = 2*graph->boundary_pairs;
+    start = graph->boundary_offsets[b];
+    graph->boundary_nodes = realloc(graph->boundary_nodes,
+                                    (start + count + opposite_count)*sizeof(int));
+    memcpy(graph->boundary_nodes + start, boundary, count*sizeof(int));
+    memcpy(graph->boundary_nodes + start + count, opposite, opposite_count*sizeof(int));
+    graph->boundary_offsets[b + 1] = start + count;
+    graph->boundary_offsets[b + 2] = start + count + opposite_count;
+    graph->boundary_pairs++;
+
+    return 1;
+}
+
+/* the sites of a lattice as a graph, with its rows and columns as
+   boundaries; the neighbors are found twice, to count and to store them */
+static site_graph * create_grid_graph(int rows, int columns, grid_neighbors find_neighbors)
+{
+    int i;
+    int j;
+    int found[8];
+    int * boundary;
+    int * opposite;
+    site_graph * graph;
+
+    graph = allocate_site_graph(rows*columns);
+    graph->rows = rows;
+    graph->columns = columns;
+
+    for (i = 0; i < rows; i++) {
+        for (j = 0; j < columns; j++) {
+            graph->offsets[i*columns + j + 1] = graph->offsets[i*columns + j] +
+                                                find_neighbors(i, j, rows, columns, found);
+        }
+    }
+    graph->neighbors = (int *)malloc((graph->offsets[rows*columns] + 1)*sizeof(int));
+    for (i = 0; i < rows; i++) {
+        for (j = 0; j < columns; j++) {
+            find_neighbors(i, j, rows, columns, graph->neighbors + graph->offsets[i*columns + j]);
+        }
+    }
+
+    /* first and last rows, then first and last columns */
+    boundary = (int *)calloc(rows > columns ? rows : columns, sizeof(int));
+    opposite = (int *)calloc(rows > columns ? rows : columns, sizeof(int));
+    for (j = 0; j < columns; j++) {
+        boundary[j] = j;
+        opposite[j] = (rows - 1)*columns + j;
+    }
+    add_graph_boundary_pair(graph, columns, boundary, columns, opposite);
+    for (i = 0; i < rows; i++) {
+        boundary[i] = i*columns;
+        opposite[i] = i*columns + columns - 1;
+    }
+    add_graph_boundary_pair(graph, rows, boundary, rows, opposite);
+    free(boundary);
+    free(opposite);
+
+    return graph;
+}
+
+static int square_neighbors(int row, int column, int rows, int columns, int * neighbors)
+{
+    int count;
+
+    count = 0;
+    if (row > 0) {
+        neighbors[count++] = (row - 1)*columns + column;
+    }
+    if (column > 0) {
+        neighbors[count++] = row*columns + column - 1;
+    }
+    if (column < columns - 1) {
+        neighbors[count++] = row*columns + column + 1;
+    }
+    if (row < rows - 1) {
+        neighbors[count++] = (row + 1)*columns + column;
+    }
+    return count;
+}
+
+static int triangular_neighbors(int row, int column, int rows, int columns, int * neighbors)
+{
+    int count;
+
+    count = square_neighbors(row, column, rows, columns, neighbors);
+    if (row > 0 && column > 0) {
+        neighbors[count++] = (row - 1)*columns + column - 1;
+    }
+    if (row < rows - 1 && column < columns - 1) {
+        neighbors[count++] = (row + 1)*columns + column + 1;
+    }
+    return count;
+}
+
+static int honeycomb_neighbors(int row, int column, int rows, int columns, int * neighbors)
+{
+    int count;
+
+    count = 0;
+    if ((row + column) % 2 == 0 && row > 0) {
+        neighbors[count++] = (row - 1)*columns + column;
+    }
+    if (column > 0) {
+        neighbors[count++] = row*columns + column - 1;
+    }
+    if (column < columns - 1) {
+        neighbors[count++] = row*columns + column + 1;
+    }
+    if ((row + column) % 2 == 1 && row < rows - 1) {
+        neighbors[count++] = (row + 1)*columns + column;
+    }
+    return count;
+}
+
+site_graph * create_square_graph(int rows, int columns)
+{
+    return create_grid_graph(rows, columns, square_neighbors);
+}
+
+site_graph * create_triangular_graph(int rows, int columns)
+{
+    return create_grid_graph(rows, columns, triangular_neighbors);
+}
+
+site_graph * create_honeycomb_graph(int rows, int columns)
+{
+    return create_grid_graph(rows, columns, honeycomb_neighbors);
+}
+
+void free_site_graph(site_graph * graph)
+{
+    if (!graph) {
+        return;
+    }
+
+    free(graph->offsets);
+    free(graph->neighbors);
+    free(graph->boundary_offsets);
+    free(graph->boundary_nodes);
+    free(graph);
+}
+
+static int find_node(int * parents, int node)
+{
+    while (parents[node] != node) {
+        parents[node] = parents[parents[node]];
+        node = parents[node];
+    }
+    return node;
+}
+
+void label_graph_clusters(const site_graph * graph, int * sites)
+{
+    int v;
+    int k;
+    int root_a;
+    int root_b;
+    int label;
+    int * parents; /* union-find forest of the nodes */
+
+    parents = (int *)allocate_aligned((graph->nodes + 1)*sizeof(int));
+
+    /* join each occupied node with its occupied neighbors already visited;
+       the smallest node is kept as root, so each root is the first node of
+       its cluster */
+    for (v = 0; v < graph->nodes; v++) {
+        if (!sites[v]) {
+            continue;
+        }
+        parents[v] = v;
+        for (k = graph->offsets[v]; k < graph->offsets[v + 1]; k++) {
+            if (graph->neighbors[k] > v || !sites[graph->neighbors[k]]) {
+                continue;
+            }
+            root_a = find_node(parents, v);
+            root_b = find_node(parents, graph->neighbors[k]);
+            if (root_a < root_b) {
+                parents[root_b] = root_a;
+            } else {
+                parents[root_a] = root_b;
+            }
+        }
+    }
+
+    /* roots come before the rest of their cluster, so they are labeled first */
+    label = 2;
+    for (v = 0; v < graph->nodes; v++) {
+        if (!sites[v]) {
+            continue;
+        }
+        root_a = find_node(parents, v);
+        sites[v] = root_a == v ? label++ : sites[root_a];
+    }
+
+    free(parents);
+}
+
+char graph_has_percolating_cluster(const site_graph * graph, const int * sites)
+{
+    int k;
+    int b;
+    char * touched; /* labels of the clusters touching the first boundary of a pair */
+    char percolated;
+
+    touched = (char *)calloc(graph->nodes + 2, sizeof(char));
+    percolated = 0;
+    for (b = 0; b < 2*graph->boundary_pairs && !percolated; b += 2) {
+        for (k = graph->boundary_offsets[b]; k < graph->boundary_offsets[b + 1]; k++) {
+            touched[sites[graph->boundary_nodes[k]]] = 1;
+        }
+        for (k = graph->boundary_offsets[b + 1]; k < graph->boundary_offsets[b + 2]; k++) {
+            if (sites[graph->boundary_nodes[k]] && touched[sites[graph->boundary_nodes[k]]]) {
+                percolated = 1;
+                break;
+            }
+        }
+        for (k = graph->boundary_offsets[b]; k < graph->boundary_offsets[b + 1]; k++) {
+            touched[sites[graph->boundary_nodes[k]]] = 0;
+        }
+    }
+    free(touched);
+
+    return percolated;
+}
+
+void graph_cluster_statistics(const site_graph * graph, const int * sites,
+                              int * cluster_sizes_total_count, int ** cluster_sizes,
+                              int ** cluster_sizes_counts, int ** cluster_sizes_percolated)
+{
+    int v;
+    int k;
+    int b;
+    int label;
+    int max_label;
+    int index;
+    char percolated;
+    int * labels_sizes; /* nodes in the cluster of each label */
+    unsigned int * labels_borders; /* boundaries touched by the cluster of each label (bit b for boundary b) */
+    int * sizes_indices; /* position of each size in the statistics arrays */
+
+    max_label = 1;
+    for (v = 0; v < graph->nodes; v++) {
+        max_label = sites[v] > max_label ? sites[v] : max_label;
+    }
+    labels_sizes = (int *)calloc(max_label + 1, sizeof(int));
+    labels_borders = (unsigned int *)calloc(max_label + 1, sizeof(unsigned int));
+    for (v = 0; v < graph->nodes; v++) {
+        labels_sizes[sites[v]] += 1;
+    }
+    for (b = 0; b < 2*graph->boundary_pairs; b++) {
+        for (k = graph->boundary_offsets[b]; k < graph->boundary_offsets[b + 1]; k++) {
+            labels_borders[sites[graph->boundary_nodes[k]]] |= 1u << b;
+        }
+    }
+
+    /* get count of each cluster size */
+    sizes_indices = (int *)malloc((graph->nodes + 1)*sizeof(int));
+    for (v = 0; v <= graph->nodes; v++) {
+        sizes_indices[v] = -1;
+    }
+    *cluster_sizes_total_count = 0;
+    *cluster_sizes = (int *)malloc(max_label*sizeof(int));
+    *cluster_sizes_counts = (int *)malloc(max_label*sizeof(int));
+    *cluster_sizes_percolated = (int *)malloc(max_label*sizeof(int));
+    for (label = 2; label <= max_label; label++) {
+        percolated = 0;
+        for (b = 0; b < graph->boundary_pairs; b++) {
+            percolated |= ((labels_borders[label] >> 2*b) & 3) == 3;
+        }
+        index = sizes_indices[labels_sizes[label]];
+        if (index < 0) {
+            index = (*cluster_sizes_total_count)++;
+            sizes_indices[labels_sizes[label]] = index;
+            (*cluster_sizes)[index] = labels_sizes[label];
+            (*cluster_sizes_counts)[index] = 0;
+            (*cluster_sizes_percolated)[index] = 0;
+        }
+        (*cluster_sizes_counts)[index] += 1;
+        (*cluster_sizes_percolated)[index] += percolated;
+    }
+
+    free(labels_sizes);
+    free(labels_borders);
+    free(sizes_indices);
+}
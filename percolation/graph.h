@@ -0,0 +1,147 @@
+/*!
+    @file graph.h
+    @brief This file contains functions to study site percolation on
+    arbitrary graphs, such as the triangular and honeycomb lattices.
+
+    The graph is stored in compressed sparse row (CSR) form: the neighbors of
+    all the nodes are stored contiguously in a single array, and an array of
+    offsets gives where the neighbors of each node start. The nodes on each
+    side of the graph are listed in boundary sets, grouped in pairs of
+    opposite sides, and a cluster percolates when it touches both sides of
+    any pair.
+
+    The occupation of the nodes and their cluster labels are stored in int
+    arrays with the same conventions as the square lattices (0 for empty
+    nodes, 1 for occupied ones, and labels starting from 2), so the nodes of
+    the lattices generated here can be laid out and written as a rows x
+    columns lattice.
+
+    @author Federico Cerisola
+    @copyright MIT License.
+*/
+
+#ifndef GRAPH_H
+#define GRAPH_H
+
+/*! Largest number of pairs of opposite boundaries of a graph. */
+#define GRAPH_MAX_BOUNDARY_PAIRS 16
+
+/*! A graph in compressed sparse row form. */
+typedef struct {
+    int nodes; /*!< the number of nodes */
+    int rows; /*!< the number of rows of the lattice the nodes are laid out on (1 for arbitrary graphs) */
+    int columns; /*!< the number of columns of the lattice the nodes are laid out on (nodes for arbitrary graphs) */
+    int * offsets; /*!< the neighbors of node v are neighbors[offsets[v]] to neighbors[offsets[v+1] - 1] */
+    int * neighbors; /*!< the neighbors of all the nodes */
+    int boundary_pairs; /*!< the number of pairs of opposite boundaries */
+    int * boundary_offsets; /*!< boundary b has the nodes boundary_nodes[boundary_offsets[b]] to boundary_nodes[boundary_offsets[b+1] - 1]; boundaries 2k and 2k+1 are opposite */
+    int * boundary_nodes; /*!< the nodes of all the boundaries */
+} site_graph;
+
+/*! Create a graph from a list of undirected edges.
+
+    @param nodes the number of nodes.
+    @param edges the number of edges.
+    @param endpoints array with the two nodes of each edge (2*edges elements).
+    @return A pointer to the newly allocated graph, with no boundaries.
+
+    @warning The graph must be free'd with free_site_graph.
+*/
+site_graph * create_site_graph(int nodes, int edges, const int * endpoints);
+
+/*! Add a pair of opposite boundaries to a graph.
+
+    @param graph pointer to the graph.
+    @param count the number of nodes in the first boundary.
+    @param boundary the nodes of the first boundary.
+    @param opposite_count the number of nodes in the opposite boundary.
+    @param opposite the nodes of the opposite boundary.
+    @return A boolean indicating whether the pair was added (there are at
+        most GRAPH_MAX_BOUNDARY_PAIRS).
+*/
+char add_graph_boundary_pair(site_graph * graph, int count, const int * boundary,
+                             int opposite_count, const int * opposite);
+
+/*! Create the graph of a square lattice, where each site is linked to its
+    neighbors in the same row and column.
+
+    The boundaries are the first and last rows, and the first and last
+    columns, as in has_percolating_cluster.
+
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @return A pointer to the newly allocated graph.
+*/
+site_graph * create_square_graph(int rows, int columns);
+
+/*! Create the graph of a triangular lattice, laid out as a square lattice
+    where each site is also linked to its upper left and lower right
+    neighbors (six neighbors in total).
+
+    The boundaries are the same as those of the square lattice.
+
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @return A pointer to the newly allocated graph.
+*/
+site_graph * create_triangular_graph(int rows, int columns);
+
+/*! Create the graph of a honeycomb lattice, laid out as a brick wall: a
+    square lattice where each site keeps its two neighbors in the same row,
+    but only one of its neighbors in the same column, the upper one when
+    row + column is even and the lower one otherwise (three neighbors in
+    total).
+
+    The boundaries are the same as those of the square lattice.
+
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @return A pointer to the newly allocated graph.
+*/
+site_graph * create_honeycomb_graph(int rows, int columns);
+
+/*! Free a graph.
+
+    @param graph pointer to the graph.
+*/
+void free_site_graph(site_graph * graph);
+
+/*! Label the clusters of occupied nodes of a graph, with union-find.
+
+    @param graph pointer to the graph.
+    @param sites array with the occupation of each node (1 occupied, 0
+        empty), as given by populate_lattice. It is overwritten with the label
+        of the cluster of each occupied node, starting from 2 and numbered in
+        the order of their first node.
+*/
+void label_graph_clusters(const site_graph * graph, int * sites);
+
+/*! Determine whether a labeled graph has a percolating cluster.
+
+    @param graph pointer to the graph.
+    @param sites array with the labels given by label_graph_clusters.
+    @return A boolean indicating whether some cluster touches both
+        boundaries of a pair.
+*/
+char graph_has_percolating_cluster(const site_graph * graph, const int * sites);
+
+/*! Perform cluster sizes statistics of a labeled graph.
+
+    @param graph pointer to the graph.
+    @param sites array with the labels given by label_graph_clusters.
+    @param cluster_sizes_total_count pointer to integer where to store the
+        total number of different cluster sizes.
+    @param cluster_sizes array where to store the sizes of the clusters.
+    @param cluster_sizes_counts array where to store the number of clusters
+        of each size.
+    @param cluster_sizes_percolated array where to store the number of
+        percolating clusters of each size.
+
+    @warning The arrays must be manually free'd by the user.
+    @see cluster_statistics for the same statistics of a square lattice.
+*/
+void graph_cluster_statistics(const site_graph * graph, const int * sites,
+                              int * cluster_sizes_total_count, int ** cluster_sizes,
+                              int ** cluster_sizes_counts, int ** cluster_sizes_percolated);
+
+#endif /* GRAPH_H */
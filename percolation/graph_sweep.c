@@ -0,0 +1,171 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+
+/* headers */
+#include <stdlib.h>
+#include <time.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "random.h"
+#include "math_extra.h"
+#include "lattice.h"
+#include "io_helpers.h"
+#include "graph.h"
+#include "sweep.h"
+#include "status.h"
+#include "cli.h"
+
+/* lattice sampled by sample_graph_realization */
+typedef struct {
+    site_graph * graph; /* neighbors and boundaries of the nodes */
+    int * sites; /* occupation and then labels of the nodes */
+    int size; /* number of rows and columns of the lattice */
+} graph_lattice;
+
+/* populate and label the sites of the graph_lattice given as data */
+static void sample_graph_realization(void * data, double probability,
+                                     int * cluster_sizes_total_count,
+                                     int ** cluster_sizes, int ** cluster_sizes_counts,
+                                     int ** cluster_sizes_percolated)
+{
+    graph_lattice * lattice;
+
+    lattice = (graph_lattice *)data;
+    populate_lattice(probability, lattice->sites, lattice->size, lattice->size, 0);
+    label_graph_clusters(lattice->graph, lattice->sites);
+    graph_cluster_statistics(lattice->graph, lattice->sites, cluster_sizes_total_count,
+                             cluster_sizes, cluster_sizes_counts, cluster_sizes_percolated);
+}
+
+/* main body function */
+int main(int argc, char ** argv)
+{
+    int L; /* size of the lattice */
+    int * sites; /* occupation and then labels of the nodes of the graph */
+    unsigned int random_seed; /* random number generator seed */
+    int N; /* number of discrete probability value to tests */
+    double probability_center; /* value where to center the discrete probability values grid */
+    double decay; /* exponential decay coefficient of the probability grid */
+    int grid_rounding_digits; /* to how many digits should the probabilities in the grid be rounded to */
+    double * probability_grid; /* discrete grid of probability values to test */
+    int nrepetitions; /* the number of repetitions to take for each probability */
+    site_graph * graph; /* neighbors and boundaries of the nodes of the lattice */
+    graph_lattice lattice; /* graph and sites given to the sampling function */
+    const char * graph_option; /* kind of lattice */
+    sweep_point * points; /* accumulated statistics for each probability */
+    const char * format_option;
+    const char * bins_option;
+    const char * status_path; /* file where the progress is reported (NULL for none) */
+    const char * status_option;
+    int bins_per_decade; /* logarithmic bins per decade of the cluster sizes (0 if exact) */
+    int exact_sizes; /* largest cluster size that is not binned */
+    double status_interval; /* minimum seconds between rewrites of the status file */
+    run_status * status; /* status file of the run (NULL if none) */
+    int i;
+
+    /* read optional arguments */
+    if ((format_option = extract_option(&argc, argv, "format")) &&
+        !set_output_format(format_option)) {
+        printf("--format must be either csv or binary\n");
+        return 1;
+    }
+    if (extract_flag(&argc, argv, "huge-pages") && !set_lattice_huge_pages(1)) {
+        printf("huge pages are not available, using regular pages\n");
+    }
+    bins_per_decade = 0;
+    exact_sizes = 10;
+    if ((bins_option = extract_option(&argc, argv, "log-bins"))) {
+        bins_per_decade = atoi(bins_option);
+    }
+    if ((bins_option = extract_option(&argc, argv, "exact-sizes"))) {
+        exact_sizes = atoi(bins_option);
+    }
+    if (bins_per_decade > 0) {
+        exact_sizes = sweep_set_log_bins(bins_per_decade, exact_sizes);
+        set_cluster_size_binning(bins_per_decade, exact_sizes);
+    }
+    graph_option = extract_option(&argc, argv, "graph");
+    if (!graph_option) {
+        graph_option = "square";
+    }
+    if (strcmp(graph_option, "square") != 0 && strcmp(graph_option, "triangular") != 0 &&
+        strcmp(graph_option, "honeycomb") != 0) {
+        printf("--graph must be either square, triangular or honeycomb\n");
+        return 1;
+    }
+    status_path = extract_option(&argc, argv, "status");
+    status_interval = 10;
+    if ((status_option = extract_option(&argc, argv, "status-interval"))) {
+        status_interval = atof(status_option);
+    }
+
+    /* read input arguments */
+    if (argc < 7) {
+        printf("usage: L ngrid pcenter decay rounding nrepetitions (seed)"
+               " [--graph=square|triangular|honeycomb] [--format=csv|binary] [--huge-pages] [--log-bins=B] [--exact-sizes=S]"
+               " [--status=FILE] [--status-interval=SECONDS]\n");
+        return 1;
+    }
+    L = atoi(argv[1]);
+    N = atoi(argv[2]);
+    probability_center = atof(argv[3]);
+    decay = atof(argv[4]);
+    grid_rounding_digits = atoi(argv[5]);
+    nrepetitions = atoi(argv[6]);
+    if (argc == 8) {
+        random_seed = atoi(argv[7]);
+    } else {
+        random_seed = (unsigned int)time(NULL);
+    }
+    /* initialize remaining variables */
+    probability_grid = create_exponential_centered_grid(0, 1, probability_center, N, decay, grid_rounding_digits);
+    points = (sweep_point *)malloc(N*sizeof(sweep_point));
+    for (i = 0; i < N; i++) {
+        sweep_point_init(&points[i], probability_grid[i]);
+    }
+
+    srand_pcg(random_seed);
+
+    /* allocate lattice and build its graph */
+    sites = allocate_lattice(L, L, 0);
+    if (strcmp(graph_option, "triangular") == 0) {
+        graph = create_triangular_graph(L, L);
+    } else if (strcmp(graph_option, "honeycomb") == 0) {
+        graph = create_honeycomb_graph(L, L);
+    } else {
+        graph = create_square_graph(L, L);
+    }
+
+    status = NULL;
+    if (status_path) {
+        status = open_run_status(status_path, "graph_sweep", L, L, status_interval);
+        if (!status) {
+            printf("could not write the status file %s\n", status_path);
+            return 1;
+        }
+    }
+
+    /* the files of square lattices are named as those of probability_sweep */
+    if (strcmp(graph_option, "square") != 0) {
+        set_output_lattice(graph_option);
+    }
+
+    /* calculate cluster statistics per probability */
+    lattice.graph = graph;
+    lattice.sites = sites;
+    lattice.size = L;
+    sweep_points_run(points, N, probability_center, decay, nrepetitions,
+                     sample_graph_realization, &lattice, ((long)L)*L, L, L,
+                     random_seed, status);
+
+    close_run_status(status);
+
+    /* free memory before leaving */
+    free_site_graph(graph);
+    free(sites);
+    free(points);
+    free(probability_grid);
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+
+/* headers */
+#include <stdlib.h>
+#include <time.h>
+#include <stdio.h>
+
+#include "random.h"
+#include "lattice.h"
+#include "clusters.h"
+#include "io_helpers.h"
+#include "cli.h"
+
+/* main body function */
+int main(int argc, char ** argv)
+{
+    int L; /* square lattice size */
+    int * lattice; /* lattice array */
+    unsigned int random_seed; /* random number generator seed */
+    int N; /* number of repetitions */
+    double probability; /* occupation probability */
+    cluster_geometry * geometry; /* geometry of each cluster of a realization */
+    int cluster_count;
+    int bins_count; /* number of cluster sizes (or bins) */
+    int * cluster_sizes; /* size (or smallest size of the bin) */
+    int * cluster_sizes_counts; /* finite clusters found of each size */
+    double * radius_gyration_squared; /* sum of squared radius of gyration per size */
+    double * extent; /* sum of largest side of the bounding box per size */
+    int bins_per_decade; /* logarithmic bins per decade of the cluster sizes (0 if exact) */
+    int exact_sizes; /* largest cluster size that is not binned */
+    int width;
+    int height;
+    int bin;
+    int output_interval;
+    const char * format_option;
+    const char * bins_option;
+    int i, n;
+
+    /* read optional arguments */
+    if ((format_option = extract_option(&argc, argv, "format")) &&
+        !set_output_format(format_option)) {
+        printf("--format must be either csv or binary\n");
+        return 1;
+    }
+    if (extract_flag(&argc, argv, "huge-pages") && !set_lattice_huge_pages(1)) {
+        printf("huge pages are not available, using regular pages\n");
+    }
+    bins_per_decade = 0;
+    exact_sizes = 10;
+    if ((bins_option = extract_option(&argc, argv, "log-bins"))) {
+        bins_per_decade = atoi(bins_option);
+    }
+    if ((bins_option = extract_option(&argc, argv, "exact-sizes"))) {
+        exact_sizes = atoi(bins_option);
+    }
+
+    /* read input arguments */
+    if (argc < 4) {
+        printf("usage: L nrepetitions probability (seed) [--format=csv|binary] [--huge-pages]"
+               " [--log-bins=B] [--exact-sizes=S]\n");
+        return 1;
+    }
+    L = atoi(argv[1]);
+    N = atoi(argv[2]);
+    probability = atof(argv[3]);
+    if (argc == 5) {
+        random_seed = atoi(argv[4]);
+    } else {
+        random_seed = (unsigned int)time(NULL);
+    }
+
+    /* every size up to L*L has its own row unless sizes are binned */
+    if (bins_per_decade > 0) {
+        if (exact_sizes < cluster_size_minimum_exact_sizes(bins_per_decade)) {
+            exact_sizes = cluster_size_minimum_exact_sizes(bins_per_decade);
+        }
+        set_cluster_size_binning(bins_per_decade, exact_sizes);
+        bins_count = cluster_size_bin(L*L, bins_per_decade, exact_sizes) + 1;
+    } else {
+        bins_count = L*L;
+    }
+    cluster_sizes = (int *)malloc(bins_count*sizeof(int));
+    cluster_sizes_counts = (int *)calloc(bins_count, sizeof(int));
+    radius_gyration_squared = (double *)calloc(bins_count, sizeof(double));
+    extent = (double *)calloc(bins_count, sizeof(double));
+    for (i = 0; i < bins_count; i++) {
+        cluster_sizes[i] = bins_per_decade > 0 ?
+                           cluster_size_bin_lower_edge(i, bins_per_decade, exact_sizes) :
+                           i + 1;
+    }
+
+    output_interval = N / 10;
+
+    srand_pcg(random_seed);
+
+    /* allocate lattice */
+    lattice = allocate_lattice(L, L, 0);
+
+    /* accumulate the geometry of the finite (non spanning) clusters */
+    for (n = 0; n < N; n++) {
+        populate_lattice(probability, lattice, L, L, 0);
+        cluster_count = label_clusters_geometry(lattice, L, L, &geometry);
+        for (i = 0; i < cluster_count; i++) {
+            height = geometry[i].max_row - geometry[i].min_row + 1;
+            width = geometry[i].max_column - geometry[i].min_column + 1;
+            if (height == L || width == L) {
+                continue;
+            }
+            bin = bins_per_decade > 0 ?
+                  cluster_size_bin(geometry[i].size, bins_per_decade, exact_sizes) :
+                  geometry[i].size - 1;
+            cluster_sizes_counts[bin] += 1;
+            radius_gyration_squared[bin] += cluster_radius_of_gyration_squared(&geometry[i]);
+            extent[bin] += height > width ? height : width;
+        }
+        free(geometry);
+
+        /* print progress to stdout */
+        if (output_interval > 0 && (n+1) % output_interval == 0) {
+            printf("finished with round %d out of %d\n", n+1, N);
+        }
+    }
+
+    /* only write sizes that were found */
+    bin = 0;
+    for (i = 0; i < bins_count; i++) {
+        if (cluster_sizes_counts[i] == 0) {
+            continue;
+        }
+        cluster_sizes[bin] = cluster_sizes[i];
+        cluster_sizes_counts[bin] = cluster_sizes_counts[i];
+        radius_gyration_squared[bin] = radius_gyration_squared[i];
+        extent[bin] = extent[i];
+        bin++;
+    }
+
+    write_gyration_results("print/data", cluster_sizes, cluster_sizes_counts,
+                           radius_gyration_squared, extent, bin, probability, N,
+                           L, L, random_seed);
+
+    free(lattice);
+    free(cluster_sizes);
+    free(cluster_sizes_counts);
+    free(radius_gyration_squared);
+    free(extent);
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+/* see header file for detailed documentation of each function */
+
+#include "invasion.h"
+#include "random.h"
+#include <stdlib.h>
+
+#define RADIX_HEAP_BUCKETS 33
+
+/* sites waiting in the perimeter, as (strength << 32 | site) entries;
+   bucket 0 holds the entries equal to last and bucket b > 0 the ones whose
+   highest bit differing from last is b - 1 */
+typedef struct {
+    uint32_t last;
+    int size;
+    int bucket_sizes[RADIX_HEAP_BUCKETS];
+    int bucket_capacities[RADIX_HEAP_BUCKETS];
+    uint64_t * buckets[RADIX_HEAP_BUCKETS];
+} radix_heap;
+
+static int radix_heap_bucket(uint32_t key, uint32_t last)
+{
+    uint32_t difference;
+    int bucket;
+
+    difference = key ^ last;
+    if (difference == 0) {
+        return 0;
+    }
+#if defined(__GNUC__)
+    bucket = 32 - __builtin_clz(difference);
+#else
+    bucket = 0;
+    while (difference) {
+        difference >>= 1;
+        bucket++;
+    }
+#endif
+    return bucket;
+}
+
+static void radix_heap_append(radix_heap * heap, int bucket, uint64_t entry)
+{
+    if (heap->bucket_sizes[bucket] == heap->bucket_capacities[bucket]) {
+        heap->bucket_capacities[bucket] = heap->bucket_capacities[bucket] > 0 ?
+                                          2*heap->bucket_capacities[bucket] : 64;
+        heap->buckets[bucket] = (uint64_t *)realloc(heap->buckets[bucket],
+                                                    heap->bucket_capacities[bucket]*sizeof(uint64_t));
+    }
+    heap->buckets[bucket][heap->bucket_sizes[bucket]++] = entry;
+}
+
+/* keys below the last popped one are raised to it (see invade_lattice) */
+static void radix_heap_push(radix_heap * heap, uint32_t key, int site)
+{
+    if (key < heap->last) {
+        key = heap->last;
+    }
+    radix_heap_append(heap, radix_heap_bucket(key, heap->last),
+                      ((uint64_t)key << 32) | (uint32_t)site);
+    heap->size += 1;
+}
+
+static uint64_t radix_heap_pop(radix_heap * heap)
+{
+    int i;
+    int bucket;
+    uint32_t key;
+    uint32_t minimum;
+    uint64_t entry;
+
+    /* refill bucket 0 by redistributing the first non-empty bucket around
+       its minimum, which moves every entry to a lower bucket */
+    if (heap->bucket_sizes[0] == 0) {
+        bucket = 1;
+        while (heap->bucket_sizes[bucket] == 0) {
+            bucket++;
+        }
+        minimum = (uint32_t)(heap->buckets[bucket][0] >> 32);
+        for (i = 1; i < heap->bucket_sizes[bucket]; i++) {
+            key = (uint32_t)(heap->buckets[bucket][i] >> 32);
+            minimum = key < minimum ? key : minimum;
+        }
+        heap->last = minimum;
+        for (i = 0; i < heap->bucket_sizes[bucket]; i++) {
+            entry = heap->buckets[bucket][i];
+            radix_heap_append(heap, radix_heap_bucket((uint32_t)(entry >> 32), minimum),
+                              entry);
+        }
+        heap->bucket_sizes[bucket] = 0;
+    }
+
+    heap->size -= 1;
+    return heap->buckets[0][--heap->bucket_sizes[0]];
+}
+
+void populate_strengths(uint32_t * strengths, int rows, int columns,
+                        unsigned int seed)
+{
+    int i;
+
+    if (seed > 0) {
+        srand_pcg(seed);
+    }
+
+    for (i = 0; i < rows*columns; i++) {
+        strengths[i] = rand_pcg();
+    }
+}
+
+uint32_t invade_lattice(const uint32_t * strengths, int * lattice, int rows,
+                        int columns, int * mass)
+{
+    int i;
+    int site;
+    int row;
+    int column;
+    int neighbours[4];
+    int neighbour_count;
+    char spanned;
+    uint32_t key;
+    uint32_t threshold;
+    uint64_t entry;
+    radix_heap heap = {0};
+
+    /* 0: not reached yet, -1: in the perimeter, 1: invaded */
+    for (i = 0; i < rows*columns; i++) {
+        lattice[i] = 0;
+    }
+    for (i = 0; i < columns; i++) {
+        lattice[i] = -1;
+        radix_heap_push(&heap, strengths[i], i);
+    }
+
+    /* invade until reaching the last row, and then keep invading the sites
+       not stronger than the threshold so that the cluster does not depend
+       on the order of invasion below it */
+    threshold = 0;
+    spanned = 0;
+    *mass = 0;
+    while (heap.size > 0) {
+        entry = radix_heap_pop(&heap);
+        key = (uint32_t)(entry >> 32);
+        site = (int)(uint32_t)entry;
+        if (spanned && key > threshold) {
+            break;
+        }
+        threshold = key > threshold ? key : threshold;
+        lattice[site] = 1;
+        *mass += 1;
+
+        row = site / columns;
+        column = site % columns;
+        if (row == rows - 1) {
+            spanned = 1;
+        }
+        neighbour_count = 0;
+        if (row > 0) {
+            neighbours[neighbour_count++] = site - columns;
+        }
+        if (row < rows - 1) {
+            neighbours[neighbour_count++] = site + columns;
+        }
+        if (column > 0) {
+            neighbours[neighbour_count++] = site - 1;
+        }
+        if (column < columns - 1) {
+            neighbours[neighbour_count++] = site + 1;
+        }
+        for (i = 0; i < neighbour_count; i++) {
+            if (lattice[neighbours[i]] == 0) {
+                lattice[neighbours[i]] = -1;
+                radix_heap_push(&heap, strengths[neighbours[i]], neighbours[i]);
+            }
+        }
+    }
+
+    /* sites left in the perimeter are not part of the cluster */
+    for (i = 0; i < rows*columns; i++) {
+        if (lattice[i] == -1) {
+            lattice[i] = 0;
+        }
+    }
+    for (i = 0; i < RADIX_HEAP_BUCKETS; i++) {
+        free(heap.buckets[i]);
+    }
+
+    return threshold;
+}
@@ -0,0 +1,63 @@
+/*!
+    @file invasion.h
+    @brief This file contains functions to grow invasion percolation
+    clusters, which give the percolation threshold of a lattice without
+    having to search for it.
+
+    @author Federico Cerisola
+    @copyright MIT License.
+*/
+
+#ifndef INVASION_H
+#define INVASION_H
+
+#include <stdint.h>
+
+/*! Assign a random strength to every site of a lattice.
+
+    The strengths are drawn from the same random number generator used by
+    populate_lattice, so a site is occupied at probability p exactly when
+    strength/RAND_MAX_PCG <= p.
+
+    @param strengths array of rows*columns elements where the strengths are
+        stored.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param seed the seed used to initialize the random number generator. If
+        seed = 0, the random number generator is not initialized.
+*/
+void populate_strengths(uint32_t * strengths, int rows, int columns,
+                        unsigned int seed);
+
+/*! Grow an invasion percolation cluster from the first row until it spans
+    to the last row.
+
+    At each step the weakest site on the perimeter of the cluster is
+    invaded. The perimeter is kept in a radix heap over the 32 bit
+    strengths: sites are stored in buckets according to the highest bit in
+    which their strength differs from the last invaded one, so each
+    insertion is O(1) and each site is moved between buckets at most 32
+    times. A perimeter site weaker than the last invaded one is queued as if
+    it had the same strength; since it is invaded before any stronger site,
+    this only changes the order of invasion among sites below the current
+    level, and not the threshold nor the final cluster.
+
+    @param strengths the strength of each site, as given by
+        populate_strengths.
+    @param lattice array of rows*columns elements where the invaded cluster
+        is stored: 1 for the sites that belong to it, 0 otherwise. The
+        cluster includes every site connected to the first row through sites
+        not stronger than the threshold, i.e. the cluster of the first row
+        in the lattice populated at the threshold probability.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param mass pointer where the number of sites of the invaded cluster is
+        stored.
+
+    @return the threshold: the largest strength invaded before the cluster
+        reaches the last row.
+*/
+uint32_t invade_lattice(const uint32_t * strengths, int * lattice, int rows,
+                        int columns, int * mass);
+
+#endif /* INVASION_H */
@@ -0,0 +1,109 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+
+/* headers */
+#include <stdlib.h>
+#include <time.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "random.h"
+#include "lattice.h"
+#include "invasion.h"
+#include "io_helpers.h"
+#include "cli.h"
+
+/* main body function */
+int main(int argc, char ** argv)
+{
+    int L; /* square lattice size */
+    int N; /* number of trials */
+    int * lattice; /* invaded cluster of each trial */
+    uint32_t * strengths; /* random strength of each site */
+    unsigned int random_seed; /* random number generator seed */
+    double * p_critical; /* threshold of each invasion cluster */
+    double p_critical_average;
+    double p_critical_variance;
+    double mass_average; /* average number of sites of the invaded clusters */
+    int mass;
+    int output_interval;
+    char save_lattice; /* whether to write the cluster of the last trial */
+    const char * format_option;
+    int n;
+
+    /* read optional arguments */
+    if ((format_option = extract_option(&argc, argv, "format")) &&
+        !set_output_format(format_option)) {
+        printf("--format must be either csv or binary\n");
+        return 1;
+    }
+    if (extract_flag(&argc, argv, "huge-pages") && !set_lattice_huge_pages(1)) {
+        printf("huge pages are not available, using regular pages\n");
+    }
+    save_lattice = extract_flag(&argc, argv, "lattice");
+
+    /* read input arguments */
+    if (argc < 3) {
+        printf("usage: L ntrials (seed) [--format=csv|binary] [--huge-pages] [--lattice]\n");
+        return 1;
+    }
+    L = atoi(argv[1]);
+    N = atoi(argv[2]);
+    if (argc == 4) {
+        random_seed = atoi(argv[3]);
+    } else {
+        random_seed = (unsigned int)time(NULL);
+    }
+
+    p_critical = (double *)malloc(N*sizeof(double));
+    strengths = (uint32_t *)allocate_aligned(((size_t)L)*L*sizeof(uint32_t));
+
+    output_interval = N / 10;
+
+    srand_pcg(random_seed);
+
+    /* allocate lattice */
+    lattice = allocate_lattice(L, L, 0);
+
+    /* grow an invasion cluster from the first row on each trial */
+    mass_average = 0;
+    for (n = 0; n < N; n++) {
+        populate_strengths(strengths, L, L, 0);
+        p_critical[n] = ((double)invade_lattice(strengths, lattice, L, L, &mass))/RAND_MAX_PCG;
+        mass_average += mass;
+
+        /* print progress to stdout */
+        if (output_interval > 0 && (n+1) % output_interval == 0) {
+            printf("finished with trial %d out of %d\n", n+1, N);
+        }
+    }
+    mass_average = mass_average / N;
+
+    p_critical_average = 0;
+    for (n = 0; n < N; n++) {
+        p_critical_average += p_critical[n];
+    }
+    p_critical_average = p_critical_average / N;
+    p_critical_variance = 0;
+    for (n = 0; n < N; n++) {
+        p_critical_variance += (p_critical[n] - p_critical_average)*(p_critical[n] - p_critical_average);
+    }
+    p_critical_variance = N > 1 ? p_critical_variance / (N - 1) : 0;
+
+    /* return estimated value and write results to file */
+    printf("p critical average: %f +- %f\n", p_critical_average,
+           sqrt(p_critical_variance / N));
+    printf("invaded cluster mass average: %f\n", mass_average);
+    write_critical_point_invasion_results("print/data", p_critical, N, L, L,
+                                          random_seed);
+    if (save_lattice) {
+        write_lattice_to_file("print/data", lattice, L, L, p_critical[N-1],
+                              random_seed);
+    }
+
+    free(lattice);
+    free(strengths);
+    free(p_critical);
+
+    return 0;
+}
@@ -2,13 +2,145 @@
 /* MIT License (see root directory) */
 /* see header file for detailed documentation of each function */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "io_helpers.h"
+#include <sys/stat.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <float.h>
 #include <time.h>
 
+/* whether results are written in binary instead of csv format */
+static char output_binary = 0;
+
+/* logarithmic binning of the cluster sizes written (0 bins per decade if exact) */
+static int output_bins_per_decade = 0;
+static int output_exact_sizes = 0;
+
+/* profile written in the header of csv files (NULL for none) */
+static const phase_profile * output_profile = NULL;
+
+/* number of planes of three dimensional lattices (0 for two dimensional) */
+static int output_depth = 0;
+
+/* kind of lattice other than square (NULL for square lattices) */
+static const char * output_lattice = NULL;
+
+char set_output_format(const char * format)
+{
+    if (strcmp(format, "csv") == 0) {
+        output_binary = 0;
+    } else if (strcmp(format, "binary") == 0) {
+        output_binary = 1;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+void set_cluster_size_binning(int bins_per_decade, int exact_sizes)
+{
+    output_bins_per_decade = bins_per_decade;
+    output_exact_sizes = exact_sizes;
+}
+
+void get_cluster_size_binning(int * bins_per_decade, int * exact_sizes)
+{
+    *bins_per_decade = output_bins_per_decade;
+    *exact_sizes = output_exact_sizes;
+}
+
+void set_output_profile(const phase_profile * profile)
+{
+    output_profile = profile;
+}
+
+void set_output_depth(int depth)
+{
+    output_depth = depth;
+}
+
+void set_output_lattice(const char * lattice)
+{
+    output_lattice = lattice;
+}
+
+const char * get_output_lattice(void)
+{
+    return output_lattice;
+}
+
+/* write the depth and kind of lattice set with set_output_depth and
+   set_output_lattice as header lines */
+static void write_geometry_header(FILE * file_handler)
+{
+    if (output_depth > 0) {
+        fprintf(file_handler, ";depth:%d\n", output_depth);
+    }
+    if (output_lattice) {
+        fprintf(file_handler, ";lattice:%s\n", output_lattice);
+    }
+}
+
+/* write the profile set with set_output_profile as header lines */
+static void write_profile_header(FILE * file_handler)
+{
+    int i;
+
+    if (!output_profile) {
+        return;
+    }
+    for (i = 0; i < PHASE_OUTPUT; i++) {
+        fprintf(file_handler, ";profile_%s_seconds:%.*e\n", profile_phase_name(i),
+                DBL_DIG-1, output_profile->seconds[i]);
+        if (profiling_hardware_counters()) {
+            fprintf(file_handler, ";profile_%s_cycles:%llu\n", profile_phase_name(i),
+                    (unsigned long long)output_profile->cycles[i]);
+            fprintf(file_handler, ";profile_%s_cache_misses:%llu\n", profile_phase_name(i),
+                    (unsigned long long)output_profile->cache_misses[i]);
+            fprintf(file_handler, ";profile_%s_branch_misses:%llu\n", profile_phase_name(i),
+                    (unsigned long long)output_profile->branch_misses[i]);
+        }
+    }
+}
+
+/* initialize a binary file header with the values common to every file */
+static void init_binary_header(binary_file_header * header, int kind, int rows,
+                               int columns, unsigned int seed, long length)
+{
+    memset(header, 0, sizeof(binary_file_header));
+    memcpy(header->magic, "PERCBIN2", 8);
+    header->kind = kind;
+    header->rows = rows;
+    header->columns = columns;
+    header->depth = output_depth;
+    if (output_lattice) {
+        strncpy(header->lattice, output_lattice, sizeof(header->lattice) - 1);
+    }
+    header->seed = seed;
+    header->date = time(NULL);
+    header->length = length;
+}
+
+/* write a binary file header followed by its data columns, with one bulk
+   write per column */
+static void write_binary_file(const char * file_full_path,
+                              const binary_file_header * header, int ncolumns,
+                              const void * const * columns, const size_t * element_sizes)
+{
+    int i;
+    FILE * file_handler;
+
+    file_handler = fopen(file_full_path, "wb");
+    fwrite(header, sizeof(binary_file_header), 1, file_handler);
+    for (i = 0; i < ncolumns; i++) {
+        fwrite(columns[i], element_sizes[i], header->length, file_handler);
+    }
+    fclose(file_handler);
+}
+
 void print_lattice(const int * lattice, int rows, int columns, char with_borders)
 {
     int i, j;
@@ -80,12 +212,36 @@ char * format_file_full_path(const char * path, const char * prefix, int rows,
     char * file_full_path;
 
     file_full_path_length = strlen(path) + strlen(prefix) + 160;
+    if (output_lattice) {
+        file_full_path_length += strlen(output_lattice) + 1;
+    }
     file_full_path = (char *)malloc(file_full_path_length*sizeof(char));
-    sprintf(file_full_path, "%s/%s_%dx%d_%u_%.*e.csv", path, prefix, rows, columns, seed, DBL_DIG-1, other);
+    if (output_lattice) {
+        sprintf(file_full_path, "%s/%s_%s_%dx%d_%u_%.*e.%s", path, prefix, output_lattice,
+                rows, columns, seed, DBL_DIG-1, other, output_binary ? "bin" : "csv");
+    } else if (output_depth > 0) {
+        sprintf(file_full_path, "%s/%s_%dx%dx%d_%u_%.*e.%s", path, prefix, rows,
+                columns, output_depth, seed, DBL_DIG-1, other,
+                output_binary ? "bin" : "csv");
+    } else {
+        sprintf(file_full_path, "%s/%s_%dx%d_%u_%.*e.%s", path, prefix, rows, columns,
+                seed, DBL_DIG-1, other, output_binary ? "bin" : "csv");
+    }
 
     return file_full_path;
 }
 
+char * create_shard_output_path(const char * path, int shard_index)
+{
+    char * shard_path;
+
+    shard_path = (char *)malloc((strlen(path) + 32)*sizeof(char));
+    sprintf(shard_path, "%s/shard_%d", path, shard_index);
+    mkdir(shard_path, 0755);
+
+    return shard_path;
+}
+
 void write_lattice_to_file(const char * path, const int * lattice, int rows,
                            int columns, double probability, unsigned int seed)
 {
@@ -98,9 +254,23 @@ void write_lattice_to_file(const char * path, const int * lattice, int rows,
     current_time = time(NULL);
     file_full_path = format_file_full_path(path, "lattice", rows, columns, seed, probability);
 
+    if (output_binary) {
+        binary_file_header header;
+        const void * data[1];
+        size_t element_sizes[1];
+        init_binary_header(&header, BINARY_LATTICE, rows, columns, seed, ((long)rows)*columns);
+        header.probability = probability;
+        data[0] = lattice;
+        element_sizes[0] = sizeof(int32_t);
+        write_binary_file(file_full_path, &header, 1, data, element_sizes);
+        free(file_full_path);
+        return;
+    }
+
     file_handler = fopen(file_full_path, "w");
     fprintf(file_handler, ";rows:%d\n", rows);
     fprintf(file_handler, ";columns:%d\n", columns);
+    write_geometry_header(file_handler);
     fprintf(file_handler, ";seed:%u\n", seed);
     fprintf(file_handler, ";probability:%.*e\n", DBL_DIG-1, probability);
     fprintf(file_handler, ";date:%s", asctime(localtime(&current_time)));
@@ -118,6 +288,52 @@ void write_lattice_to_file(const char * path, const int * lattice, int rows,
     free(file_full_path);
 }
 
+/* write cluster statistics in binary format; the grid parameters are only
+   set when the statistics come from a probability sweep */
+static void write_cluster_statistics_to_binary_file(const char * path,
+                                                    const int * cluster_sizes,
+                                                    const int * cluster_sizes_counts,
+                                                    const int * cluster_sizes_percolated,
+                                                    int cluster_sizes_total_count,
+                                                    int rows, int columns,
+                                                    double probability,
+                                                    unsigned int seed,
+                                                    int realizations,
+                                                    const char * source,
+                                                    int grid_points,
+                                                    double probability_center,
+                                                    double decay)
+{
+    char * file_full_path;
+    binary_file_header header;
+    const void * data[3];
+    size_t element_sizes[3];
+
+    file_full_path = format_file_full_path(path, "clusters", rows, columns, seed, probability);
+
+    init_binary_header(&header, BINARY_CLUSTERS, rows, columns, seed,
+                       cluster_sizes_total_count);
+    header.probability = probability;
+    header.realizations = realizations;
+    header.grid_npoints = grid_points;
+    header.grid_center = probability_center;
+    header.grid_decay = decay;
+    header.bins_per_decade = output_bins_per_decade;
+    header.exact_sizes = output_exact_sizes;
+    if (source) {
+        strncpy(header.source, source, sizeof(header.source) - 1);
+    }
+    data[0] = cluster_sizes;
+    data[1] = cluster_sizes_counts;
+    data[2] = cluster_sizes_percolated;
+    element_sizes[0] = sizeof(int32_t);
+    element_sizes[1] = sizeof(int32_t);
+    element_sizes[2] = sizeof(int32_t);
+    write_binary_file(file_full_path, &header, 3, data, element_sizes);
+
+    free(file_full_path);
+}
+
 void write_cluster_statistics_to_file(const char * path,
                                       const int * cluster_sizes,
                                       const int * cluster_sizes_counts,
@@ -132,18 +348,33 @@ void write_cluster_statistics_to_file(const char * path,
     char * file_full_path;
     FILE * file_handler;
 
+    if (output_binary) {
+        write_cluster_statistics_to_binary_file(path, cluster_sizes, cluster_sizes_counts,
+                                                cluster_sizes_percolated,
+                                                cluster_sizes_total_count, rows,
+                                                columns, probability, seed,
+                                                realizations, NULL, 0, 0, 0);
+        return;
+    }
+
     current_time = time(NULL);
     file_full_path = format_file_full_path(path, "clusters", rows, columns, seed, probability);
 
     file_handler = fopen(file_full_path, "w");
     fprintf(file_handler, ";rows:%d\n", rows);
     fprintf(file_handler, ";columns:%d\n", columns);
+    write_geometry_header(file_handler);
     fprintf(file_handler, ";seed:%u\n", seed);
     fprintf(file_handler, ";probability:%.*e\n", DBL_DIG-1, probability);
     fprintf(file_handler, ";realizations:%d\n", realizations);
     if (other) {
         fprintf(file_handler, "%s", other);
     }
+    if (output_bins_per_decade > 0) {
+        fprintf(file_handler, ";bins_per_decade:%d\n", output_bins_per_decade);
+        fprintf(file_handler, ";exact_sizes:%d\n", output_exact_sizes);
+    }
+    write_profile_header(file_handler);
     fprintf(file_handler, ";date:%s", asctime(localtime(&current_time)));
     for (i = 0; i < cluster_sizes_total_count; i++) {
         fprintf(file_handler, "%d,%d,%d\n", cluster_sizes[i], cluster_sizes_counts[i],
@@ -169,13 +400,31 @@ void write_critical_point_bisection_search_results(const char * path,
     current_time = time(NULL);
     file_full_path = format_file_full_path(path, "critical_bisection_search", rows, columns, seed, number_trials);
 
+    if (output_binary) {
+        binary_file_header header;
+        const void * data[1];
+        size_t element_sizes[1];
+        init_binary_header(&header, BINARY_CRITICAL_BISECTION_SEARCH, rows, columns,
+                           seed, number_trials);
+        header.start_probability = start_probability;
+        header.number_trials = number_trials;
+        header.precision = precision;
+        data[0] = critical_points;
+        element_sizes[0] = sizeof(double);
+        write_binary_file(file_full_path, &header, 1, data, element_sizes);
+        free(file_full_path);
+        return;
+    }
+
     file_handler = fopen(file_full_path, "w");
     fprintf(file_handler, ";rows:%d\n", rows);
     fprintf(file_handler, ";columns:%d\n", columns);
+    write_geometry_header(file_handler);
     fprintf(file_handler, ";seed:%u\n", seed);
     fprintf(file_handler, ";pini:%.*e\n", DBL_DIG-1, start_probability);
     fprintf(file_handler, ";ntrials:%d\n", number_trials);
     fprintf(file_handler, ";precision:%d\n", precision);
+    write_profile_header(file_handler);
     fprintf(file_handler, ";date:%s", asctime(localtime(&current_time)));
     for (i = 0; i < number_trials; i++) {
         fprintf(file_handler, "%.*e\n", DBL_DIG-1, critical_points[i]);
@@ -200,6 +449,17 @@ void write_probability_sweep_cluster_statistics_to_file(const char * path,
 {
     char * other;
 
+    if (output_binary) {
+        write_cluster_statistics_to_binary_file(path, cluster_sizes, cluster_sizes_counts,
+                                                cluster_sizes_percolated,
+                                                cluster_sizes_total_count, rows,
+                                                columns, probability, seed,
+                                                realizations, "probability_sweep",
+                                                grid_points, probability_center,
+                                                decay);
+        return;
+    }
+
     other = (char *)malloc(140*sizeof(char));
     sprintf(other, ";source:probability_sweep\n;grid_npoints:%d\n;grid_center:%.*e\n;grid_decay:%.*e\n",
             grid_points, DBL_DIG-1, probability_center, DBL_DIG-1, decay);
@@ -229,9 +489,31 @@ void write_probability_sweep_percolation_probability(const char * path,
     current_time = time(NULL);
     file_full_path = format_file_full_path(path, "percolation_probability", rows, columns, seed, grid_npoints);
 
+    if (output_binary) {
+        binary_file_header header;
+        const void * data[3];
+        size_t element_sizes[3];
+        init_binary_header(&header, BINARY_PERCOLATION_PROBABILITY, rows, columns,
+                           seed, grid_npoints);
+        header.grid_npoints = grid_npoints;
+        header.grid_center = probability_center;
+        header.grid_decay = decay;
+        strcpy(header.source, "probability_sweep");
+        data[0] = probability_grid;
+        data[1] = percolation_counts;
+        data[2] = realizations;
+        element_sizes[0] = sizeof(double);
+        element_sizes[1] = sizeof(int32_t);
+        element_sizes[2] = sizeof(int32_t);
+        write_binary_file(file_full_path, &header, 3, data, element_sizes);
+        free(file_full_path);
+        return;
+    }
+
     file_handler = fopen(file_full_path, "w");
     fprintf(file_handler, ";rows:%d\n", rows);
     fprintf(file_handler, ";columns:%d\n", columns);
+    write_geometry_header(file_handler);
     fprintf(file_handler, ";seed:%u\n", seed);
     fprintf(file_handler, ";grid_npoints:%d\n", grid_npoints);
     fprintf(file_handler, ";grid_center:%.*e\n", DBL_DIG-1, probability_center);
@@ -247,6 +529,81 @@ void write_probability_sweep_percolation_probability(const char * path,
     free(file_full_path);
 }
 
+void write_probability_sweep_observables(const char * path,
+                                         const double * probability_grid,
+                                         int grid_npoints,
+                                         double probability_center,
+                                         double decay,
+                                         const int * realizations,
+                                         const double * mean_cluster_size,
+                                         const double * mean_cluster_size_variance,
+                                         const double * second_moment,
+                                         const double * second_moment_variance,
+                                         const double * strength,
+                                         const double * strength_variance,
+                                         int rows, int columns,
+                                         unsigned int seed)
+{
+    int i;
+    time_t current_time;
+    char * file_full_path;
+    FILE * file_handler;
+
+    current_time = time(NULL);
+    file_full_path = format_file_full_path(path, "percolation_observables", rows, columns, seed, grid_npoints);
+
+    if (output_binary) {
+        binary_file_header header;
+        const void * data[8];
+        size_t element_sizes[8];
+        init_binary_header(&header, BINARY_OBSERVABLES, rows, columns, seed,
+                           grid_npoints);
+        header.grid_npoints = grid_npoints;
+        header.grid_center = probability_center;
+        header.grid_decay = decay;
+        strcpy(header.source, "probability_sweep");
+        data[0] = probability_grid;
+        data[1] = realizations;
+        data[2] = mean_cluster_size;
+        data[3] = mean_cluster_size_variance;
+        data[4] = second_moment;
+        data[5] = second_moment_variance;
+        data[6] = strength;
+        data[7] = strength_variance;
+        element_sizes[0] = sizeof(double);
+        element_sizes[1] = sizeof(int32_t);
+        for (i = 2; i < 8; i++) {
+            element_sizes[i] = sizeof(double);
+        }
+        write_binary_file(file_full_path, &header, 8, data, element_sizes);
+        free(file_full_path);
+        return;
+    }
+
+    file_handler = fopen(file_full_path, "w");
+    fprintf(file_handler, ";rows:%d\n", rows);
+    fprintf(file_handler, ";columns:%d\n", columns);
+    write_geometry_header(file_handler);
+    fprintf(file_handler, ";seed:%u\n", seed);
+    fprintf(file_handler, ";grid_npoints:%d\n", grid_npoints);
+    fprintf(file_handler, ";grid_center:%.*e\n", DBL_DIG-1, probability_center);
+    fprintf(file_handler, ";grid_decay:%.*e\n", DBL_DIG-1, decay);
+    fprintf(file_handler, ";fields:probability,realizations,"
+            "mean_cluster_size,mean_cluster_size_variance,second_moment,"
+            "second_moment_variance,strength,strength_variance\n");
+    fprintf(file_handler, ";date:%s", asctime(localtime(&current_time)));
+    for (i = 0; i < grid_npoints; i++) {
+        fprintf(file_handler, "%.*e,%d,%.*e,%.*e,%.*e,%.*e,%.*e,%.*e\n",
+                DBL_DIG-1, probability_grid[i], realizations[i],
+                DBL_DIG-1, mean_cluster_size[i], DBL_DIG-1, mean_cluster_size_variance[i],
+                DBL_DIG-1, second_moment[i], DBL_DIG-1, second_moment_variance[i],
+                DBL_DIG-1, strength[i], DBL_DIG-1, strength_variance[i]);
+    }
+
+    fclose(file_handler);
+    free(file_full_path);
+}
+
 void write_mass_windowing_results(const char * path, const int * window_sizes,
                                   const unsigned long * mass, int window_sizes_count,
                                   double probability, int nrealizations,
@@ -260,12 +617,37 @@ void write_mass_windowing_results(const char * path, const int * window_sizes,
     current_time = time(NULL);
     file_full_path = format_file_full_path(path, "mass_windowing", rows, columns, seed, probability);
 
+    if (output_binary) {
+        binary_file_header header;
+        const void * data[2];
+        size_t element_sizes[2];
+        uint64_t * mass_column;
+        mass_column = (uint64_t *)malloc(window_sizes_count*sizeof(uint64_t));
+        for (i = 0; i < window_sizes_count; i++) {
+            mass_column[i] = mass[i];
+        }
+        init_binary_header(&header, BINARY_MASS_WINDOWING, rows, columns, seed,
+                           window_sizes_count);
+        header.probability = probability;
+        header.realizations = nrealizations;
+        data[0] = mass_column;
+        data[1] = window_sizes;
+        element_sizes[0] = sizeof(uint64_t);
+        element_sizes[1] = sizeof(int32_t);
+        write_binary_file(file_full_path, &header, 2, data, element_sizes);
+        free(mass_column);
+        free(file_full_path);
+        return;
+    }
+
     file_handler = fopen(file_full_path, "w");
     fprintf(file_handler, ";rows:%d\n", rows);
     fprintf(file_handler, ";columns:%d\n", columns);
+    write_geometry_header(file_handler);
     fprintf(file_handler, ";probability:%.*e\n", DBL_DIG-1, probability);
     fprintf(file_handler, ";nrealizations:%d\n", nrealizations);
     fprintf(file_handler, ";seed:%u\n", seed);
+    write_profile_header(file_handler);
     fprintf(file_handler, ";date:%s", asctime(localtime(&current_time)));
     for (i = 0; i < window_sizes_count; i++) {
         fprintf(file_handler, "%d,%lu,%.*e\n", window_sizes[i], mass[i],
@@ -275,3 +657,182 @@ void write_mass_windowing_results(const char * path, const int * window_sizes,
     fclose(file_handler);
     free(file_full_path);
 }
+
+void write_gyration_results(const char * path, const int * cluster_sizes,
+                            const int * cluster_sizes_counts,
+                            const double * radius_gyration_squared,
+                            const double * extent, int cluster_sizes_total_count,
+                            double probability, int nrealizations,
+                            int rows, int columns, unsigned int seed)
+{
+    int i;
+    time_t current_time;
+    char * file_full_path;
+    FILE * file_handler;
+
+    current_time = time(NULL);
+    file_full_path = format_file_full_path(path, "gyration", rows, columns, seed, probability);
+
+    if (output_binary) {
+        binary_file_header header;
+        const void * data[4];
+        size_t element_sizes[4];
+        init_binary_header(&header, BINARY_GYRATION, rows, columns, seed,
+                           cluster_sizes_total_count);
+        header.probability = probability;
+        header.realizations = nrealizations;
+        header.bins_per_decade = output_bins_per_decade;
+        header.exact_sizes = output_exact_sizes;
+        data[0] = cluster_sizes;
+        data[1] = cluster_sizes_counts;
+        data[2] = radius_gyration_squared;
+        data[3] = extent;
+        element_sizes[0] = sizeof(int32_t);
+        element_sizes[1] = sizeof(int32_t);
+        element_sizes[2] = sizeof(double);
+        element_sizes[3] = sizeof(double);
+        write_binary_file(file_full_path, &header, 4, data, element_sizes);
+        free(file_full_path);
+        return;
+    }
+
+    file_handler = fopen(file_full_path, "w");
+    fprintf(file_handler, ";rows:%d\n", rows);
+    fprintf(file_handler, ";columns:%d\n", columns);
+    write_geometry_header(file_handler);
+    fprintf(file_handler, ";probability:%.*e\n", DBL_DIG-1, probability);
+    fprintf(file_handler, ";nrealizations:%d\n", nrealizations);
+    fprintf(file_handler, ";seed:%u\n", seed);
+    if (output_bins_per_decade > 0) {
+        fprintf(file_handler, ";bins_per_decade:%d\n", output_bins_per_decade);
+        fprintf(file_handler, ";exact_sizes:%d\n", output_exact_sizes);
+    }
+    fprintf(file_handler, ";date:%s", asctime(localtime(&current_time)));
+    for (i = 0; i < cluster_sizes_total_count; i++) {
+        fprintf(file_handler, "%d,%d,%.*e,%.*e\n", cluster_sizes[i],
+                cluster_sizes_counts[i], DBL_DIG-1, radius_gyration_squared[i],
+                DBL_DIG-1, extent[i]);
+    }
+
+    fclose(file_handler);
+    free(file_full_path);
+}
+
+void write_pair_connectivity_results(const char * path, const double * connected_pairs,
+                                     const double * site_pairs, int radius_count,
+                                     double probability, int nrealizations,
+                                     int rows, int columns, unsigned int seed)
+{
+    int i;
+    time_t current_time;
+    char * file_full_path;
+    FILE * file_handler;
+
+    current_time = time(NULL);
+    file_full_path = format_file_full_path(path, "pair_connectivity", rows, columns, seed, probability);
+
+    if (output_binary) {
+        binary_file_header header;
+        const void * data[3];
+        size_t element_sizes[3];
+        int32_t * radius;
+        radius = (int32_t *)malloc(radius_count*sizeof(int32_t));
+        for (i = 0; i < radius_count; i++) {
+            radius[i] = i;
+        }
+        init_binary_header(&header, BINARY_PAIR_CONNECTIVITY, rows, columns, seed,
+                           radius_count);
+        header.probability = probability;
+        header.realizations = nrealizations;
+        data[0] = radius;
+        data[1] = connected_pairs;
+        data[2] = site_pairs;
+        element_sizes[0] = sizeof(int32_t);
+        element_sizes[1] = sizeof(double);
+        element_sizes[2] = sizeof(double);
+        write_binary_file(file_full_path, &header, 3, data, element_sizes);
+        free(radius);
+        free(file_full_path);
+        return;
+    }
+
+    file_handler = fopen(file_full_path, "w");
+    fprintf(file_handler, ";rows:%d\n", rows);
+    fprintf(file_handler, ";columns:%d\n", columns);
+    write_geometry_header(file_handler);
+    fprintf(file_handler, ";probability:%.*e\n", DBL_DIG-1, probability);
+    fprintf(file_handler, ";nrealizations:%d\n", nrealizations);
+    fprintf(file_handler, ";seed:%u\n", seed);
+    fprintf(file_handler, ";date:%s", asctime(localtime(&current_time)));
+    for (i = 0; i < radius_count; i++) {
+        fprintf(file_handler, "%d,%.*e,%.*e,%.*e\n", i, DBL_DIG-1, connected_pairs[i],
+                DBL_DIG-1, site_pairs[i],
+                DBL_DIG-1, connected_pairs[i]/(site_pairs[i]*nrealizations));
+    }
+
+    fclose(file_handler);
+    free(file_full_path);
+}
+
+/* critical point estimates, one per trial, in the same layout as the
+   bisection search results */
+static void write_critical_point_estimates(const char * path, const char * prefix,
+                                           int kind, const double * critical_points,
+                                           int number_trials, int rows, int columns,
+                                           unsigned int seed)
+{
+    int i;
+    time_t current_time;
+    char * file_full_path;
+    FILE * file_handler;
+
+    current_time = time(NULL);
+    file_full_path = format_file_full_path(path, prefix, rows, columns, seed, number_trials);
+
+    if (output_binary) {
+        binary_file_header header;
+        const void * data[1];
+        size_t element_sizes[1];
+        init_binary_header(&header, kind, rows, columns, seed, number_trials);
+        header.number_trials = number_trials;
+        data[0] = critical_points;
+        element_sizes[0] = sizeof(double);
+        write_binary_file(file_full_path, &header, 1, data, element_sizes);
+        free(file_full_path);
+        return;
+    }
+
+    file_handler = fopen(file_full_path, "w");
+    fprintf(file_handler, ";rows:%d\n", rows);
+    fprintf(file_handler, ";columns:%d\n", columns);
+    write_geometry_header(file_handler);
+    fprintf(file_handler, ";seed:%u\n", seed);
+    fprintf(file_handler, ";ntrials:%d\n", number_trials);
+    fprintf(file_handler, ";date:%s", asctime(localtime(&current_time)));
+    for (i = 0; i < number_trials; i++) {
+        fprintf(file_handler, "%.*e\n", DBL_DIG-1, critical_points[i]);
+    }
+
+    fclose(file_handler);
+    free(file_full_path);
+}
+
+void write_critical_point_gradient_results(const char * path,
+                                           const double * critical_points,
+                                           int number_trials, int rows, int columns,
+                                           unsigned int seed)
+{
+    write_critical_point_estimates(path, "critical_gradient", BINARY_CRITICAL_GRADIENT,
+                                   critical_points, number_trials, rows, columns,
+                                   seed);
+}
+
+void write_critical_point_invasion_results(const char * path,
+                                           const double * critical_points,
+                                           int number_trials, int rows, int columns,
+                                           unsigned int seed)
+{
+    write_critical_point_estimates(path, "critical_invasion", BINARY_CRITICAL_INVASION,
+                                   critical_points, number_trials, rows, columns,
+                                   seed);
+}
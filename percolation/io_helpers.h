@@ -9,6 +9,142 @@
 #ifndef IO_HELPERS_H
 #define IO_HELPERS_H
 
+#include <stdint.h>
+
+#include "profiling.h"
+
+/*! Kinds of results stored in binary output files. */
+enum binary_file_kind {
+    BINARY_LATTICE = 1,
+    BINARY_CLUSTERS = 2,
+    BINARY_CRITICAL_BISECTION_SEARCH = 3,
+    BINARY_PERCOLATION_PROBABILITY = 4,
+    BINARY_MASS_WINDOWING = 5,
+    BINARY_OBSERVABLES = 6,
+    BINARY_GYRATION = 7,
+    BINARY_PAIR_CONNECTIVITY = 8,
+    BINARY_CRITICAL_GRADIENT = 9,
+    BINARY_CRITICAL_INVASION = 10
+};
+
+/*! Header of the binary output files.
+
+    Binary files start with this fixed size (160 bytes) header, followed by
+    the data columns stored contiguously one after the other, each with
+    length elements, in native byte order:
+    - lattice: int32 lattice[rows*columns].
+    - clusters: int32 sizes, int32 counts, int32 percolated.
+    - critical_bisection_search: double critical_points.
+    - percolation_probability: double probability, int32 percolation_counts,
+      int32 realizations.
+    - mass_windowing: uint64 mass, int32 window_sizes.
+    - observables: double probability, int32 realizations, then double mean
+      and variance of the mean cluster size, of the second moment and of the
+      strength.
+    - gyration: int32 sizes, int32 counts, double radius_gyration_squared,
+      double extent.
+    - pair_connectivity: int32 radius, double connected_pairs,
+      double site_pairs.
+    - critical_gradient: double critical_points.
+    - critical_invasion: double critical_points.
+
+    Fields that do not apply to a given kind of file are set to zero. Files
+    written before the depth was added start with "PERCBIN1" and a 128 bytes
+    header that ends at source.
+*/
+typedef struct {
+    char magic[8]; /*!< always "PERCBIN2" */
+    int32_t kind; /*!< one of binary_file_kind */
+    int32_t rows; /*!< the number of rows in the lattice */
+    int32_t columns; /*!< the number of columns in the lattice */
+    uint32_t seed; /*!< the random number generator seed */
+    int64_t date; /*!< when the file was written (seconds since the epoch) */
+    int64_t length; /*!< the number of elements in each data column */
+    double probability; /*!< the occupation probability */
+    double grid_center; /*!< center of the probability grid */
+    double grid_decay; /*!< exponential decay coefficient of the probability grid */
+    double start_probability; /*!< initial probability of the bisection search */
+    int32_t realizations; /*!< the number of lattice realizations */
+    int32_t grid_npoints; /*!< the number of points in the probability grid */
+    int32_t number_trials; /*!< the number of bisection search trials */
+    int32_t precision; /*!< the precision of the bisection search */
+    int32_t bins_per_decade; /*!< logarithmic bins per decade of the cluster sizes (0 if exact) */
+    int32_t exact_sizes; /*!< largest cluster size that is not binned */
+    char source[32]; /*!< program that generated the data (optional) */
+    int32_t depth; /*!< the number of planes of cubic lattices (0 for square ones) */
+    char lattice[16]; /*!< the kind of lattice set with set_output_lattice (empty for square site lattices) */
+    char reserved[12]; /*!< zero, for future fields */
+} binary_file_header;
+
+/*! Select the format of the files written by the functions in this file.
+
+    @param format either "csv" (the default) or "binary".
+    @return A boolean indicating whether the format is valid.
+*/
+char set_output_format(const char * format);
+
+/*! Record that the cluster sizes written by the functions in this file are
+    logarithmically binned, so that the files describe their bins.
+
+    @param bins_per_decade the number of logarithmic bins per decade, or 0 if
+        the cluster sizes are exact (the default).
+    @param exact_sizes the largest size that is not binned.
+
+    @see cluster_size_bin
+*/
+void set_cluster_size_binning(int bins_per_decade, int exact_sizes);
+
+/*! Get the binning of the cluster sizes set with set_cluster_size_binning.
+
+    @param bins_per_decade pointer where to store the number of bins per
+        decade (0 if exact).
+    @param exact_sizes pointer where to store the largest exact size.
+*/
+void get_cluster_size_binning(int * bins_per_decade, int * exact_sizes);
+
+/*! Set the profile written in the header of the csv files written next by
+    the functions in this file.
+
+    The wall time (and the hardware counters, if measured) of every phase
+    but the output itself are written as ;profile_PHASE_QUANTITY:VALUE lines.
+
+    @param profile pointer to the profile, or NULL to stop writing it (the
+        default).
+
+    @see enable_profiling
+*/
+void set_output_profile(const phase_profile * profile);
+
+/*! Set the depth of the lattices whose results are written next by the
+    functions in this file, for three dimensional lattices.
+
+    The files are then named after the three sides of the lattice (e.g.
+    clusters_64x64x64_...), their csv headers have a ;depth:VALUE line and
+    their binary headers store it in the depth field.
+
+    @param depth the number of planes of the lattices, or 0 for two
+        dimensional lattices (the default).
+*/
+void set_output_depth(int depth);
+
+/*! Set the kind of lattice whose results are written next by the functions
+    in this file, for lattices other than the square one.
+
+    The name of the lattice is added to the names of the files (e.g.
+    clusters_triangular_64x64_...) and their csv headers have a
+    ;lattice:NAME line. Binary headers store it in the lattice field.
+
+    @param lattice the name of the lattice (e.g. "triangular"), or NULL for
+        square lattices (the default).
+*/
+void set_output_lattice(const char * lattice);
+
+/*! Get the kind of lattice set with set_output_lattice.
+
+    @return The name of the lattice, or NULL for square lattices.
+*/
+const char * get_output_lattice(void);
+
 /*! Print lattice to the standard output.
 
     @param lattice pointer to the lattice to be printed.
@@ -19,6 +155,16 @@
 */
 void print_lattice(const int * lattice, int rows, int columns, char with_borders);
 
+/*! Create the output folder for one shard of a run split across processes.
+
+    @param path path to the folder where the data of the whole run is written.
+    @param shard_index the index of the shard.
+    @returns pointer to the path of the shard folder (path/shard_index).
+
+    @warning The returned path must be manually free'd by the user.
+*/
+char * create_shard_output_path(const char * path, int shard_index);
+
 /*! Write lattice to file.
 
     @param path path to the folder were the lattice will be written. If the file
@@ -151,6 +297,45 @@ void write_probability_sweep_percolation_probability(const char * path,
                                                      unsigned int seed);
 
 
+/*! Write the mean and variance over realizations of the observables of each
+    point of a probability sweep to a file.
+
+    @param path path to the folder where the data will be written. If the file
+        exists it will be overwritten.
+    @param probability_grid the population probabilities tested.
+    @param grid_npoints the number of points in the probability grid.
+    @param probability_center the central probability of the exponential grid.
+    @param decay the exponential decay coefficient of the grid.
+    @param realizations how many times each probability was tested.
+    @param mean_cluster_size mean over realizations of the mean size of the
+        non percolating cluster an occupied site belongs to.
+    @param mean_cluster_size_variance variance of the above over realizations.
+    @param second_moment mean over realizations of the sum of s^2 n_s over
+        non percolating clusters, per site.
+    @param second_moment_variance variance of the above over realizations.
+    @param strength mean over realizations of the fraction of sites that
+        belong to percolating clusters.
+    @param strength_variance variance of the above over realizations.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param seed the random number generator seed used at the beginning of the
+        probability sweep.
+*/
+void write_probability_sweep_observables(const char * path,
+                                         const double * probability_grid,
+                                         int grid_npoints,
+                                         double probability_center,
+                                         double decay,
+                                         const int * realizations,
+                                         const double * mean_cluster_size,
+                                         const double * mean_cluster_size_variance,
+                                         const double * second_moment,
+                                         const double * second_moment_variance,
+                                         const double * strength,
+                                         const double * strength_variance,
+                                         int rows, int columns,
+                                         unsigned int seed);
+
 /*! Write the percolating cluster mass for given window sizes to a file.
 
     @param path path to the folder where the data will be written. If the file
@@ -169,4 +354,97 @@ void write_mass_windowing_results(const char * path, const int * window_sizes,
                                   const unsigned long * mass, int window_sizes_count,
                                   double probability, int nrealizations,
                                   int rows, int columns, unsigned int seed);
+
+/*! Write the radius of gyration and extent of clusters, as a function of
+    their size, to a file.
+
+    @param path path to the folder where the data will be written. If the file
+        exists it will be overwritten.
+    @param cluster_sizes sizes of the clusters (or smallest size of each bin
+        if the sizes are binned).
+    @param cluster_sizes_counts how many clusters of each size were found.
+    @param radius_gyration_squared sum over the clusters of each size of their
+        squared radius of gyration.
+    @param extent sum over the clusters of each size of the largest side of
+        their bounding box.
+    @param cluster_sizes_total_count the number of different sizes.
+    @param probability the population probability used.
+    @param nrealizations how many lattices were sampled.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param seed the random number generator seed.
+*/
+void write_gyration_results(const char * path, const int * cluster_sizes,
+                            const int * cluster_sizes_counts,
+                            const double * radius_gyration_squared,
+                            const double * extent, int cluster_sizes_total_count,
+                            double probability, int nrealizations,
+                            int rows, int columns, unsigned int seed);
+
+/*! Write the radially averaged pair connectivity to a file.
+
+    @param path path to the folder where the data will be written. If the file
+        exists it will be overwritten.
+    @param connected_pairs number of pairs of sites in the same cluster at
+        each distance, summed over all realizations.
+    @param site_pairs number of pairs of sites of a single lattice at each
+        distance.
+    @param radius_count the number of distances (starting from 0).
+    @param probability the population probability used.
+    @param nrealizations how many lattices were sampled.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param seed the random number generator seed.
+
+    @see radial_pair_connectivity
+*/
+void write_pair_connectivity_results(const char * path, const double * connected_pairs,
+                                     const double * site_pairs, int radius_count,
+                                     double probability, int nrealizations,
+                                     int rows, int columns, unsigned int seed);
+
+/*! Write the critical point estimates of gradient percolation to a file.
+
+    The file has the same layout as the one written by
+    write_critical_point_bisection_search_results, one estimate per trial,
+    so both can be analyzed in the same way.
+
+    @param path path to the folder where the data will be written. If the file
+        exists it will be overwritten.
+    @param critical_points array with the critical point estimated from the
+        front of each trial.
+    @param number_trials number of gradient lattices sampled.
+    @param rows the number of rows in the lattice (the length of the front).
+    @param columns the number of columns in the lattice (the length along
+        which the occupation probability varies).
+    @param seed the random number generator seed.
+
+    @see gradient_percolation_front
+*/
+void write_critical_point_gradient_results(const char * path,
+                                           const double * critical_points,
+                                           int number_trials, int rows, int columns,
+                                           unsigned int seed);
+
+/*! Write the thresholds of invasion percolation clusters to a file.
+
+    The file has the same layout as the one written by
+    write_critical_point_bisection_search_results, one threshold per trial.
+
+    @param path path to the folder where the data will be written. If the file
+        exists it will be overwritten.
+    @param critical_points array with the threshold probability of each
+        trial.
+    @param number_trials number of invasion clusters grown.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param seed the random number generator seed.
+
+    @see invade_lattice
+*/
+void write_critical_point_invasion_results(const char * path,
+                                           const double * critical_points,
+                                           int number_trials, int rows, int columns,
+                                           unsigned int seed);
+
 #endif /* IO_HELPERS_H */
@@ -2,28 +2,77 @@
 /* MIT License (see root directory) */
 /* see header file for detailed documentation of each function */
 
+#define _GNU_SOURCE
+
 #include "lattice.h"
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include "random.h"
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+/* size of the transparent huge pages of x86-64 and most arm64 kernels */
+#define HUGE_PAGE_SIZE (2*1024*1024)
+
+/* whether large buffers should be backed by huge pages */
+static char lattice_huge_pages = 0;
+
+char set_lattice_huge_pages(char enabled)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    lattice_huge_pages = enabled;
+    return 1;
+#else
+    lattice_huge_pages = 0;
+    return !enabled;
+#endif
+}
+
+void * allocate_aligned(size_t bytes)
+{
+    void * buffer;
+    size_t alignment;
+
+    alignment = LATTICE_ALIGNMENT;
+    if (lattice_huge_pages && bytes >= HUGE_PAGE_SIZE) {
+        /* whole huge pages, so that none is shared with other allocations */
+        alignment = HUGE_PAGE_SIZE;
+        bytes = (bytes + HUGE_PAGE_SIZE - 1)/HUGE_PAGE_SIZE*HUGE_PAGE_SIZE;
+    }
+    if (posix_memalign(&buffer, alignment, bytes > 0 ? bytes : 1) != 0) {
+        return NULL;
+    }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (alignment == HUGE_PAGE_SIZE) {
+        madvise(buffer, bytes, MADV_HUGEPAGE);
+    }
+#endif
+
+    return buffer;
+}
 
 int * allocate_lattice(int rows, int columns, char initialize)
 {
     int *lattice;
-    int i;
 
-    lattice = (int *) malloc(rows*columns*sizeof(int));
+    lattice = (int *)allocate_aligned(((size_t)rows)*columns*sizeof(int));
 
-    if (!initialize) {
+    if (!initialize || !lattice) {
         return lattice;
     }
 
-    for (i = 0; i < rows*columns; i++) {
-        lattice[i] = 0;
-    }
+    initialize_lattice(lattice, rows, columns);
 
     return lattice;
 }
 
+void initialize_lattice(int * lattice, int rows, int columns)
+{
+    memset(lattice, 0, ((size_t)rows)*columns*sizeof(int));
+}
+
 void populate_lattice(double probability, int * lattice, int rows, int columns,
                       unsigned int seed)
 {
@@ -45,3 +94,138 @@ void populate_lattice(double probability, int * lattice, int rows, int columns,
 
     return;
 }
+
+/* largest random number that populate_lattice takes as occupied, found
+   with the same floating point comparison so both draw identical sites */
+static uint32_t occupation_threshold(double probability)
+{
+    uint32_t threshold;
+
+    threshold = (uint32_t)(probability*RAND_MAX_PCG);
+    while (threshold < RAND_MAX_PCG &&
+           ((double)(threshold + 1))/RAND_MAX_PCG <= probability) {
+        threshold++;
+    }
+    while (threshold > 0 && ((double)threshold)/RAND_MAX_PCG > probability) {
+        threshold--;
+    }
+    return threshold;
+}
+
+void populate_lattice_threshold(double probability, int * lattice, int rows,
+                                int columns, unsigned int seed)
+{
+    int i;
+    uint32_t threshold;
+
+    if (seed > 0) {
+        srand_pcg(seed);
+    }
+
+    /* rand_pcg()/RAND_MAX_PCG <= probability, without the division */
+    if (probability < 0 || probability >= 1) {
+        for (i = 0; i < rows*columns; i++) {
+            rand_pcg();
+            lattice[i] = probability >= 1;
+        }
+        return;
+    }
+    threshold = occupation_threshold(probability);
+    for (i = 0; i < rows*columns; i++) {
+        lattice[i] = rand_pcg() <= threshold;
+    }
+
+    return;
+}
+
+void populate_lattice_r(double probability, int * lattice, int rows, int columns,
+                        pcg32_random_t * rng)
+{
+    int i;
+    uint32_t threshold;
+
+    if (probability < 0 || probability >= 1) {
+        for (i = 0; i < rows*columns; i++) {
+            pcg32_random_r(rng);
+            lattice[i] = probability >= 1;
+        }
+        return;
+    }
+    threshold = occupation_threshold(probability);
+    for (i = 0; i < rows*columns; i++) {
+        lattice[i] = pcg32_random_r(rng) <= threshold;
+    }
+
+    return;
+}
+
+void populate_lattice_sparse(double probability, int * lattice, int rows,
+                             int columns, unsigned int seed)
+{
+    long i;
+    long size;
+    int minority; /* value of the sites whose positions are drawn */
+    double q; /* probability of a minority site */
+    double log_complement;
+    double u;
+    double gap;
+
+    if (seed > 0) {
+        srand_pcg(seed);
+    }
+
+    size = ((long)rows)*columns;
+    minority = probability <= 0.5;
+    q = minority ? probability : 1 - probability;
+    for (i = 0; i < size; i++) {
+        lattice[i] = !minority;
+    }
+    if (q <= 0) {
+        return;
+    }
+
+    /* skip a geometrically distributed number of majority sites before
+       each minority one */
+    log_complement = log(1 - q);
+    i = -1;
+    while (1) {
+        u = (rand_pcg() + 1.0)/(RAND_MAX_PCG + 2.0);
+        gap = floor(log(u)/log_complement);
+        if (i + 1 + gap >= size) {
+            break;
+        }
+        i += 1 + (long)gap;
+        lattice[i] = minority;
+    }
+
+    return;
+}
+
+void populate_lattice_gradient(double start_probability, double end_probability,
+                               int * lattice, int rows, int columns,
+                               unsigned int seed)
+{
+    int i;
+    int j;
+    double q;
+    double probability;
+
+    if (seed > 0) {
+        srand_pcg(seed);
+    }
+
+    for (i = 0; i < rows; i++) {
+        for (j = 0; j < columns; j++) {
+            probability = start_probability +
+                          (end_probability - start_probability)*j/(columns - 1);
+            q = ((double)rand_pcg())/RAND_MAX_PCG;
+            if (q <= probability) {
+                lattice[i*columns + j] = 1;
+            } else {
+                lattice[i*columns + j] = 0;
+            }
+        }
+    }
+
+    return;
+}
@@ -9,6 +9,38 @@
 #ifndef LATTICE_H
 #define LATTICE_H
 
+#include <stddef.h>
+#include "random.h"
+
+/*! Alignment in bytes of the memory given by allocate_aligned (a cache
+    line, and enough for any SIMD load). */
+#define LATTICE_ALIGNMENT 64
+
+/*! Allocate memory for lattices or other large buffers.
+
+    The memory is aligned to LATTICE_ALIGNMENT bytes. If huge pages were
+    enabled with set_lattice_huge_pages and the buffer spans at least one
+    huge page, it is aligned to the huge page size and the kernel is advised
+    to back it with transparent huge pages (Linux only).
+
+    The memory is not touched, so its pages are placed in the memory of the
+    NUMA node of the thread that first writes to them.
+
+    @param bytes the size of the buffer in bytes.
+    @return A pointer to the allocated memory, or NULL if it could not be
+        allocated.
+    @warning The allocated memory must be manually free'd by the user.
+*/
+void * allocate_aligned(size_t bytes);
+
+/*! Back large lattices with transparent huge pages, to reduce TLB misses.
+
+    @param enabled boolean indicating whether allocate_aligned (and thus
+        allocate_lattice) should request huge pages.
+    @return A boolean indicating whether huge pages are supported.
+*/
+char set_lattice_huge_pages(char enabled);
+
 /*! Allocate lattice in memory.
 
     @param rows the number of rows in the lattice.
@@ -16,11 +48,24 @@
     @param initialize boolean indicating whether the lattice should also be
         initialized after allocating.
     @return A pointer to the allocated lattice.
-    @note The lattice is allocated using row-major ordering.
+    @note The lattice is allocated using row-major ordering, with
+        allocate_aligned.
     @warning The allocated lattice must be manually free'd by the user.
 */
 int * allocate_lattice(int rows, int columns, char initialize);
 
+/*! Set all the sites of a lattice to empty.
+
+    Called from the thread that will use the lattice right after allocating
+    it, this also places the lattice in the memory of the NUMA node of that
+    thread (first touch).
+
+    @param lattice pointer to the lattice.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+*/
+void initialize_lattice(int * lattice, int rows, int columns);
+
 /*! Populate lattice with given probability.
 
     @param probability the probability of each site to be occupied.
@@ -33,4 +78,87 @@ int * allocate_lattice(int rows, int columns, char initialize);
 void populate_lattice(double probability, int * lattice, int rows, int columns,
                       unsigned int seed);
 
+/*! Populate lattice with given probability, comparing each random number
+    against an integer threshold.
+
+    The lattice is drawn from the same random numbers as populate_lattice,
+    one per site, but the comparison is done without converting them to
+    floating point and without branching. The threshold is rounded as
+    populate_lattice compares, so for a given seed both draw exactly the
+    same lattice.
+
+    @param probability the probability of each site to be occupied.
+    @param lattice a pointer to the lattice to be populated.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param seed the seed used to initialize the random number generator. If
+        seed = 0, the random number generator is not initialized.
+
+    @see populate_lattice
+*/
+void populate_lattice_threshold(double probability, int * lattice, int rows,
+                                int columns, unsigned int seed);
+
+/*! Populate lattice with given probability, using a given random number
+    generator instead of the global one.
+
+    Sites are drawn as in populate_lattice_threshold. Since the state of the
+    generator is not shared, several threads can populate lattices at the
+    same time, each one with its own generator.
+
+    @param probability the probability of each site to be occupied.
+    @param lattice a pointer to the lattice to be populated.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param rng pointer to the state of the random number generator.
+
+    @see populate_lattice_threshold
+*/
+void populate_lattice_r(double probability, int * lattice, int rows, int columns,
+                        pcg32_random_t * rng);
+
+/*! Populate lattice with given probability, drawing only the positions of
+    the minority sites.
+
+    The gaps between consecutive occupied sites (or empty ones, when the
+    probability is above 1/2) are geometrically distributed, so only one
+    random number is drawn per minority site. This is much faster than
+    populate_lattice far from probability 1/2, although the lattices drawn
+    for a given seed are different.
+
+    @param probability the probability of each site to be occupied.
+    @param lattice a pointer to the lattice to be populated.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param seed the seed used to initialize the random number generator. If
+        seed = 0, the random number generator is not initialized.
+
+    @see populate_lattice
+*/
+void populate_lattice_sparse(double probability, int * lattice, int rows,
+                             int columns, unsigned int seed);
+
+/*! Populate a lattice with an occupation probability that varies linearly
+    along the columns (gradient percolation).
+
+    The sites in column j are occupied with probability
+    \f$p_j = p_\mathrm{start} + (p_\mathrm{end} - p_\mathrm{start})\,j/(\mathrm{columns}-1)\f$,
+    so the first column is occupied with start_probability and the last one
+    with end_probability.
+
+    @param start_probability the occupation probability of the first column.
+    @param end_probability the occupation probability of the last column.
+    @param lattice a pointer to the lattice to be populated.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice (at least 2).
+    @param seed the seed used to initialize the random number generator. If
+        seed = 0, the random number generator is not initialized.
+
+    @see gradient_percolation_front for a function that finds the front of
+        the cluster connected to the first column.
+*/
+void populate_lattice_gradient(double start_probability, double end_probability,
+                               int * lattice, int rows, int columns,
+                               unsigned int seed);
+
 #endif /* LATTICE_H */
@@ -2,9 +2,14 @@
 /* MIT License (see root directory) */
 /* see header file for detailed documentation of each function */
 
+#include "math_extra.h"
 #include <stdlib.h>
 #include <math.h>
 
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
 double * create_exponential_centered_grid(const double xmin, const double xmax,
                                           const double xcenter, const int npoints,
                                           const double decay, int round_digits)
@@ -42,3 +47,117 @@ double * create_exponential_centered_grid(const double xmin, const double xmax,
 
     return grid;
 }
+
+/* in place iterative radix-2 transform of n complex numbers separated by
+   stride complex numbers */
+static void fft_1d(double * data, int n, int stride, char inverse)
+{
+    int i;
+    int j;
+    int k;
+    int length;
+    double angle;
+    double w_real;
+    double w_imag;
+    double u_real;
+    double u_imag;
+    double t_real;
+    double t_imag;
+    double swap;
+    double * a;
+    double * b;
+
+    /* bit reversal permutation */
+    for (i = 1, j = 0; i < n; i++) {
+        k = n >> 1;
+        for (; j & k; k >>= 1) {
+            j ^= k;
+        }
+        j ^= k;
+        if (i < j) {
+            a = data + 2*i*stride;
+            b = data + 2*j*stride;
+            swap = a[0];
+            a[0] = b[0];
+            b[0] = swap;
+            swap = a[1];
+            a[1] = b[1];
+            b[1] = swap;
+        }
+    }
+
+    /* butterflies */
+    for (length = 2; length <= n; length <<= 1) {
+        angle = (inverse ? 2 : -2)*M_PI/length;
+        for (k = 0; k < length/2; k++) {
+            w_real = cos(angle*k);
+            w_imag = sin(angle*k);
+            for (i = k; i < n; i += length) {
+                a = data + 2*i*stride;
+                b = data + 2*(i + length/2)*stride;
+                t_real = b[0]*w_real - b[1]*w_imag;
+                t_imag = b[0]*w_imag + b[1]*w_real;
+                u_real = a[0];
+                u_imag = a[1];
+                a[0] = u_real + t_real;
+                a[1] = u_imag + t_imag;
+                b[0] = u_real - t_real;
+                b[1] = u_imag - t_imag;
+            }
+        }
+    }
+}
+
+void fft_2d(double * data, int rows, int columns, char inverse)
+{
+    int i;
+    double normalization;
+
+    for (i = 0; i < rows; i++) {
+        fft_1d(data + 2*i*columns, columns, 1, inverse);
+    }
+    for (i = 0; i < columns; i++) {
+        fft_1d(data + 2*i, rows, columns, inverse);
+    }
+
+    if (inverse) {
+        normalization = 1.0/(rows*columns);
+        for (i = 0; i < 2*rows*columns; i++) {
+            data[i] *= normalization;
+        }
+    }
+}
+
+void running_moments_add(running_moments * moments, double value)
+{
+    double delta;
+
+    moments->count += 1;
+    delta = value - moments->mean;
+    moments->mean += delta/moments->count;
+    moments->sum_squares += delta*(value - moments->mean);
+}
+
+void running_moments_merge(running_moments * moments, const running_moments * other)
+{
+    int count;
+    double delta;
+
+    if (other->count == 0) {
+        return;
+    }
+    count = moments->count + other->count;
+    delta = other->mean - moments->mean;
+    moments->mean += delta*other->count/count;
+    moments->sum_squares += other->sum_squares +
+                            delta*delta*((double)moments->count)*other->count/count;
+    moments->count = count;
+}
+
+double running_moments_variance(const running_moments * moments)
+{
+    if (moments->count < 2) {
+        return 0;
+    }
+    return moments->sum_squares/(moments->count - 1);
+}
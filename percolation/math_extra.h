@@ -46,4 +46,53 @@ double * create_exponential_centered_grid(const double xmin, const double xmax,
                                           const double xcenter, const int npoints,
                                           const double decay, int round_digits);
 
+/*! Compute in place the discrete Fourier transform of a two dimensional
+    complex array.
+
+    @param data array of rows*columns complex numbers in row-major order,
+        each stored as its real part followed by its imaginary part.
+    @param rows the number of rows; it must be a power of two.
+    @param columns the number of columns; it must be a power of two.
+    @param inverse boolean indicating whether to compute the inverse
+        transform (which includes the 1/(rows*columns) normalization).
+*/
+void fft_2d(double * data, int rows, int columns, char inverse);
+
+/*! Running mean and variance of a stream of values. */
+typedef struct {
+    int count; /*!< number of values added */
+    double mean; /*!< mean of the values added */
+    double sum_squares; /*!< sum of squared deviations from the mean */
+} running_moments;
+
+/*! Add a value to running moments.
+
+    The moments are updated with Welford's algorithm, which is numerically
+    stable and needs no storage of the values.
+
+    @param moments pointer to the moments to be updated; they must start
+        zeroed.
+    @param value the value to add.
+*/
+void running_moments_add(running_moments * moments, double value);
+
+/*! Add the values accumulated in other running moments.
+
+    The moments are combined with the pairwise update of Chan et al., so the
+    result is the same (up to rounding) as adding all the values to a single
+    accumulator.
+
+    @param moments pointer to the moments to be updated.
+    @param other pointer to the moments to be added.
+*/
+void running_moments_merge(running_moments * moments, const running_moments * other);
+
+/*! Get the sample variance of running moments.
+
+    @param moments pointer to the moments.
+    @return The unbiased sample variance, or 0 if there are less than two
+        values.
+*/
+double running_moments_variance(const running_moments * moments);
+
 #endif /* MATH_EXTRA_H */
@@ -0,0 +1,188 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+
+/* headers */
+#include <stdlib.h>
+#include <time.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "random.h"
+#include "math_extra.h"
+#include "lattice.h"
+#include "io_helpers.h"
+#include "sweep.h"
+#include "cli.h"
+
+/* compare integers (for sorting) */
+int compare_ints(const void * a, const void * b);
+
+/* main body function */
+int main(int argc, char ** argv)
+{
+    int L; /* size of the largest square lattice */
+    int * lattice; /* lattice array */
+    unsigned int random_seed; /* random number generator seed */
+    int N; /* number of discrete probability value to tests */
+    double probability_center; /* value where to center the discrete probability values grid */
+    double decay; /* exponential decay coefficient of the probability grid */
+    int grid_rounding_digits; /* to how many digits should the probabilities in the grid be rounded to */
+    double * probability_grid; /* discrete grid of probability values to test */
+    int nrepetitions; /* the number of repetitions to take for each probability */
+    int * box_sizes; /* sizes of the concentric sub-boxes, in increasing order */
+    int box_count; /* number of sub-boxes */
+    int ** boxes; /* labeled sub-boxes of the current realization */
+    sweep_point * points; /* accumulated statistics for each probability and box size (box index varies fastest) */
+    sweep_point * box_points; /* points of a single box size */
+    int * percolation_counts;
+    int * nrepetitions_final;
+    char * box_size_token;
+    const char * format_option;
+    const char * bins_option;
+    int bins_per_decade; /* logarithmic bins per decade of the cluster sizes (0 if exact) */
+    int exact_sizes; /* largest cluster size that is not binned */
+    int output_interval;
+    int i;
+    int k;
+
+    /* read optional arguments */
+    if ((format_option = extract_option(&argc, argv, "format")) &&
+        !set_output_format(format_option)) {
+        printf("--format must be either csv or binary\n");
+        return 1;
+    }
+    if (extract_flag(&argc, argv, "huge-pages") && !set_lattice_huge_pages(1)) {
+        printf("huge pages are not available, using regular pages\n");
+    }
+    bins_per_decade = 0;
+    exact_sizes = 10;
+    if ((bins_option = extract_option(&argc, argv, "log-bins"))) {
+        bins_per_decade = atoi(bins_option);
+    }
+    if ((bins_option = extract_option(&argc, argv, "exact-sizes"))) {
+        exact_sizes = atoi(bins_option);
+    }
+    if (bins_per_decade > 0) {
+        exact_sizes = sweep_set_log_bins(bins_per_decade, exact_sizes);
+        set_cluster_size_binning(bins_per_decade, exact_sizes);
+    }
+
+    /* read input arguments */
+    if (argc < 8) {
+        printf("usage: L ngrid pcenter decay rounding nrepetitions sizes (seed)"
+               " [--format=csv|binary] [--huge-pages] [--log-bins=B] [--exact-sizes=S]\n");
+        printf("       sizes is a comma separated list of box sizes (e.g. 4,8,16)\n");
+        return 1;
+    }
+    L = atoi(argv[1]);
+    N = atoi(argv[2]);
+    probability_center = atof(argv[3]);
+    decay = atof(argv[4]);
+    grid_rounding_digits = atoi(argv[5]);
+    nrepetitions = atoi(argv[6]);
+    box_count = 1;
+    for (i = 0; argv[7][i]; i++) {
+        box_count += argv[7][i] == ',';
+    }
+    box_sizes = (int *)malloc(box_count*sizeof(int));
+    box_count = 0;
+    for (box_size_token = strtok(argv[7], ","); box_size_token;
+         box_size_token = strtok(NULL, ",")) {
+        box_sizes[box_count] = atoi(box_size_token);
+        if (box_sizes[box_count] < 1 || box_sizes[box_count] > L) {
+            printf("box sizes must be between 1 and L\n");
+            return 1;
+        }
+        box_count++;
+    }
+    qsort(box_sizes, box_count, sizeof(int), compare_ints);
+    if (argc == 9) {
+        random_seed = atoi(argv[8]);
+    } else {
+        random_seed = (unsigned int)time(NULL);
+    }
+
+    /* initialize remaining variables */
+    probability_grid = create_exponential_centered_grid(0, 1, probability_center, N, decay, grid_rounding_digits);
+    percolation_counts = (int *)malloc(N*sizeof(int));
+    nrepetitions_final = (int *)malloc(N*sizeof(int));
+    points = (sweep_point *)malloc(N*box_count*sizeof(sweep_point));
+    boxes = (int **)malloc(box_count*sizeof(int *));
+    for (k = 0; k < box_count; k++) {
+        boxes[k] = allocate_lattice(box_sizes[k], box_sizes[k], 0);
+        for (i = 0; i < N; i++) {
+            sweep_point_init(&points[i*box_count + k], probability_grid[i]);
+        }
+    }
+
+    output_interval = N / 10;
+
+    srand_pcg(random_seed);
+
+    /* allocate lattice */
+    lattice = allocate_lattice(L, L, 0);
+
+    /* calculate cluster statistics per probability for all box sizes at once */
+    for (i = 0; i < N; i++) {
+        sweep_points_sample_nested(&points[i*box_count], lattice, L, box_sizes,
+                                   box_count, boxes, nrepetitions);
+
+        for (k = 0; k < box_count; k++) {
+            write_probability_sweep_cluster_statistics_to_file("print/data",
+                                                                points[i*box_count + k].cluster_sizes,
+                                                                points[i*box_count + k].cluster_sizes_counts,
+                                                                points[i*box_count + k].cluster_sizes_percolated,
+                                                                points[i*box_count + k].cluster_sizes_total_count,
+                                                                box_sizes[k], box_sizes[k],
+                                                                probability_grid[i],
+                                                                random_seed,
+                                                                points[i*box_count + k].realizations, N,
+                                                                probability_center,
+                                                                decay);
+            sweep_point_clear(&points[i*box_count + k]);
+        }
+
+        /* print progress to stdout */
+        if (output_interval > 0 && (i+1) % output_interval == 0) {
+            printf("finished with p_%d out of %d\n", i+1, N);
+        }
+    }
+
+    /* write the percolation probability and observables of each box size */
+    box_points = (sweep_point *)malloc(N*sizeof(sweep_point));
+    for (k = 0; k < box_count; k++) {
+        for (i = 0; i < N; i++) {
+            box_points[i] = points[i*box_count + k];
+            percolation_counts[i] = box_points[i].percolation_count;
+            nrepetitions_final[i] = box_points[i].realizations;
+        }
+        write_probability_sweep_percolation_probability("print/data", probability_grid,
+                                                        percolation_counts, N,
+                                                        probability_center, decay,
+                                                        nrepetitions_final,
+                                                        box_sizes[k], box_sizes[k],
+                                                        random_seed);
+        sweep_points_write_observables("print/data", box_points, N, probability_center,
+                                       decay, box_sizes[k], box_sizes[k], random_seed);
+    }
+    free(box_points);
+
+    /* free memory before leaving */
+    for (k = 0; k < box_count; k++) {
+        free(boxes[k]);
+    }
+    free(points);
+    free(boxes);
+    free(box_sizes);
+    free(lattice);
+    free(probability_grid);
+    free(percolation_counts);
+    free(nrepetitions_final);
+
+    return 0;
+}
+
+int compare_ints(const void * a, const void * b)
+{
+    return *((const int *)a) - *((const int *)b);
+}
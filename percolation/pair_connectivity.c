@@ -0,0 +1,90 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+
+/* headers */
+#include <stdlib.h>
+#include <time.h>
+#include <stdio.h>
+
+#include "random.h"
+#include "lattice.h"
+#include "clusters.h"
+#include "connectivity.h"
+#include "io_helpers.h"
+#include "cli.h"
+
+/* main body function */
+int main(int argc, char ** argv)
+{
+    int L; /* square lattice size */
+    int * lattice; /* lattice array */
+    unsigned int random_seed; /* random number generator seed */
+    int N; /* number of repetitions */
+    double probability; /* occupation probability */
+    double * connected_pairs; /* connected pairs per displacement, summed over realizations */
+    double * radial_connected_pairs;
+    double * radial_site_pairs;
+    int radius_count;
+    int output_interval;
+    const char * format_option;
+    int n;
+
+    /* read optional arguments */
+    if ((format_option = extract_option(&argc, argv, "format")) &&
+        !set_output_format(format_option)) {
+        printf("--format must be either csv or binary\n");
+        return 1;
+    }
+    if (extract_flag(&argc, argv, "huge-pages") && !set_lattice_huge_pages(1)) {
+        printf("huge pages are not available, using regular pages\n");
+    }
+
+    /* read input arguments */
+    if (argc < 4) {
+        printf("usage: L nrepetitions probability (seed) [--format=csv|binary] [--huge-pages]\n");
+        return 1;
+    }
+    L = atoi(argv[1]);
+    N = atoi(argv[2]);
+    probability = atof(argv[3]);
+    if (argc == 5) {
+        random_seed = atoi(argv[4]);
+    } else {
+        random_seed = (unsigned int)time(NULL);
+    }
+
+    /* initialize remaining variables */
+    output_interval = N / 10;
+    connected_pairs = (double *)calloc((2*L - 1)*(2*L - 1), sizeof(double));
+
+    srand_pcg(random_seed);
+
+    /* allocate lattice */
+    lattice = allocate_lattice(L, L, 0);
+
+    /* accumulate connected pairs over realizations */
+    for (n = 0; n < N; n++) {
+        populate_lattice(probability, lattice, L, L, 0);
+        label_clusters(lattice, L, L);
+        accumulate_pair_connectivity(lattice, L, L, connected_pairs);
+
+        /* print progress to stdout */
+        if (output_interval > 0 && (n+1) % output_interval == 0) {
+            printf("finished with round %d out of %d\n", n+1, N);
+        }
+    }
+
+    radius_count = radial_pair_connectivity(connected_pairs, L, L,
+                                            &radial_connected_pairs,
+                                            &radial_site_pairs);
+    write_pair_connectivity_results("print/data", radial_connected_pairs,
+                                    radial_site_pairs, radius_count, probability,
+                                    N, L, L, random_seed);
+
+    free(lattice);
+    free(connected_pairs);
+    free(radial_connected_pairs);
+    free(radial_site_pairs);
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+/* see header file for detailed documentation of each function */
+
+#include "percolation_api.h"
+#include <stdlib.h>
+#include "random.h"
+#include "lattice.h"
+#include "clusters.h"
+
+int percolation_api_version(void)
+{
+    return PERCOLATION_API_VERSION;
+}
+
+void percolation_seed(uint64_t seed, uint64_t stream)
+{
+    srand_pcg_stream(seed, stream);
+}
+
+void percolation_populate(int32_t * lattices, int count, int rows, int columns,
+                          double probability)
+{
+    int k;
+
+    for (k = 0; k < count; k++) {
+        populate_lattice(probability, lattices + ((long)k)*rows*columns, rows,
+                         columns, 0);
+    }
+}
+
+void percolation_label(int32_t * lattices, int count, int rows, int columns)
+{
+    int k;
+
+    for (k = 0; k < count; k++) {
+        label_clusters(lattices + ((long)k)*rows*columns, rows, columns);
+    }
+}
+
+int percolation_percolates(const int32_t * lattices, int count, int rows,
+                           int columns, int8_t * percolated)
+{
+    int k;
+    int percolation_count;
+
+    percolation_count = 0;
+    for (k = 0; k < count; k++) {
+        percolated[k] = has_percolating_cluster(lattices + ((long)k)*rows*columns,
+                                                rows, columns);
+        percolation_count += percolated[k];
+    }
+
+    return percolation_count;
+}
+
+int percolation_cluster_statistics(const int32_t * lattices, int count, int rows,
+                                   int columns, int32_t * cluster_sizes,
+                                   int32_t * cluster_sizes_counts,
+                                   int32_t * cluster_sizes_percolated)
+{
+    int i;
+    int k;
+    int lattice_size;
+    int sizes_count;
+    int lattice_sizes_count;
+    int * lattice_sizes;
+    int * lattice_sizes_counts;
+    int * lattice_sizes_percolated;
+
+    /* accumulate by size in the output buffers, then compact them */
+    lattice_size = rows*columns;
+    for (i = 0; i < lattice_size; i++) {
+        cluster_sizes_counts[i] = 0;
+        cluster_sizes_percolated[i] = 0;
+    }
+    for (k = 0; k < count; k++) {
+        cluster_statistics(lattices + ((long)k)*lattice_size, rows, columns,
+                           &lattice_sizes_count, &lattice_sizes,
+                           &lattice_sizes_counts, &lattice_sizes_percolated,
+                           NULL, NULL);
+        for (i = 0; i < lattice_sizes_count; i++) {
+            cluster_sizes_counts[lattice_sizes[i] - 1] += lattice_sizes_counts[i];
+            cluster_sizes_percolated[lattice_sizes[i] - 1] += lattice_sizes_percolated[i];
+        }
+        free(lattice_sizes);
+        free(lattice_sizes_counts);
+        free(lattice_sizes_percolated);
+    }
+
+    sizes_count = 0;
+    for (i = 0; i < lattice_size; i++) {
+        if (cluster_sizes_counts[i] == 0) {
+            continue;
+        }
+        cluster_sizes[sizes_count] = i + 1;
+        cluster_sizes_counts[sizes_count] = cluster_sizes_counts[i];
+        cluster_sizes_percolated[sizes_count] = cluster_sizes_percolated[i];
+        sizes_count++;
+    }
+
+    return sizes_count;
+}
@@ -0,0 +1,92 @@
+/*!
+    @file percolation_api.h
+    @brief This file contains the stable C interface exported by
+    libpercolation.so, so that the kernels can be called from other languages
+    (e.g. from Python through analysis/libpercolation.py).
+
+    All functions work on batches of lattices stored contiguously in
+    caller-owned buffers (lattice k starts at lattices + k*rows*columns) and
+    never allocate memory that the caller has to free. Lattices are populated
+    with the global random number generator, seeded with percolation_seed.
+
+    @author Federico Cerisola
+    @copyright MIT License.
+*/
+
+#ifndef PERCOLATION_API_H
+#define PERCOLATION_API_H
+
+#include <stdint.h>
+
+/*! Version of the interface; it changes whenever a signature changes. */
+#define PERCOLATION_API_VERSION 1
+
+/*! Get the version of the interface the library was built with.
+
+    @return The value of PERCOLATION_API_VERSION.
+*/
+int percolation_api_version(void);
+
+/*! Seed the global random number generator.
+
+    @param seed the seed.
+    @param stream the stream of the generator (0 for the one used by the
+        drivers).
+*/
+void percolation_seed(uint64_t seed, uint64_t stream);
+
+/*! Populate a batch of lattices.
+
+    @param lattices pointer to the lattices to be populated.
+    @param count the number of lattices.
+    @param rows the number of rows in each lattice.
+    @param columns the number of columns in each lattice.
+    @param probability the probability of each site to be occupied.
+*/
+void percolation_populate(int32_t * lattices, int count, int rows, int columns,
+                          double probability);
+
+/*! Label the clusters of a batch of lattices.
+
+    @param lattices pointer to the lattices to be labeled.
+    @param count the number of lattices.
+    @param rows the number of rows in each lattice.
+    @param columns the number of columns in each lattice.
+
+    @see label_clusters
+*/
+void percolation_label(int32_t * lattices, int count, int rows, int columns);
+
+/*! Determine which lattices of a batch have a percolating cluster.
+
+    @param lattices pointer to the lattices, with all clusters labeled.
+    @param count the number of lattices.
+    @param rows the number of rows in each lattice.
+    @param columns the number of columns in each lattice.
+    @param percolated array of count elements where to store whether each
+        lattice percolates.
+    @return The number of lattices with a percolating cluster.
+*/
+int percolation_percolates(const int32_t * lattices, int count, int rows,
+                           int columns, int8_t * percolated);
+
+/*! Aggregate the cluster statistics of a batch of lattices.
+
+    @param lattices pointer to the lattices, with all clusters labeled.
+    @param count the number of lattices.
+    @param rows the number of rows in each lattice.
+    @param columns the number of columns in each lattice.
+    @param cluster_sizes array of rows*columns elements where to store the
+        different cluster sizes found, in increasing order.
+    @param cluster_sizes_counts array of rows*columns elements where to store
+        the total count of clusters of each size.
+    @param cluster_sizes_percolated array of rows*columns elements where to
+        store the total count of percolating clusters of each size.
+    @return The number of different cluster sizes stored.
+*/
+int percolation_cluster_statistics(const int32_t * lattices, int count, int rows,
+                                   int columns, int32_t * cluster_sizes,
+                                   int32_t * cluster_sizes_counts,
+                                   int32_t * cluster_sizes_percolated);
+
+#endif /* PERCOLATION_API_H */
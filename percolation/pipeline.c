@@ -0,0 +1,348 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+/* see header file for detailed documentation of each function */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "pipeline.h"
+#include <stdlib.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sched.h>
+#include "random.h"
+#include "lattice.h"
+#include "dispatch.h"
+
+#ifndef __GNUC__
+#error "the pipeline queues need the __atomic builtins of GCC compatible compilers"
+#endif
+
+/* keeps the positions of the queues in different cache lines */
+#define CACHE_LINE 64
+
+/* bounded multi-producer multi-consumer queue of buffer indices; each slot
+   has a sequence number telling whether it is ready to be written (equal to
+   the position) or read (one past it), so pushing and popping only need one
+   compare-and-swap on the position */
+typedef struct {
+    size_t * sequences;
+    int * slots;
+    size_t mask; /* capacity - 1, with a power of two capacity */
+    char pad0[CACHE_LINE];
+    size_t push_position;
+    char pad1[CACHE_LINE];
+    size_t pop_position;
+    char pad2[CACHE_LINE];
+} buffer_queue;
+
+/* what a thread of the pipeline needs */
+typedef struct {
+    sweep_pipeline * pipeline;
+    int index; /* producers first, then consumers */
+} pipeline_thread;
+
+struct sweep_pipeline {
+    int rows;
+    int columns;
+    int producers;
+    int consumers;
+    int buffers;
+    int * lattices; /* pool of buffers, one after the other */
+    long stride; /* distance between buffers, keeping each one aligned */
+    buffer_queue free_buffers; /* buffers ready to be populated */
+    buffer_queue populated_buffers; /* buffers ready to be analyzed */
+    pthread_t * threads;
+    pipeline_thread * thread_arguments;
+    pcg32_random_t * generators; /* one per producer */
+    sweep_point * partial_points; /* results accumulated by each consumer */
+    pthread_mutex_t lock; /* protects the job and finished counters */
+    pthread_cond_t job_started; /* signaled when a job starts or on closing */
+    pthread_cond_t job_finished; /* signaled when all threads finished a job */
+    long job; /* number of jobs started */
+    int finished; /* threads that finished the current job */
+    char closing; /* whether the threads must exit */
+    double probability; /* probability of the current job */
+    int nrealizations; /* realizations of the current job */
+    int claimed; /* realizations already claimed by consumers (atomic) */
+};
+
+static void buffer_queue_init(buffer_queue * queue, int capacity)
+{
+    size_t size;
+    size_t i;
+
+    size = 1;
+    while (size < (size_t)capacity) {
+        size <<= 1;
+    }
+    queue->sequences = (size_t *)malloc(size*sizeof(size_t));
+    queue->slots = (int *)malloc(size*sizeof(int));
+    queue->mask = size - 1;
+    for (i = 0; i < size; i++) {
+        queue->sequences[i] = i;
+    }
+    queue->push_position = 0;
+    queue->pop_position = 0;
+}
+
+static void buffer_queue_free(buffer_queue * queue)
+{
+    free(queue->sequences);
+    free(queue->slots);
+}
+
+/* the queues are as large as the pool of buffers, so pushing never fails */
+static void buffer_queue_push(buffer_queue * queue, int buffer)
+{
+    size_t position;
+    size_t sequence;
+
+    position = __atomic_load_n(&queue->push_position, __ATOMIC_RELAXED);
+    for (;;) {
+        sequence = __atomic_load_n(&queue->sequences[position & queue->mask], __ATOMIC_ACQUIRE);
+        if (sequence == position &&
+            __atomic_compare_exchange_n(&queue->push_position, &position, position + 1, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+        if (sequence != position) {
+            position = __atomic_load_n(&queue->push_position, __ATOMIC_RELAXED);
+        }
+    }
+    queue->slots[position & queue->mask] = buffer;
+    __atomic_store_n(&queue->sequences[position & queue->mask], position + 1, __ATOMIC_RELEASE);
+}
+
+/* pop a buffer, yielding the processor while the queue is empty */
+static int buffer_queue_pop(buffer_queue * queue)
+{
+    size_t position;
+    size_t sequence;
+    int buffer;
+
+    position = __atomic_load_n(&queue->pop_position, __ATOMIC_RELAXED);
+    for (;;) {
+        sequence = __atomic_load_n(&queue->sequences[position & queue->mask], __ATOMIC_ACQUIRE);
+        if (sequence == position + 1) {
+            if (__atomic_compare_exchange_n(&queue->pop_position, &position, position + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (sequence == position) {
+            /* empty */
+            sched_yield();
+            position = __atomic_load_n(&queue->pop_position, __ATOMIC_RELAXED);
+        } else {
+            position = __atomic_load_n(&queue->pop_position, __ATOMIC_RELAXED);
+        }
+    }
+    buffer = queue->slots[position & queue->mask];
+    __atomic_store_n(&queue->sequences[position & queue->mask],
+                     position + queue->mask + 1, __ATOMIC_RELEASE);
+
+    return buffer;
+}
+
+/* populate the realizations assigned to a producer: every producers-th one */
+static void produce(sweep_pipeline * pipeline, int producer)
+{
+    int n;
+    int buffer;
+
+    for (n = producer; n < pipeline->nrealizations; n += pipeline->producers) {
+        buffer = buffer_queue_pop(&pipeline->free_buffers);
+        populate_lattice_r(pipeline->probability, pipeline->lattices + buffer*pipeline->stride,
+                           pipeline->rows, pipeline->columns,
+                           &pipeline->generators[producer]);
+        buffer_queue_push(&pipeline->populated_buffers, buffer);
+    }
+}
+
+/* analyze populated lattices until every realization has been claimed */
+static void consume(sweep_pipeline * pipeline, int consumer)
+{
+    int buffer;
+    int * lattice;
+
+    while (__atomic_fetch_add(&pipeline->claimed, 1, __ATOMIC_RELAXED) <
+           pipeline->nrealizations) {
+        buffer = buffer_queue_pop(&pipeline->populated_buffers);
+        lattice = pipeline->lattices + buffer*pipeline->stride;
+        dispatch_label(lattice, pipeline->rows, pipeline->columns);
+        sweep_point_accumulate(&pipeline->partial_points[consumer], lattice,
+                               pipeline->rows, pipeline->columns);
+        buffer_queue_push(&pipeline->free_buffers, buffer);
+    }
+}
+
+static void * pipeline_worker(void * arg)
+{
+    pipeline_thread * thread;
+    sweep_pipeline * pipeline;
+    long job;
+    char closing;
+    int k;
+
+    thread = (pipeline_thread *)arg;
+    pipeline = thread->pipeline;
+    job = 0;
+
+    /* producers write the buffers first, so they place them in the memory
+       of their own NUMA node */
+    if (thread->index < pipeline->producers) {
+        for (k = thread->index; k < pipeline->buffers; k += pipeline->producers) {
+            initialize_lattice(pipeline->lattices + k*pipeline->stride,
+                               pipeline->rows, pipeline->columns);
+        }
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->finished++;
+        if (pipeline->finished == pipeline->producers) {
+            pthread_cond_signal(&pipeline->job_finished);
+        }
+        pthread_mutex_unlock(&pipeline->lock);
+    }
+    for (;;) {
+        pthread_mutex_lock(&pipeline->lock);
+        while (pipeline->job == job && !pipeline->closing) {
+            pthread_cond_wait(&pipeline->job_started, &pipeline->lock);
+        }
+        job = pipeline->job;
+        closing = pipeline->closing;
+        pthread_mutex_unlock(&pipeline->lock);
+        if (closing) {
+            break;
+        }
+
+        if (thread->index < pipeline->producers) {
+            produce(pipeline, thread->index);
+        } else {
+            consume(pipeline, thread->index - pipeline->producers);
+        }
+
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->finished++;
+        if (pipeline->finished == pipeline->producers + pipeline->consumers) {
+            pthread_cond_signal(&pipeline->job_finished);
+        }
+        pthread_mutex_unlock(&pipeline->lock);
+    }
+
+    return NULL;
+}
+
+sweep_pipeline * create_sweep_pipeline(int rows, int columns, int producers,
+                                       int consumers, int buffers)
+{
+    sweep_pipeline * pipeline;
+    int threads;
+    int k;
+
+    if (producers < 1 || consumers < 1) {
+        return NULL;
+    }
+    threads = producers + consumers;
+    if (buffers <= 0) {
+        buffers = 2*threads;
+    }
+
+    pipeline = (sweep_pipeline *)malloc(sizeof(sweep_pipeline));
+    pipeline->rows = rows;
+    pipeline->columns = columns;
+    pipeline->producers = producers;
+    pipeline->consumers = consumers;
+    pipeline->buffers = buffers;
+    pipeline->stride = (((long)rows)*columns*sizeof(int) + LATTICE_ALIGNMENT - 1)/
+                       LATTICE_ALIGNMENT*LATTICE_ALIGNMENT/sizeof(int);
+    pipeline->lattices = (int *)allocate_aligned(((size_t)buffers)*pipeline->stride*sizeof(int));
+    if (!pipeline->lattices) {
+        free(pipeline);
+        return NULL;
+    }
+    buffer_queue_init(&pipeline->free_buffers, buffers);
+    buffer_queue_init(&pipeline->populated_buffers, buffers);
+    for (k = 0; k < buffers; k++) {
+        buffer_queue_push(&pipeline->free_buffers, k);
+    }
+    pipeline->generators = (pcg32_random_t *)malloc(producers*sizeof(pcg32_random_t));
+    pipeline->partial_points = (sweep_point *)malloc(consumers*sizeof(sweep_point));
+    pipeline->job = 0;
+    pipeline->finished = 0;
+    pipeline->closing = 0;
+    pthread_mutex_init(&pipeline->lock, NULL);
+    pthread_cond_init(&pipeline->job_started, NULL);
+    pthread_cond_init(&pipeline->job_finished, NULL);
+
+    pipeline->threads = (pthread_t *)malloc(threads*sizeof(pthread_t));
+    pipeline->thread_arguments = (pipeline_thread *)malloc(threads*sizeof(pipeline_thread));
+    for (k = 0; k < threads; k++) {
+        pipeline->thread_arguments[k].pipeline = pipeline;
+        pipeline->thread_arguments[k].index = k;
+        pthread_create(&pipeline->threads[k], NULL, pipeline_worker,
+                       &pipeline->thread_arguments[k]);
+    }
+
+    /* wait until the producers have touched the buffers */
+    pthread_mutex_lock(&pipeline->lock);
+    while (pipeline->finished < producers) {
+        pthread_cond_wait(&pipeline->job_finished, &pipeline->lock);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+
+    return pipeline;
+}
+
+void sweep_pipeline_sample(sweep_pipeline * pipeline, sweep_point * point,
+                           int nrealizations)
+{
+    int k;
+
+    /* every call draws new streams from the global generator */
+    for (k = 0; k < pipeline->producers; k++) {
+        pcg32_srandom_r(&pipeline->generators[k], rand_pcg(), k + 1);
+    }
+    for (k = 0; k < pipeline->consumers; k++) {
+        sweep_point_init(&pipeline->partial_points[k], point->probability);
+    }
+
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->probability = point->probability;
+    pipeline->nrealizations = nrealizations;
+    pipeline->claimed = 0;
+    pipeline->finished = 0;
+    pipeline->job++;
+    pthread_cond_broadcast(&pipeline->job_started);
+    while (pipeline->finished < pipeline->producers + pipeline->consumers) {
+        pthread_cond_wait(&pipeline->job_finished, &pipeline->lock);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+
+    for (k = 0; k < pipeline->consumers; k++) {
+        sweep_point_merge(point, &pipeline->partial_points[k]);
+        sweep_point_clear(&pipeline->partial_points[k]);
+    }
+}
+
+void close_sweep_pipeline(sweep_pipeline * pipeline)
+{
+    int k;
+
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->closing = 1;
+    pthread_cond_broadcast(&pipeline->job_started);
+    pthread_mutex_unlock(&pipeline->lock);
+
+    for (k = 0; k < pipeline->producers + pipeline->consumers; k++) {
+        pthread_join(pipeline->threads[k], NULL);
+    }
+    pthread_mutex_destroy(&pipeline->lock);
+    pthread_cond_destroy(&pipeline->job_started);
+    pthread_cond_destroy(&pipeline->job_finished);
+    buffer_queue_free(&pipeline->free_buffers);
+    buffer_queue_free(&pipeline->populated_buffers);
+    free(pipeline->lattices);
+    free(pipeline->generators);
+    free(pipeline->partial_points);
+    free(pipeline->threads);
+    free(pipeline->thread_arguments);
+    free(pipeline);
+}
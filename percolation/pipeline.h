@@ -0,0 +1,72 @@
+/*!
+    @file pipeline.h
+    @brief This file contains a pipeline that samples the realizations of a
+    sweep point in several threads, overlapping the generation of lattices
+    with their analysis.
+
+    Producer threads populate lattices, each one with its own random number
+    generator, and hand them over to consumer threads that label them and
+    accumulate their statistics. The lattices travel through a fixed pool of
+    buffers, recycled through two bounded lock-free queues (one of free
+    buffers and one of populated ones), so no memory is allocated while
+    sampling; the buffers are aligned with allocate_aligned and first
+    written by the producers, so that they are placed in their NUMA nodes.
+    The number of producers and consumers can be chosen to balance
+    the stages: more producers when generating the lattices dominates (e.g.
+    with small lattices) and more consumers when labeling does.
+
+    The generators of the producers are seeded from the global random number
+    generator at every call, so a run is reproducible for a given seed and
+    number of producers (and can be checkpointed as usual). The realizations
+    are accumulated in a different order than when sampling sequentially, so
+    the results are statistically equivalent but not identical to those of a
+    sequential run.
+
+    @author Federico Cerisola
+    @copyright MIT License.
+*/
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "sweep.h"
+
+/*! Opaque handle to a pipeline with its threads and buffers. */
+typedef struct sweep_pipeline sweep_pipeline;
+
+/*! Start the threads of a pipeline.
+
+    @param rows the number of rows of the lattices.
+    @param columns the number of columns of the lattices.
+    @param producers the number of threads populating lattices.
+    @param consumers the number of threads labeling lattices and accumulating
+        their statistics.
+    @param buffers the number of lattices in the pool, or 0 for twice the
+        number of threads.
+    @return A pointer to the newly allocated pipeline, or NULL if it could not
+        be started.
+*/
+sweep_pipeline * create_sweep_pipeline(int rows, int columns, int producers,
+                                       int consumers, int buffers);
+
+/*! Sample new lattice realizations with the threads of a pipeline and
+    accumulate their statistics into a sweep point.
+
+    This blocks until all the realizations have been accumulated. The
+    lattices are populated with populate_lattice_r and labeled with
+    dispatch_label.
+
+    @param pipeline pointer to the pipeline.
+    @param point pointer to the sweep point where results are accumulated.
+    @param nrealizations how many realizations to sample.
+*/
+void sweep_pipeline_sample(sweep_pipeline * pipeline, sweep_point * point,
+                           int nrealizations);
+
+/*! Stop the threads of a pipeline and free it.
+
+    @param pipeline pointer to the pipeline.
+*/
+void close_sweep_pipeline(sweep_pipeline * pipeline);
+
+#endif /* PIPELINE_H */
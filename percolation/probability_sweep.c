@@ -1,6 +1,8 @@
 /* Copyright 2017 Federico Cerisola */
 /* MIT License (see root directory) */
 
+#define _POSIX_C_SOURCE 200809L
+
 /* headers */
 #include <stdlib.h>
 #include <time.h>
@@ -13,6 +15,15 @@
 #include "lattice.h"
 #include "clusters.h"
 #include "io_helpers.h"
+#include "sweep.h"
+#include "profiling.h"
+#include "checkpoint.h"
+#include "container.h"
+#include "status.h"
+#include "dispatch.h"
+#include "pipeline.h"
+#include "bonds.h"
+#include "cli.h"
 
 /* return std factor to reach desired confidence interval (specified as a string)
     for a normal distribution */
@@ -21,46 +32,218 @@ double Z_normal(const char * ci);
 /* calculate the amount of experiments needed to reach the desired error */
 unsigned int samples_for_target_ci(double p, double error, double Z);
 
+/* sample a grid point until reaching the target error or exceeding maxtime;
+   nrepetitions (0 for a new point) and elapsed keep the progress so that the
+   sampling can be interrupted at checkpoint_time (0 for never) and resumed
+   later; the progress is reported to status (NULL for none) as the point
+   index out of npoints; returns whether the point is finished */
+char sample_to_target_error(sweep_point * point, int * lattice, int L,
+                            int min_repetitions, double target_error, double Z,
+                            time_t maxtime, int * nrepetitions, double * elapsed,
+                            time_t checkpoint_time, run_status * status,
+                            int index, int npoints);
+
+/* append the midpoints of the grid intervals where the percolation
+   probability changes the most; returns how many points were added */
+int refine_grid(sweep_point ** points, int npoints, int max_points,
+                double resolution, double target_error, double Z,
+                int round_digits);
+
+/* compare sweep points by their probability (for sorting) */
+int compare_sweep_points(const void * a, const void * b);
+
+/* sample all grid points sharing a global budget of samples and/or time,
+   reporting the progress to status (NULL for none) */
+void budget_sweep(sweep_point * points, int npoints, int * lattice, int L,
+                  int min_repetitions, double target_error, double Z,
+                  long budget_samples, double budget_time, run_status * status);
+
 /* main body function */
 int main(int argc, char ** argv)
 {
     int L; /* square lattice size */
     int * lattice; /* lattice array */
     unsigned int random_seed; /* random number generator seed */
-    int cluster_sizes_total_count; /* total number of different cluster sizes, for a given probability */
-    int * cluster_sizes; /* sizes of clusters, for a given probability */
-    int * cluster_sizes_counts; /* count of clusters of a given size (paied in cluster_sizes), for a given probability */
-    int * cluster_sizes_percolated; /* how many percolating clusters of each size there are, for a given probability */
-    int cluster_sizes_total_count_aggregated; /* total number of different cluster sizes, aggregated over the sweep */
-    int * cluster_sizes_aggregated; /* sizes of clusters, aggregated over the sweep */
-    int * cluster_sizes_counts_aggregated; /* count of clusters of a given size (paied in cluster_sizes), aggregated over the sweep */
-    int * cluster_sizes_percolated_aggregated; /* how many percolating clusters of each size there are, aggregated over the sweep */
+    sweep_point * points; /* accumulated statistics for each probability of the grid */
     int N; /* number of discrete probability value to tests */
     double probability_center; /* value where to center the discrete probability values grid */
     double decay; /* exponential decay coefficient of the probability grid */
     int grid_rounding_digits; /* to how many digits should the probabilities in the grid be rounded to */
     double * probability_grid; /* discrete grid of probability values to test */
     int min_repetitions; /* minimum number repetitions to take for each probability */
-    int nrepetitions; /* the number of repetitions to take for each probability */
     double target_error; /* the target error in each probability estimation */
     char * ci; /* confidence interval */
     double Z; /* ci costant factor */
     time_t maxtime; /* maximum time to spend on a particular probability */
     int * percolation_counts; /* how many times a given population probability generates a percolating cluster */
     int * nrepetitions_final; /* the final amount of repetitions for each probability */
+    const char * budget_option;
+    long budget_samples; /* total number of samples to spend on the whole sweep (0 for no limit) */
+    double budget_time; /* total time in seconds to spend on the whole sweep (0 for no limit) */
+    char budget_mode; /* whether to share a global budget among all the grid points */
+    const char * adaptive_option;
+    double adaptive_resolution; /* smallest grid spacing allowed when refining (0 for no refinement) */
+    int adaptive_max_points; /* maximum number of grid points after refinement */
+    int grid_npoints; /* number of points in the initial grid */
+    int new_points; /* number of points added in a refinement round */
+    const char * checkpoint_path; /* where to periodically save the progress (NULL for none) */
+    const char * checkpoint_option;
+    time_t checkpoint_interval; /* seconds between checkpoints */
+    time_t checkpoint_time; /* when to save the next checkpoint */
+    char resume; /* whether to resume from the checkpoint */
+    int nrepetitions; /* target repetitions of the point being sampled (0 if not started) */
+    double elapsed; /* time spent sampling the current point */
+    const char * shard_option;
+    const char * format_option;
+    const char * bins_option;
+    int bins_per_decade; /* logarithmic bins per decade of the cluster sizes (0 if exact) */
+    int exact_sizes; /* largest cluster size that is not binned */
+    int shard_index; /* index of this process when the sweep is split in shards */
+    int shard_count; /* number of processes the sweep is split in */
+    char * output_path; /* folder where the results are written */
+    sweep_container * container; /* single file for all cluster statistics (NULL for one file per point) */
+    char use_container; /* whether to write the cluster statistics to a container */
+    const char * corpus_path; /* file where every realization is stored (NULL if none) */
+    lattice_corpus * corpus;
+    char corpus_labels; /* whether to also store the labels in the corpus */
+    char profile; /* whether to measure the time spent in each phase */
+    phase_profile run_profile; /* time spent in each phase by the whole sweep */
+    const char * status_path; /* file where the progress is reported (NULL for none) */
+    const char * status_option;
+    double status_interval; /* seconds between rewrites of the status file */
+    run_status * status;
+    const char * tuning_path; /* file with the cached kernel choices (NULL for none) */
+    char autotune; /* whether to time the kernels missing from the tuning file */
+    const char * pipeline_option;
+    int producers; /* threads populating lattices (0 to sample sequentially) */
+    int consumers; /* threads labeling lattices and accumulating their statistics */
+    int pipeline_buffers; /* lattices in the pool of the pipeline (0 for the default) */
+    sweep_pipeline * pipeline;
+    char bond_percolation; /* whether bonds are populated instead of sites */
+    bond_lattice * bonds;
     int output_interval;
-    int time_check_interval;
-    time_t start_time;
-    time_t current_time;
-    double probability_estimation;
-    int nrepetitions_estimation;
-    int n;
     int i;
-    int j;
+
+    /* read optional arguments */
+    budget_samples = 0;
+    budget_time = 0;
+    if ((budget_option = extract_option(&argc, argv, "budget-samples"))) {
+        budget_samples = atol(budget_option);
+    }
+    if ((budget_option = extract_option(&argc, argv, "budget-time"))) {
+        budget_time = atof(budget_option);
+    }
+    budget_mode = budget_samples > 0 || budget_time > 0;
+    adaptive_resolution = 0;
+    adaptive_max_points = 0;
+    if ((adaptive_option = extract_option(&argc, argv, "adaptive-resolution"))) {
+        adaptive_resolution = atof(adaptive_option);
+    }
+    if ((adaptive_option = extract_option(&argc, argv, "adaptive-max-points"))) {
+        adaptive_max_points = atoi(adaptive_option);
+    }
+    if (budget_mode && adaptive_resolution > 0) {
+        printf("budget and adaptive grid modes cannot be combined\n");
+        return 1;
+    }
+    checkpoint_path = extract_option(&argc, argv, "checkpoint");
+    checkpoint_interval = 600;
+    if ((checkpoint_option = extract_option(&argc, argv, "checkpoint-interval"))) {
+        checkpoint_interval = atol(checkpoint_option);
+    }
+    resume = extract_flag(&argc, argv, "resume");
+    if ((resume || checkpoint_path) && budget_mode) {
+        printf("checkpoints are not supported in budget mode\n");
+        return 1;
+    }
+    if (resume && !checkpoint_path) {
+        printf("--resume needs the --checkpoint file to resume from\n");
+        return 1;
+    }
+    shard_index = 0;
+    shard_count = 1;
+    if ((shard_option = extract_option(&argc, argv, "shard")) &&
+        (sscanf(shard_option, "%d/%d", &shard_index, &shard_count) != 2 ||
+         shard_index < 0 || shard_index >= shard_count)) {
+        printf("--shard must be given as INDEX/COUNT with 0 <= INDEX < COUNT\n");
+        return 1;
+    }
+    if (shard_count > 1 && adaptive_resolution > 0) {
+        printf("the adaptive grid mode cannot be split in shards\n");
+        return 1;
+    }
+    use_container = extract_flag(&argc, argv, "container");
+    corpus_path = extract_option(&argc, argv, "corpus");
+    corpus_labels = extract_flag(&argc, argv, "corpus-labels");
+    if (corpus_path && resume) {
+        printf("a corpus cannot be continued when resuming from a checkpoint\n");
+        return 1;
+    }
+    if ((format_option = extract_option(&argc, argv, "format")) &&
+        !set_output_format(format_option)) {
+        printf("--format must be either csv or binary\n");
+        return 1;
+    }
+    if (extract_flag(&argc, argv, "huge-pages") && !set_lattice_huge_pages(1)) {
+        printf("huge pages are not available, using regular pages\n");
+    }
+    profile = extract_flag(&argc, argv, "profile");
+    if (profile && !enable_profiling()) {
+        printf("hardware counters are not available, profiling wall time only\n");
+    }
+    producers = 0;
+    consumers = 0;
+    if ((pipeline_option = extract_option(&argc, argv, "pipeline")) &&
+        (sscanf(pipeline_option, "%d:%d", &producers, &consumers) != 2 ||
+         producers < 1 || consumers < 1)) {
+        printf("--pipeline must be given as PRODUCERS:CONSUMERS with at least one of each\n");
+        return 1;
+    }
+    pipeline_buffers = 0;
+    if ((pipeline_option = extract_option(&argc, argv, "pipeline-buffers"))) {
+        pipeline_buffers = atoi(pipeline_option);
+    }
+    tuning_path = extract_option(&argc, argv, "tuning");
+    autotune = extract_flag(&argc, argv, "autotune");
+    status_path = extract_option(&argc, argv, "status");
+    status_interval = 10;
+    if ((status_option = extract_option(&argc, argv, "status-interval"))) {
+        status_interval = atof(status_option);
+    }
+    if (producers > 0 && (profile || corpus_path)) {
+        printf("the pipeline cannot be combined with --profile or --corpus\n");
+        return 1;
+    }
+    bond_percolation = extract_flag(&argc, argv, "bonds");
+    if (bond_percolation && (producers > 0 || corpus_path || use_container)) {
+        printf("bond percolation cannot be combined with --pipeline, --corpus or --container\n");
+        return 1;
+    }
+    bins_per_decade = 0;
+    exact_sizes = 10;
+    if ((bins_option = extract_option(&argc, argv, "log-bins"))) {
+        bins_per_decade = atoi(bins_option);
+    }
+    if ((bins_option = extract_option(&argc, argv, "exact-sizes"))) {
+        exact_sizes = atoi(bins_option);
+    }
+    if (bins_per_decade > 0) {
+        exact_sizes = sweep_set_log_bins(bins_per_decade, exact_sizes);
+        set_cluster_size_binning(bins_per_decade, exact_sizes);
+    }
 
     /* read input arguments; if none provided fallback to default values */
     if (argc < 10) {
-        printf("usage: L ngrid pcenter decay rounding mintrials error ci maxtime (seed)\n");
+        printf("usage: L ngrid pcenter decay rounding mintrials error ci maxtime (seed)"
+               " [--budget-samples=N] [--budget-time=SECONDS]"
+               " [--adaptive-resolution=DP] [--adaptive-max-points=M]"
+               " [--checkpoint=FILE] [--checkpoint-interval=SECONDS] [--resume]"
+               " [--shard=INDEX/COUNT] [--format=csv|binary] [--huge-pages] [--container]"
+               " [--log-bins=B] [--exact-sizes=S]"
+               " [--corpus=FILE] [--corpus-labels]"
+               " [--status=FILE] [--status-interval=SECONDS]"
+               " [--autotune] [--tuning=FILE]"
+               " [--pipeline=PRODUCERS:CONSUMERS] [--pipeline-buffers=B] [--bonds]\n");
         return 1;
     }
     L = atoi(argv[1]);
@@ -74,121 +257,246 @@ int main(int argc, char ** argv)
     printf("ci = %s\n", ci);
     Z = Z_normal(ci);
     maxtime = atol(argv[9]);
+    grid_npoints = N;
+    if (adaptive_max_points <= 0) {
+        adaptive_max_points = 10*N;
+    }
     if (argc == 11) {
         random_seed = atoi(argv[10]);
     } else {
         random_seed = (unsigned int)time(NULL);
     }
 
-    /* initialize remaining variables */
-    cluster_sizes_total_count = 0;
-    cluster_sizes = NULL;
-    cluster_sizes_counts = NULL;
-    cluster_sizes_percolated = NULL;
-    cluster_sizes_total_count_aggregated = 0;
-    cluster_sizes_aggregated = NULL;
-    cluster_sizes_counts_aggregated = NULL;
-    cluster_sizes_percolated_aggregated = NULL;
+    /* each shard takes its share of the repetitions, so that once merged the
+       shards reach the same number of repetitions and target error */
+    output_path = (char *)"print/data";
+    if (shard_count > 1) {
+        min_repetitions = (min_repetitions + shard_count - 1)/shard_count;
+        target_error = target_error*sqrt(shard_count);
+        output_path = create_shard_output_path(output_path, shard_index);
+    }
+
+    /* the first round of the budget takes the minimum repetitions everywhere */
+    if (budget_samples > 0 && budget_samples < ((long)N)*min_repetitions) {
+        printf("--budget-samples must be at least ngrid*mintrials = %ld\n",
+               ((long)N)*min_repetitions);
+        return 1;
+    }
 
+    /* initialize remaining variables */
     probability_grid = create_exponential_centered_grid(0, 1, probability_center, N, decay, grid_rounding_digits);
     percolation_counts = (int *)malloc(N*sizeof(int));
     nrepetitions_final = (int *)malloc(N*sizeof(int));
+    points = (sweep_point *)malloc(N*sizeof(sweep_point));
     for (i = 0; i < N; i++) {
         percolation_counts[i] = 0;
         nrepetitions_final[i] = 0;
+        sweep_point_init(&points[i], probability_grid[i]);
     }
 
     output_interval = N / 10;
 
-    srand_pcg(random_seed);
+    srand_pcg_stream(random_seed, shard_index);
 
     /* allocate lattice */
     lattice = allocate_lattice(L, L, 0);
 
-    /* calculate cluster statistics per probability */
-    for (i = 0; i < N; i++) {
-        start_time = time(NULL);
-        nrepetitions = min_repetitions;
-        time_check_interval = nrepetitions / 100;
-        for (n = 0; n < nrepetitions; n++) {
-            populate_lattice(probability_grid[i], lattice, L, L, 0);
-            label_clusters(lattice, L, L);
-            cluster_statistics(lattice, L, L, &cluster_sizes_total_count, &cluster_sizes,
-                               &cluster_sizes_counts, &cluster_sizes_percolated,
-                               NULL, NULL);
-            aggregate_cluster_statistics(cluster_sizes_total_count, cluster_sizes,
-                                         cluster_sizes_counts, cluster_sizes_percolated,
-                                         &cluster_sizes_total_count_aggregated,
-                                         &cluster_sizes_aggregated,
-                                         &cluster_sizes_counts_aggregated,
-                                         &cluster_sizes_percolated_aggregated);
-
-            /* add one if this lattice has a percolating cluster */
-            for (j = 0; j < cluster_sizes_total_count; j++) {
-                if (cluster_sizes_percolated[j]) {
-                    percolation_counts[i] += 1;
-                    break;
+    /* pick the fastest kernels for this lattice size */
+    if (!prepare_kernel_tuning(tuning_path, autotune, L, L)) {
+        printf("could not use the tuning file %s\n", tuning_path);
+        return 1;
+    }
+
+    /* realizations are sampled by producer and consumer threads */
+    pipeline = NULL;
+    if (producers > 0) {
+        pipeline = create_sweep_pipeline(L, L, producers, consumers, pipeline_buffers);
+        if (!pipeline) {
+            printf("could not start the pipeline\n");
+            return 1;
+        }
+        sweep_set_pipeline(pipeline);
+    }
+
+    /* bonds are populated instead of sites, and the files are named after them */
+    bonds = NULL;
+    if (bond_percolation) {
+        bonds = allocate_bond_lattice(L, L);
+        sweep_set_bonds(bonds);
+        set_output_lattice("bond");
+    }
+
+    /* continue from the saved state, including the random number generator */
+    i = 0;
+    nrepetitions = 0;
+    elapsed = 0;
+    if (resume) {
+        free(points);
+        if (!read_sweep_checkpoint(checkpoint_path, L, L, &random_seed, &points,
+                                   &N, &i, &nrepetitions, &elapsed)) {
+            printf("could not resume from checkpoint %s\n", checkpoint_path);
+            return 1;
+        }
+        printf("resuming from p_%d out of %d\n", i+1, N);
+    }
+    checkpoint_time = checkpoint_path ? time(NULL) + checkpoint_interval : 0;
+
+    /* cluster statistics are handed over to a background writer */
+    container = NULL;
+    if (use_container) {
+        container = open_sweep_container(output_path, L, L, random_seed, grid_npoints,
+                                         probability_center, decay, resume);
+        if (!container) {
+            printf("could not open the container in %s (or it does not match this run)\n",
+                   output_path);
+            return 1;
+        }
+    }
+
+    /* every realization is stored so that it can be replayed later */
+    corpus = NULL;
+    if (corpus_path) {
+        corpus = create_lattice_corpus(corpus_path, L, L, random_seed, corpus_labels);
+        if (!corpus) {
+            printf("could not create the corpus %s\n", corpus_path);
+            return 1;
+        }
+        sweep_set_corpus(corpus);
+    }
+
+    /* the progress is periodically reported for monitoring */
+    status = NULL;
+    if (status_path) {
+        status = open_run_status(status_path, "probability_sweep", L, L, status_interval);
+        if (!status) {
+            printf("could not write the status file %s\n", status_path);
+            return 1;
+        }
+    }
+
+    /* when sharing a global budget all grid points are sampled in rounds */
+    if (budget_mode) {
+        budget_sweep(points, N, lattice, L, min_repetitions, target_error, Z,
+                     budget_samples, budget_time, status);
+    }
+
+    /* calculate cluster statistics per probability; when refining the grid
+       new points are appended after each pass until reaching the resolution */
+    new_points = N;
+    while (new_points > 0) {
+        for (; i < N; i++) {
+            while (!budget_mode &&
+                   !sample_to_target_error(&points[i], lattice, L, min_repetitions,
+                                           target_error, Z, maxtime, &nrepetitions,
+                                           &elapsed, checkpoint_time, status, i, N)) {
+                if (!write_sweep_checkpoint(checkpoint_path, L, L, random_seed, points,
+                                            N, i, nrepetitions, elapsed)) {
+                    printf("WARNING: could not write the checkpoint %s ...\n", checkpoint_path);
                 }
+                checkpoint_time = time(NULL) + checkpoint_interval;
             }
+            nrepetitions = 0;
+            elapsed = 0;
 
-            free(cluster_sizes);
-            free(cluster_sizes_counts);
-            free(cluster_sizes_percolated);
-            cluster_sizes_total_count = 0;
-
-            if (n == nrepetitions - 1) {
-                probability_estimation = ((double)percolation_counts[i])/nrepetitions;
-                nrepetitions_estimation = samples_for_target_ci(probability_estimation, target_error, Z);
-                nrepetitions = nrepetitions_estimation > nrepetitions ? nrepetitions_estimation : nrepetitions;
-                time_check_interval = nrepetitions / 100;
-                /*printf("adjusting repetitions to %d for i = %d with p = %3f using Z = %f\n",
-                       nrepetitions, i, probability_estimation, Z);*/
+            PROFILE_START();
+            set_output_profile(profile ? &points[i].profile : NULL);
+            if (container) {
+                append_sweep_container(container, i, &points[i]);
+            } else {
+                write_probability_sweep_cluster_statistics_to_file(output_path,
+                                                                    points[i].cluster_sizes,
+                                                                    points[i].cluster_sizes_counts,
+                                                                    points[i].cluster_sizes_percolated,
+                                                                    points[i].cluster_sizes_total_count,
+                                                                    L, L, points[i].probability,
+                                                                    random_seed,
+                                                                    points[i].realizations,
+                                                                    grid_npoints,
+                                                                    probability_center,
+                                                                    decay);
             }
+            set_output_profile(NULL);
+            PROFILE_PHASE(&points[i].profile, PHASE_OUTPUT);
 
-            if ((n+1) % time_check_interval == 0) {
-                current_time = time(NULL);
-                if (current_time - start_time > maxtime) {
-                    printf("WARNING: aborting due to excess time ...\n");
-                    nrepetitions = n+1;
-                    break;
-                }
+            sweep_point_clear(&points[i]);
+
+            /* print progress to stdout */
+            if (i < grid_npoints && output_interval > 0 && (i+1) % output_interval == 0) {
+                printf("finished with p_%d out of %d\n", i+1, grid_npoints);
             }
         }
 
-        nrepetitions_final[i] = nrepetitions;
+        if (adaptive_resolution <= 0) {
+            break;
+        }
+        qsort(points, N, sizeof(sweep_point), compare_sweep_points);
+        new_points = refine_grid(&points, N, adaptive_max_points,
+                                 adaptive_resolution, target_error, Z,
+                                 grid_rounding_digits);
+        N += new_points;
+        if (new_points > 0) {
+            printf("refining grid with %d new points (%d in total)\n", new_points, N);
+        }
+    }
 
-        write_probability_sweep_cluster_statistics_to_file("print/data",
-                                                            cluster_sizes_aggregated,
-                                                            cluster_sizes_counts_aggregated,
-                                                            cluster_sizes_percolated_aggregated,
-                                                            cluster_sizes_total_count_aggregated,
-                                                            L, L, probability_grid[i],
-                                                            random_seed,
-                                                            nrepetitions, N,
-                                                            probability_center,
-                                                            decay);
+    if (container) {
+        close_sweep_container(container);
+    }
+    if (corpus) {
+        sweep_set_corpus(NULL);
+        close_lattice_corpus(corpus);
+    }
+    close_run_status(status);
+    if (pipeline) {
+        sweep_set_pipeline(NULL);
+        close_sweep_pipeline(pipeline);
+    }
+    if (bonds) {
+        sweep_set_bonds(NULL);
+        free_bond_lattice(bonds);
+    }
 
-        free(cluster_sizes_aggregated);
-        free(cluster_sizes_counts_aggregated);
-        free(cluster_sizes_percolated_aggregated);
-        cluster_sizes_total_count_aggregated = 0;
+    profile_init(&run_profile);
+    for (i = 0; i < N; i++) {
+        profile_add(&run_profile, &points[i].profile);
+    }
+    PROFILE_START();
 
-        /* print progress to stdout */
-        if ((i+1) % output_interval == 0) {
-            printf("finished with p_%d out of %d\n", i+1, N);
-        }
+    probability_grid = realloc(probability_grid, N*sizeof(double));
+    percolation_counts = realloc(percolation_counts, N*sizeof(int));
+    nrepetitions_final = realloc(nrepetitions_final, N*sizeof(int));
+    for (i = 0; i < N; i++) {
+        probability_grid[i] = points[i].probability;
+        percolation_counts[i] = points[i].percolation_count;
+        nrepetitions_final[i] = points[i].realizations;
     }
 
-    write_probability_sweep_percolation_probability("print/data", probability_grid,
+    write_probability_sweep_percolation_probability(output_path, probability_grid,
                                                     percolation_counts, N,
                                                     probability_center, decay,
                                                     nrepetitions_final, L, L, random_seed);
+    sweep_points_write_observables(output_path, points, N, probability_center,
+                                   decay, L, L, random_seed);
+    PROFILE_PHASE(&run_profile, PHASE_OUTPUT);
+    if (profile) {
+        printf("time spent in each phase:\n");
+        print_profile(&run_profile);
+    }
 
     /* free memory before leaving */
     free(lattice);
     free(probability_grid);
     free(percolation_counts);
     free(nrepetitions_final);
+    free(points);
+    if (shard_count > 1) {
+        free(output_path);
+    }
+
+    /* the run is complete, so its checkpoint is no longer needed */
+    if (checkpoint_path) {
+        remove(checkpoint_path);
+    }
 
     return 0;
 }
@@ -213,3 +521,234 @@ unsigned int samples_for_target_ci(double p, double error, double Z)
 {
     return (Z*Z)*p*(1-p)/(error*error);
 }
+
+char sample_to_target_error(sweep_point * point, int * lattice, int L,
+                            int min_repetitions, double target_error, double Z,
+                            time_t maxtime, int * nrepetitions, double * elapsed,
+                            time_t checkpoint_time, run_status * status,
+                            int index, int npoints)
+{
+    int n;
+    int chunk; /* realizations sampled at once */
+    int nrepetitions_estimation;
+    int time_check_interval;
+    double probability_estimation;
+    time_t start_time;
+    time_t current_time;
+
+    start_time = time(NULL) - *elapsed;
+    if (*nrepetitions == 0) {
+        *nrepetitions = min_repetitions;
+    }
+    time_check_interval = *nrepetitions > 100 ? *nrepetitions / 100 : 1;
+    for (n = point->realizations; n < *nrepetitions; n += chunk) {
+        /* sample up to the next time check (or the current target) at once,
+           so that a pipeline gets many realizations to work on */
+        chunk = time_check_interval - n % time_check_interval;
+        chunk = chunk < *nrepetitions - n ? chunk : *nrepetitions - n;
+        sweep_point_sample(point, lattice, L, L, chunk);
+        update_run_status(status, chunk, index, npoints, *nrepetitions - n - chunk,
+                          (index + ((double)(n + chunk))/(*nrepetitions))/npoints);
+
+        if (n + chunk == *nrepetitions) {
+            probability_estimation = ((double)point->percolation_count)/(*nrepetitions);
+            nrepetitions_estimation = samples_for_target_ci(probability_estimation, target_error, Z);
+            *nrepetitions = nrepetitions_estimation > *nrepetitions ? nrepetitions_estimation : *nrepetitions;
+            time_check_interval = *nrepetitions > 100 ? *nrepetitions / 100 : 1;
+            /*printf("adjusting repetitions to %d for p = %3f using Z = %f\n",
+                   *nrepetitions, probability_estimation, Z);*/
+        }
+
+        if ((n + chunk) % time_check_interval == 0) {
+            current_time = time(NULL);
+            *elapsed = difftime(current_time, start_time);
+            if (current_time - start_time > maxtime) {
+                printf("WARNING: aborting due to excess time ...\n");
+                return 1;
+            }
+            if (checkpoint_time > 0 && current_time >= checkpoint_time &&
+                n + chunk < *nrepetitions) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+int refine_grid(sweep_point ** points, int npoints, int max_points,
+                double resolution, double target_error, double Z,
+                int round_digits)
+{
+    int i;
+    int k;
+    int new_points;
+    int * intervals; /* intervals to be split, sorted by decreasing score */
+    double * scores; /* change of the percolation probability across each interval */
+    double p_left;
+    double p_right;
+    double variance;
+    double midpoint;
+    double round_factor;
+
+    if (npoints >= max_points) {
+        return 0;
+    }
+
+    /* score each interval by the change of the estimated percolation
+       probability across it plus its statistical uncertainty; only intervals
+       wider than the resolution where the curve changes by more than the
+       target error are worth splitting */
+    intervals = (int *)malloc(npoints*sizeof(int));
+    scores = (double *)malloc(npoints*sizeof(double));
+    new_points = 0;
+    for (i = 0; i < npoints - 1; i++) {
+        if ((*points)[i+1].probability - (*points)[i].probability <= resolution) {
+            continue;
+        }
+        p_left = ((double)(*points)[i].percolation_count)/(*points)[i].realizations;
+        p_right = ((double)(*points)[i+1].percolation_count)/(*points)[i+1].realizations;
+        variance = p_left*(1 - p_left)/(*points)[i].realizations +
+                   p_right*(1 - p_right)/(*points)[i+1].realizations;
+        scores[i] = fabs(p_right - p_left) + Z*sqrt(variance);
+        if (scores[i] <= target_error) {
+            continue;
+        }
+        /* insertion sort by decreasing score */
+        for (k = new_points; k > 0 && scores[intervals[k-1]] < scores[i]; k--) {
+            intervals[k] = intervals[k-1];
+        }
+        intervals[k] = i;
+        new_points++;
+    }
+
+    if (new_points > max_points - npoints) {
+        new_points = max_points - npoints;
+    }
+
+    /* append the midpoints of the selected intervals */
+    *points = realloc(*points, (npoints + new_points)*sizeof(sweep_point));
+    round_factor = pow(10, round_digits);
+    k = 0;
+    for (i = 0; i < new_points; i++) {
+        midpoint = ((*points)[intervals[i]].probability + (*points)[intervals[i]+1].probability)/2;
+        if (round_digits) {
+            midpoint = ((int)(midpoint*round_factor))/round_factor;
+            if (midpoint <= (*points)[intervals[i]].probability) {
+                continue;
+            }
+        }
+        sweep_point_init(&(*points)[npoints + k], midpoint);
+        k++;
+    }
+
+    free(intervals);
+    free(scores);
+
+    return k;
+}
+
+int compare_sweep_points(const void * a, const void * b)
+{
+    double pa = ((const sweep_point *)a)->probability;
+    double pb = ((const sweep_point *)b)->probability;
+    return (pa > pb) - (pa < pb);
+}
+
+/* wall time elapsed since the given instant of the monotonic clock */
+static double seconds_since(const struct timespec * start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec)*1e-9;
+}
+
+void budget_sweep(sweep_point * points, int npoints, int * lattice, int L,
+                  int min_repetitions, double target_error, double Z,
+                  long budget_samples, double budget_time, run_status * status)
+{
+    int i;
+    int round;
+    long * deficits; /* repetitions still missing to reach the target error at each point */
+    long total_deficit;
+    long samples_missing; /* repetitions still missing while sampling a round */
+    long samples_done;
+    long samples_remaining;
+    long samples_round;
+    long samples_point_total;
+    long samples_point;
+    long target;
+    double elapsed_time;
+    double sampling_rate; /* samples per second of wall time */
+    double probability_estimation;
+    struct timespec start_time;
+
+    deficits = (long *)malloc(npoints*sizeof(long));
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    /* first round: take the minimum amount of repetitions at every point */
+    for (i = 0; i < npoints; i++) {
+        sweep_point_sample(&points[i], lattice, L, L, min_repetitions);
+        update_run_status(status, min_repetitions, i, npoints, -1, 0);
+    }
+    samples_done = ((long)npoints)*min_repetitions;
+
+    for (round = 1; ; round++) {
+        /* reestimate how many repetitions each point still needs */
+        total_deficit = 0;
+        for (i = 0; i < npoints; i++) {
+            probability_estimation = ((double)points[i].percolation_count)/points[i].realizations;
+            target = samples_for_target_ci(probability_estimation, target_error, Z);
+            deficits[i] = target > points[i].realizations ? target - points[i].realizations : 0;
+            total_deficit += deficits[i];
+        }
+        if (total_deficit == 0) {
+            break;
+        }
+
+        /* determine how many samples are still affordable within the budget */
+        elapsed_time = seconds_since(&start_time);
+        samples_remaining = total_deficit;
+        if (budget_samples > 0 && budget_samples - samples_done < samples_remaining) {
+            samples_remaining = budget_samples - samples_done;
+        }
+        if (budget_time > 0) {
+            sampling_rate = samples_done/(elapsed_time + 1e-3);
+            if ((budget_time - elapsed_time)*sampling_rate < samples_remaining) {
+                samples_remaining = (budget_time - elapsed_time)*sampling_rate;
+            }
+        }
+        if (samples_remaining <= 0) {
+            printf("WARNING: budget exhausted with %ld repetitions still missing ...\n", total_deficit);
+            break;
+        }
+
+        /* spend at most a quarter of what is left, so that the variance
+           estimates get refined before the rest of the budget is allocated */
+        samples_round = samples_remaining/4 > npoints ? samples_remaining/4 : samples_remaining;
+
+        /* distribute the round samples in proportion to each point deficit */
+        samples_point_total = samples_round;
+        samples_missing = total_deficit;
+        for (i = 0; i < npoints && samples_round > 0; i++) {
+            samples_point = ceil(((double)samples_point_total)*deficits[i]/total_deficit);
+            samples_point = samples_point < deficits[i] ? samples_point : deficits[i];
+            samples_point = samples_point < samples_round ? samples_point : samples_round;
+            sweep_point_sample(&points[i], lattice, L, L, samples_point);
+            samples_done += samples_point;
+            samples_round -= samples_point;
+            samples_missing -= samples_point;
+            update_run_status(status, samples_point, i, npoints, samples_missing,
+                              ((double)samples_done)/(samples_done + samples_missing));
+            if (budget_time > 0 && seconds_since(&start_time) > budget_time) {
+                break;
+            }
+        }
+
+        printf("finished budget round %d with %ld repetitions (%ld missing)\n",
+               round, samples_done, total_deficit);
+    }
+
+    free(deficits);
+}
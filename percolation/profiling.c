@@ -0,0 +1,171 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+/* see header file for detailed documentation of each function */
+
+#define _GNU_SOURCE
+
+#include "profiling.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#define PROFILE_COUNTERS 3
+
+char profiling_enabled = 0;
+
+static const char * phase_names[PHASE_COUNT] = {
+    "generation",
+    "labeling",
+    "percolation",
+    "statistics",
+    "aggregation",
+    "output"
+};
+
+/* file descriptor of the group leader of the counters (-1 if unavailable) */
+static int counters_fd = -1;
+
+/* clock and counters at the start of the current phase */
+static struct timespec phase_start_time;
+static uint64_t phase_start_counters[PROFILE_COUNTERS];
+
+static void read_counters(uint64_t * counters)
+{
+#ifdef __linux__
+    /* group read format: number of counters followed by their values */
+    uint64_t values[1 + PROFILE_COUNTERS];
+    int i;
+
+    if (counters_fd >= 0 && read(counters_fd, values, sizeof(values)) == sizeof(values)) {
+        for (i = 0; i < PROFILE_COUNTERS; i++) {
+            counters[i] = values[1 + i];
+        }
+        return;
+    }
+#endif
+    memset(counters, 0, PROFILE_COUNTERS*sizeof(uint64_t));
+}
+
+#ifdef __linux__
+static int open_counter(uint64_t config, int group_fd)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = group_fd < 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+#endif
+
+char enable_profiling(void)
+{
+#ifdef __linux__
+    int cache_fd;
+    int branch_fd;
+
+    if (counters_fd < 0) {
+        counters_fd = open_counter(PERF_COUNT_HW_CPU_CYCLES, -1);
+        cache_fd = counters_fd >= 0 ? open_counter(PERF_COUNT_HW_CACHE_MISSES, counters_fd) : -1;
+        branch_fd = cache_fd >= 0 ? open_counter(PERF_COUNT_HW_BRANCH_MISSES, counters_fd) : -1;
+        if (branch_fd < 0) {
+            if (cache_fd >= 0) {
+                close(cache_fd);
+            }
+            if (counters_fd >= 0) {
+                close(counters_fd);
+            }
+            counters_fd = -1;
+        } else {
+            ioctl(counters_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(counters_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+#endif
+
+    profiling_enabled = 1;
+    profile_start();
+
+    return counters_fd >= 0;
+}
+
+char profiling_hardware_counters(void)
+{
+    return counters_fd >= 0;
+}
+
+void profile_init(phase_profile * profile)
+{
+    memset(profile, 0, sizeof(phase_profile));
+}
+
+void profile_add(phase_profile * total, const phase_profile * profile)
+{
+    int i;
+
+    for (i = 0; i < PHASE_COUNT; i++) {
+        total->seconds[i] += profile->seconds[i];
+        total->cycles[i] += profile->cycles[i];
+        total->cache_misses[i] += profile->cache_misses[i];
+        total->branch_misses[i] += profile->branch_misses[i];
+    }
+}
+
+const char * profile_phase_name(int phase)
+{
+    return phase_names[phase];
+}
+
+void print_profile(const phase_profile * profile)
+{
+    int i;
+
+    for (i = 0; i < PHASE_COUNT; i++) {
+        if (counters_fd >= 0) {
+            printf("%-12s %12.6f s %16llu cycles %14llu cache misses %14llu branch misses\n",
+                   phase_names[i], profile->seconds[i],
+                   (unsigned long long)profile->cycles[i],
+                   (unsigned long long)profile->cache_misses[i],
+                   (unsigned long long)profile->branch_misses[i]);
+        } else {
+            printf("%-12s %12.6f s\n", phase_names[i], profile->seconds[i]);
+        }
+    }
+}
+
+void profile_start(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &phase_start_time);
+    read_counters(phase_start_counters);
+}
+
+void profile_phase(phase_profile * profile, int phase)
+{
+    struct timespec now;
+    uint64_t counters[PROFILE_COUNTERS];
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    read_counters(counters);
+
+    profile->seconds[phase] += (now.tv_sec - phase_start_time.tv_sec) +
+                               (now.tv_nsec - phase_start_time.tv_nsec)*1e-9;
+    profile->cycles[phase] += counters[0] - phase_start_counters[0];
+    profile->cache_misses[phase] += counters[1] - phase_start_counters[1];
+    profile->branch_misses[phase] += counters[2] - phase_start_counters[2];
+
+    /* the next phase starts now */
+    phase_start_time = now;
+    memcpy(phase_start_counters, counters, sizeof(counters));
+}
@@ -0,0 +1,102 @@
+/*!
+    @file profiling.h
+    @brief This file contains optional instrumentation that accumulates the
+    wall time and hardware counters spent in each phase of a simulation.
+
+    Instrumentation is off by default. The PROFILE_START and PROFILE_PHASE
+    macros only test a flag when it is off, so they can be left in the inner
+    loops of the programs at no measurable cost.
+
+    @author Federico Cerisola
+    @copyright MIT License.
+*/
+
+#ifndef PROFILING_H
+#define PROFILING_H
+
+#include <stdint.h>
+
+/*! Phases of a simulation that are timed separately. */
+enum profile_phase {
+    PHASE_GENERATION = 0, /*!< populating lattices */
+    PHASE_LABELING, /*!< labeling clusters */
+    PHASE_PERCOLATION, /*!< looking for percolating clusters */
+    PHASE_STATISTICS, /*!< computing the cluster statistics of a lattice */
+    PHASE_AGGREGATION, /*!< adding the statistics to the accumulated results */
+    PHASE_OUTPUT, /*!< writing results to disk */
+    PHASE_COUNT
+};
+
+/*! Totals accumulated in each phase. */
+typedef struct {
+    double seconds[PHASE_COUNT]; /*!< wall time (monotonic clock) */
+    uint64_t cycles[PHASE_COUNT]; /*!< CPU cycles */
+    uint64_t cache_misses[PHASE_COUNT]; /*!< last level cache misses */
+    uint64_t branch_misses[PHASE_COUNT]; /*!< mispredicted branches */
+} phase_profile;
+
+/*! Whether instrumentation is on (use enable_profiling to change it). */
+extern char profiling_enabled;
+
+/*! Start timing a phase, if instrumentation is on. */
+#define PROFILE_START() \
+    do { if (profiling_enabled) profile_start(); } while (0)
+
+/*! Add the time since the last PROFILE_START or PROFILE_PHASE to a phase of
+    a profile and start timing the next phase, if instrumentation is on. */
+#define PROFILE_PHASE(profile, phase) \
+    do { if (profiling_enabled) profile_phase((profile), (phase)); } while (0)
+
+/*! Turn instrumentation on.
+
+    Wall time is always measured. Hardware counters are read through
+    perf_event_open (Linux only), and are left at zero if the kernel does not
+    allow it (e.g. because of /proc/sys/kernel/perf_event_paranoid).
+
+    @return 1 if the hardware counters are available, 0 otherwise.
+*/
+char enable_profiling(void);
+
+/*! Whether the hardware counters of the profiles are being measured.
+
+    @return 1 if they are, 0 otherwise.
+*/
+char profiling_hardware_counters(void);
+
+/*! Reset all the totals of a profile to zero.
+
+    @param profile pointer to the profile.
+*/
+void profile_init(phase_profile * profile);
+
+/*! Add the totals of a profile to another one.
+
+    @param total pointer to the profile where the totals are added.
+    @param profile pointer to the profile to be added.
+*/
+void profile_add(phase_profile * total, const phase_profile * profile);
+
+/*! Get the name of a phase, as used in the output files.
+
+    @param phase one of profile_phase.
+    @return The name of the phase.
+*/
+const char * profile_phase_name(int phase);
+
+/*! Print the totals of a profile to stdout.
+
+    @param profile pointer to the profile.
+*/
+void print_profile(const phase_profile * profile);
+
+/*! Take the start of a phase (use PROFILE_START instead). */
+void profile_start(void);
+
+/*! Close a phase and start the next one (use PROFILE_PHASE instead).
+
+    @param profile pointer to the profile where the phase is accumulated.
+    @param phase one of profile_phase.
+*/
+void profile_phase(phase_profile * profile, int phase);
+
+#endif /* PROFILING_H */
@@ -79,7 +79,22 @@ void srand_pcg(uint64_t seed)
     pcg32_srandom(seed, 54u);
 }
 
+void srand_pcg_stream(uint64_t seed, uint64_t stream)
+{
+    pcg32_srandom(seed, 54u + stream);
+}
+
 uint32_t rand_pcg()
 {
     return pcg32_random();
 }
+
+void get_state_pcg(pcg32_random_t* rng)
+{
+    *rng = pcg32_global;
+}
+
+void set_state_pcg(const pcg32_random_t* rng)
+{
+    pcg32_global = *rng;
+}
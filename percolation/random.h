@@ -68,4 +68,12 @@ uint32_t pcg32_random_r(pcg32_random_t* rng);
 void srand_pcg(uint64_t seed);
 uint32_t rand_pcg();
 
+/* seed the global RNG selecting one of many non-overlapping streams (e.g. one
+   per process of a run split in shards); stream 0 is the one used by srand_pcg */
+void srand_pcg_stream(uint64_t seed, uint64_t stream);
+
+/* save and restore the state of the global RNG (e.g. for checkpoints) */
+void get_state_pcg(pcg32_random_t* rng);
+void set_state_pcg(const pcg32_random_t* rng);
+
 #endif /* PCG_BASIC_H_INCLUDED */
@@ -0,0 +1,195 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+/* see header file for detailed documentation of each function */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "status.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+struct run_status {
+    char * path;
+    char * temporary_path;
+    const char * program;
+    int rows;
+    int columns;
+    int points;
+    double interval; /* minimum seconds between rewrites */
+    double start; /* monotonic time when the run started */
+    double last_write; /* monotonic time of the last rewrite */
+    time_t next_check; /* wall time when a rewrite may be due */
+    long realizations; /* lattices generated so far */
+    long last_realizations; /* lattices generated at the last rewrite */
+    int point;
+    long remaining;
+    double progress;
+};
+
+static double monotonic_seconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec*1e-9;
+}
+
+/* current resident memory in kB, or the peak one where /proc is missing */
+static long resident_memory_kb(void)
+{
+    FILE * file_handler;
+    long pages;
+    long resident;
+    struct rusage usage;
+
+    file_handler = fopen("/proc/self/statm", "r");
+    if (file_handler) {
+        if (fscanf(file_handler, "%ld %ld", &pages, &resident) == 2) {
+            fclose(file_handler);
+            return resident*(sysconf(_SC_PAGESIZE)/1024);
+        }
+        fclose(file_handler);
+    }
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return usage.ru_maxrss;
+    }
+    return -1;
+}
+
+/* write the status to a temporary file and move it over the previous one */
+static char write_run_status(run_status * status, const char * state)
+{
+    FILE * file_handler;
+    double now;
+    double elapsed;
+    double rate; /* lattices per second since the last rewrite */
+    double mean_rate; /* lattices per second since the start */
+    double eta;
+
+    now = monotonic_seconds();
+    elapsed = now - status->start;
+    rate = now > status->last_write ?
+           (status->realizations - status->last_realizations)/(now - status->last_write) : 0;
+    mean_rate = elapsed > 0 ? status->realizations/elapsed : 0;
+    eta = -1;
+    if (status->progress > 0) {
+        eta = elapsed*(1 - status->progress)/status->progress;
+    }
+
+    file_handler = fopen(status->temporary_path, "w");
+    if (!file_handler) {
+        return 0;
+    }
+    fprintf(file_handler, "{\n");
+    fprintf(file_handler, "  \"program\": \"%s\",\n", status->program);
+    fprintf(file_handler, "  \"pid\": %ld,\n", (long)getpid());
+    fprintf(file_handler, "  \"state\": \"%s\",\n", state);
+    fprintf(file_handler, "  \"rows\": %d,\n", status->rows);
+    fprintf(file_handler, "  \"columns\": %d,\n", status->columns);
+    fprintf(file_handler, "  \"point\": %d,\n", status->point);
+    fprintf(file_handler, "  \"points\": %d,\n", status->points);
+    fprintf(file_handler, "  \"realizations_done\": %ld,\n", status->realizations);
+    if (status->remaining >= 0) {
+        fprintf(file_handler, "  \"realizations_remaining\": %ld,\n", status->remaining);
+    } else {
+        fprintf(file_handler, "  \"realizations_remaining\": null,\n");
+    }
+    fprintf(file_handler, "  \"progress\": %.6f,\n", status->progress);
+    fprintf(file_handler, "  \"elapsed_seconds\": %.3f,\n", elapsed);
+    fprintf(file_handler, "  \"lattices_per_second\": %.6g,\n", rate);
+    fprintf(file_handler, "  \"sites_per_second\": %.6g,\n",
+            rate*status->rows*status->columns);
+    fprintf(file_handler, "  \"mean_lattices_per_second\": %.6g,\n", mean_rate);
+    if (eta >= 0) {
+        fprintf(file_handler, "  \"eta_seconds\": %.0f,\n", eta);
+    } else {
+        fprintf(file_handler, "  \"eta_seconds\": null,\n");
+    }
+    fprintf(file_handler, "  \"rss_kb\": %ld,\n", resident_memory_kb());
+    fprintf(file_handler, "  \"updated\": %ld\n", (long)time(NULL));
+    fprintf(file_handler, "}\n");
+    if (fclose(file_handler) != 0) {
+        return 0;
+    }
+
+    status->last_write = now;
+    status->last_realizations = status->realizations;
+
+    return rename(status->temporary_path, status->path) == 0;
+}
+
+run_status * open_run_status(const char * path, const char * program,
+                             int rows, int columns, double interval)
+{
+    run_status * status;
+
+    status = (run_status *)malloc(sizeof(run_status));
+    status->path = (char *)malloc(strlen(path) + 1);
+    strcpy(status->path, path);
+    status->temporary_path = (char *)malloc(strlen(path) + 5);
+    sprintf(status->temporary_path, "%s.tmp", path);
+    status->program = program;
+    status->rows = rows;
+    status->columns = columns;
+    status->points = 0;
+    status->interval = interval;
+    status->start = monotonic_seconds();
+    status->last_write = status->start;
+    status->next_check = time(NULL) + (time_t)interval;
+    status->realizations = 0;
+    status->last_realizations = 0;
+    status->point = 0;
+    status->remaining = -1;
+    status->progress = 0;
+
+    if (!write_run_status(status, "running")) {
+        free(status->path);
+        free(status->temporary_path);
+        free(status);
+        return NULL;
+    }
+
+    return status;
+}
+
+void update_run_status(run_status * status, long realizations, int point,
+                       int points, long remaining, double progress)
+{
+    if (!status) {
+        return;
+    }
+
+    status->realizations += realizations;
+    status->point = point;
+    status->points = points;
+    status->remaining = remaining;
+    status->progress = progress;
+
+    /* the wall clock has a resolution of seconds, which is enough to tell
+       whether the more precise monotonic clock needs to be read at all */
+    if (time(NULL) < status->next_check ||
+        monotonic_seconds() - status->last_write < status->interval) {
+        return;
+    }
+    write_run_status(status, "running");
+    status->next_check = time(NULL) + (time_t)status->interval;
+}
+
+void close_run_status(run_status * status)
+{
+    if (!status) {
+        return;
+    }
+
+    status->remaining = 0;
+    status->progress = 1;
+    write_run_status(status, "finished");
+
+    free(status->path);
+    free(status->temporary_path);
+    free(status);
+}
@@ -0,0 +1,64 @@
+/*!
+    @file status.h
+    @brief This file contains functions to report the progress of long runs
+    in a small JSON file that is periodically rewritten in place.
+
+    The status file holds the position of the run, the realizations done and
+    remaining, the throughput in lattices and sites per second, an estimate of
+    the time left and the resident memory of the process, so that monitoring
+    scripts can detect stalled jobs and throughput regressions while they run.
+    Like checkpoints, it is written to a temporary file which is then renamed,
+    so readers never see a partially written status.
+
+    @author Federico Cerisola
+    @copyright MIT License.
+*/
+
+#ifndef STATUS_H
+#define STATUS_H
+
+/*! Opaque handle to the progress of a run and where it is reported. */
+typedef struct run_status run_status;
+
+/*! Start reporting the progress of a run.
+
+    The file is written right away, with no realizations done.
+
+    @param path path to the status file. If the file exists it will be
+        overwritten.
+    @param program name of the program, reported in the file.
+    @param rows the number of rows of the lattices.
+    @param columns the number of columns of the lattices.
+    @param interval minimum number of seconds between rewrites of the file.
+    @return A pointer to the newly allocated status, or NULL if the file could
+        not be written.
+*/
+run_status * open_run_status(const char * path, const char * program,
+                             int rows, int columns, double interval);
+
+/*! Add realizations to the progress and rewrite the status file if the
+    interval since the last rewrite has elapsed.
+
+    When the interval has not elapsed this only reads the wall clock, so it
+    can be called after every realization.
+
+    @param status pointer to the status (nothing is done if NULL).
+    @param realizations number of lattices generated since the last update.
+    @param point index of the grid point (or trial) being sampled.
+    @param points total number of grid points (or trials) of the run.
+    @param remaining number of realizations left in the run (or in the
+        current point when the run adapts its repetitions), or a negative
+        value if unknown.
+    @param progress fraction of the whole run already done, between 0 and 1,
+        used to estimate the time left.
+*/
+void update_run_status(run_status * status, long realizations, int point,
+                       int points, long remaining, double progress);
+
+/*! Write the final status of a run and free the status.
+
+    @param status pointer to the status (nothing is done if NULL).
+*/
+void close_run_status(run_status * status);
+
+#endif /* STATUS_H */
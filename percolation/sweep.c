@@ -0,0 +1,375 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+/* see header file for detailed documentation of each function */
+
+#include "sweep.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include "lattice.h"
+#include "clusters.h"
+#include "io_helpers.h"
+#include "dispatch.h"
+#include "pipeline.h"
+#include "bonds.h"
+#include "status.h"
+
+/* corpus where sampled realizations are stored (NULL if none) */
+static lattice_corpus * sweep_corpus = NULL;
+
+/* pipeline sampling the realizations in other threads (NULL if none) */
+static sweep_pipeline * sweep_pipeline_threads = NULL;
+
+/* bonds populated instead of the sites, for bond percolation (NULL if none) */
+static bond_lattice * sweep_bonds = NULL;
+
+/* logarithmic binning of the cluster sizes (0 bins per decade if exact) */
+static int sweep_bins_per_decade = 0;
+static int sweep_exact_sizes = 0;
+
+void sweep_set_corpus(lattice_corpus * corpus)
+{
+    sweep_corpus = corpus;
+}
+
+void sweep_set_pipeline(sweep_pipeline * pipeline)
+{
+    sweep_pipeline_threads = pipeline;
+}
+
+void sweep_set_bonds(bond_lattice * bonds)
+{
+    sweep_bonds = bonds;
+}
+
+int sweep_set_log_bins(int bins_per_decade, int exact_sizes)
+{
+    if (bins_per_decade > 0 && exact_sizes < cluster_size_minimum_exact_sizes(bins_per_decade)) {
+        exact_sizes = cluster_size_minimum_exact_sizes(bins_per_decade);
+    }
+    sweep_bins_per_decade = bins_per_decade;
+    sweep_exact_sizes = exact_sizes;
+    return exact_sizes;
+}
+
+/* add cluster statistics to the logarithmic bins of a point, extending them
+   up to the largest bin needed */
+static void sweep_point_bin(sweep_point * point, int cluster_sizes_total_count,
+                            const int * cluster_sizes, const int * cluster_sizes_counts,
+                            const int * cluster_sizes_percolated)
+{
+    int j;
+    int bin;
+
+    for (j = 0; j < cluster_sizes_total_count; j++) {
+        bin = cluster_size_bin(cluster_sizes[j], sweep_bins_per_decade, sweep_exact_sizes);
+        if (bin >= point->cluster_sizes_total_count) {
+            point->cluster_sizes = realloc(point->cluster_sizes, (bin + 1)*sizeof(int));
+            point->cluster_sizes_counts = realloc(point->cluster_sizes_counts, (bin + 1)*sizeof(int));
+            point->cluster_sizes_percolated = realloc(point->cluster_sizes_percolated, (bin + 1)*sizeof(int));
+            for (; point->cluster_sizes_total_count <= bin; point->cluster_sizes_total_count++) {
+                point->cluster_sizes[point->cluster_sizes_total_count] =
+                    cluster_size_bin_lower_edge(point->cluster_sizes_total_count,
+                                                sweep_bins_per_decade, sweep_exact_sizes);
+                point->cluster_sizes_counts[point->cluster_sizes_total_count] = 0;
+                point->cluster_sizes_percolated[point->cluster_sizes_total_count] = 0;
+            }
+        }
+        point->cluster_sizes_counts[bin] += cluster_sizes_counts[j];
+        point->cluster_sizes_percolated[bin] += cluster_sizes_percolated[j];
+    }
+}
+
+void sweep_point_init(sweep_point * point, double probability)
+{
+    point->probability = probability;
+    point->percolation_count = 0;
+    point->realizations = 0;
+    point->cluster_sizes_total_count = 0;
+    point->cluster_sizes = NULL;
+    point->cluster_sizes_counts = NULL;
+    point->cluster_sizes_percolated = NULL;
+    point->mean_cluster_size.count = 0;
+    point->mean_cluster_size.mean = 0;
+    point->mean_cluster_size.sum_squares = 0;
+    point->second_moment = point->mean_cluster_size;
+    point->strength = point->mean_cluster_size;
+    profile_init(&point->profile);
+}
+
+void sweep_point_clear(sweep_point * point)
+{
+    free(point->cluster_sizes);
+    free(point->cluster_sizes_counts);
+    free(point->cluster_sizes_percolated);
+    point->cluster_sizes_total_count = 0;
+    point->cluster_sizes = NULL;
+    point->cluster_sizes_counts = NULL;
+    point->cluster_sizes_percolated = NULL;
+}
+
+void sweep_point_accumulate(sweep_point * point, const int * lattice,
+                            int rows, int columns)
+{
+    int cluster_sizes_total_count;
+    int * cluster_sizes;
+    int * cluster_sizes_counts;
+    int * cluster_sizes_percolated;
+
+    cluster_statistics(lattice, rows, columns, &cluster_sizes_total_count,
+                       &cluster_sizes, &cluster_sizes_counts,
+                       &cluster_sizes_percolated, NULL, NULL);
+    PROFILE_PHASE(&point->profile, PHASE_STATISTICS);
+    sweep_point_add_clusters(point, cluster_sizes_total_count, cluster_sizes,
+                             cluster_sizes_counts, cluster_sizes_percolated,
+                             ((long)rows)*columns);
+
+    free(cluster_sizes);
+    free(cluster_sizes_counts);
+    free(cluster_sizes_percolated);
+}
+
+void sweep_point_add_clusters(sweep_point * point, int cluster_sizes_total_count,
+                              const int * cluster_sizes,
+                              const int * cluster_sizes_counts,
+                              const int * cluster_sizes_percolated, long sites)
+{
+    int j;
+    double finite_mass; /* sites in non percolating clusters */
+    double finite_second_moment; /* sum of s^2 over non percolating clusters */
+    double percolating_mass; /* sites in percolating clusters */
+
+    if (sweep_bins_per_decade > 0) {
+        sweep_point_bin(point, cluster_sizes_total_count, cluster_sizes,
+                        cluster_sizes_counts, cluster_sizes_percolated);
+    } else {
+        aggregate_cluster_statistics(cluster_sizes_total_count, cluster_sizes,
+                                     cluster_sizes_counts, cluster_sizes_percolated,
+                                     &point->cluster_sizes_total_count,
+                                     &point->cluster_sizes,
+                                     &point->cluster_sizes_counts,
+                                     &point->cluster_sizes_percolated);
+    }
+    PROFILE_PHASE(&point->profile, PHASE_AGGREGATION);
+
+    /* add one if this lattice has a percolating cluster */
+    for (j = 0; j < cluster_sizes_total_count; j++) {
+        if (cluster_sizes_percolated[j]) {
+            point->percolation_count += 1;
+            break;
+        }
+    }
+    PROFILE_PHASE(&point->profile, PHASE_PERCOLATION);
+
+    /* observables of this realization, from the exact cluster sizes */
+    finite_mass = 0;
+    finite_second_moment = 0;
+    percolating_mass = 0;
+    for (j = 0; j < cluster_sizes_total_count; j++) {
+        finite_mass += ((double)cluster_sizes[j])*(cluster_sizes_counts[j] - cluster_sizes_percolated[j]);
+        finite_second_moment += ((double)cluster_sizes[j])*cluster_sizes[j]*
+                                (cluster_sizes_counts[j] - cluster_sizes_percolated[j]);
+        percolating_mass += ((double)cluster_sizes[j])*cluster_sizes_percolated[j];
+    }
+    running_moments_add(&point->mean_cluster_size,
+                        finite_mass > 0 ? finite_second_moment/finite_mass : 0);
+    running_moments_add(&point->second_moment, finite_second_moment/sites);
+    running_moments_add(&point->strength, percolating_mass/sites);
+
+    point->realizations += 1;
+    PROFILE_PHASE(&point->profile, PHASE_AGGREGATION);
+}
+
+void sweep_point_merge(sweep_point * point, const sweep_point * other)
+{
+    /* the smallest size of each bin falls in the same bin */
+    if (sweep_bins_per_decade > 0) {
+        sweep_point_bin(point, other->cluster_sizes_total_count, other->cluster_sizes,
+                        other->cluster_sizes_counts, other->cluster_sizes_percolated);
+    } else {
+        aggregate_cluster_statistics(other->cluster_sizes_total_count, other->cluster_sizes,
+                                     other->cluster_sizes_counts,
+                                     other->cluster_sizes_percolated,
+                                     &point->cluster_sizes_total_count,
+                                     &point->cluster_sizes,
+                                     &point->cluster_sizes_counts,
+                                     &point->cluster_sizes_percolated);
+    }
+    point->percolation_count += other->percolation_count;
+    point->realizations += other->realizations;
+    running_moments_merge(&point->mean_cluster_size, &other->mean_cluster_size);
+    running_moments_merge(&point->second_moment, &other->second_moment);
+    running_moments_merge(&point->strength, &other->strength);
+    profile_add(&point->profile, &other->profile);
+}
+
+void sweep_point_sample(sweep_point * point, int * lattice, int rows, int columns,
+                        int nrealizations)
+{
+    int n;
+
+    if (sweep_bonds) {
+        PROFILE_START();
+        for (n = 0; n < nrealizations; n++) {
+            populate_bonds(point->probability, sweep_bonds, 0);
+            PROFILE_PHASE(&point->profile, PHASE_GENERATION);
+            label_bond_clusters(sweep_bonds, lattice);
+            PROFILE_PHASE(&point->profile, PHASE_LABELING);
+            sweep_point_accumulate(point, lattice, rows, columns);
+        }
+        return;
+    }
+
+    select_kernels(rows, columns, point->probability);
+    if (sweep_pipeline_threads) {
+        sweep_pipeline_sample(sweep_pipeline_threads, point, nrealizations);
+        return;
+    }
+    PROFILE_START();
+    for (n = 0; n < nrealizations; n++) {
+        dispatch_populate(point->probability, lattice, rows, columns);
+        PROFILE_PHASE(&point->profile, PHASE_GENERATION);
+        dispatch_label(lattice, rows, columns);
+        PROFILE_PHASE(&point->profile, PHASE_LABELING);
+        if (sweep_corpus) {
+            append_lattice_corpus(sweep_corpus, lattice, point->probability);
+            PROFILE_PHASE(&point->profile, PHASE_OUTPUT);
+        }
+        sweep_point_accumulate(point, lattice, rows, columns);
+    }
+}
+
+void sweep_point_replay(sweep_point * point, const lattice_corpus * corpus,
+                        long first, long nrealizations, int * lattice)
+{
+    long n;
+    int rows;
+    int columns;
+
+    lattice_corpus_info(corpus, &rows, &columns, NULL, NULL);
+    PROFILE_START();
+    for (n = first; n < first + nrealizations; n++) {
+        read_lattice_corpus(corpus, n, lattice, 1);
+        PROFILE_PHASE(&point->profile, PHASE_GENERATION);
+        sweep_point_accumulate(point, lattice, rows, columns);
+    }
+}
+
+void sweep_points_sample_nested(sweep_point * points, int * lattice, int size,
+                                const int * box_sizes, int box_count,
+                                int ** boxes, int nrealizations)
+{
+    int n;
+    int k;
+
+    for (n = 0; n < nrealizations; n++) {
+        populate_lattice(points[0].probability, lattice, size, size, 0);
+        label_nested_boxes(lattice, size, box_sizes, box_count, boxes);
+        for (k = 0; k < box_count; k++) {
+            sweep_point_accumulate(&points[k], boxes[k], box_sizes[k], box_sizes[k]);
+        }
+    }
+}
+
+void sweep_points_run(sweep_point * points, int npoints, double probability_center,
+                      double decay, int nrepetitions, sweep_sampling_function sample,
+                      void * data, long sites, int rows, int columns,
+                      unsigned int seed, run_status * status)
+{
+    int i;
+    int n;
+    int output_interval;
+    double * probability_grid;
+    int * percolation_counts;
+    int * nrepetitions_final;
+    int cluster_sizes_total_count;
+    int * cluster_sizes;
+    int * cluster_sizes_counts;
+    int * cluster_sizes_percolated;
+
+    probability_grid = (double *)malloc(npoints*sizeof(double));
+    percolation_counts = (int *)malloc(npoints*sizeof(int));
+    nrepetitions_final = (int *)malloc(npoints*sizeof(int));
+    output_interval = npoints / 10;
+
+    /* calculate cluster statistics per probability */
+    for (i = 0; i < npoints; i++) {
+        for (n = 0; n < nrepetitions; n++) {
+            sample(data, points[i].probability, &cluster_sizes_total_count,
+                   &cluster_sizes, &cluster_sizes_counts, &cluster_sizes_percolated);
+            sweep_point_add_clusters(&points[i], cluster_sizes_total_count, cluster_sizes,
+                                     cluster_sizes_counts, cluster_sizes_percolated,
+                                     sites);
+            free(cluster_sizes);
+            free(cluster_sizes_counts);
+            free(cluster_sizes_percolated);
+            update_run_status(status, 1, i + 1, npoints, nrepetitions - n - 1,
+                              (i + (n + 1.0)/nrepetitions)/npoints);
+        }
+
+        write_probability_sweep_cluster_statistics_to_file("print/data",
+                                                            points[i].cluster_sizes,
+                                                            points[i].cluster_sizes_counts,
+                                                            points[i].cluster_sizes_percolated,
+                                                            points[i].cluster_sizes_total_count,
+                                                            rows, columns, points[i].probability,
+                                                            seed, points[i].realizations,
+                                                            npoints, probability_center, decay);
+        sweep_point_clear(&points[i]);
+        probability_grid[i] = points[i].probability;
+        percolation_counts[i] = points[i].percolation_count;
+        nrepetitions_final[i] = points[i].realizations;
+
+        /* print progress to stdout */
+        if (output_interval > 0 && (i+1) % output_interval == 0) {
+            printf("finished with p_%d out of %d\n", i+1, npoints);
+        }
+    }
+
+    write_probability_sweep_percolation_probability("print/data", probability_grid,
+                                                    percolation_counts, npoints,
+                                                    probability_center, decay,
+                                                    nrepetitions_final, rows, columns,
+                                                    seed);
+    sweep_points_write_observables("print/data", points, npoints, probability_center,
+                                   decay, rows, columns, seed);
+
+    free(probability_grid);
+    free(percolation_counts);
+    free(nrepetitions_final);
+}
+
+void sweep_points_write_observables(const char * path, const sweep_point * points,
+                                    int npoints, double probability_center,
+                                    double decay, int rows, int columns,
+                                    unsigned int seed)
+{
+    int i;
+    double * probability_grid;
+    int * realizations;
+    double * moments; /* mean and variance of each observable, one column after the other */
+
+    probability_grid = (double *)malloc(npoints*sizeof(double));
+    realizations = (int *)malloc(npoints*sizeof(int));
+    moments = (double *)malloc(6*npoints*sizeof(double));
+    for (i = 0; i < npoints; i++) {
+        probability_grid[i] = points[i].probability;
+        realizations[i] = points[i].realizations;
+        moments[i] = points[i].mean_cluster_size.mean;
+        moments[npoints + i] = running_moments_variance(&points[i].mean_cluster_size);
+        moments[2*npoints + i] = points[i].second_moment.mean;
+        moments[3*npoints + i] = running_moments_variance(&points[i].second_moment);
+        moments[4*npoints + i] = points[i].strength.mean;
+        moments[5*npoints + i] = running_moments_variance(&points[i].strength);
+    }
+
+    write_probability_sweep_observables(path, probability_grid, npoints,
+                                        probability_center, decay, realizations,
+                                        moments, moments + npoints,
+                                        moments + 2*npoints, moments + 3*npoints,
+                                        moments + 4*npoints, moments + 5*npoints,
+                                        rows, columns, seed);
+
+    free(probability_grid);
+    free(realizations);
+    free(moments);
+}
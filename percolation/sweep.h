@@ -0,0 +1,252 @@
+/*!
+    @file sweep.h
+    @brief This file contains functions to sample and accumulate the statistics
+    of a single point of a probability sweep.
+
+    @author Federico Cerisola
+    @copyright MIT License.
+*/
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "corpus.h"
+#include "math_extra.h"
+#include "profiling.h"
+
+struct sweep_pipeline; /* see pipeline.h */
+struct bond_lattice; /* see bonds.h */
+struct run_status; /* see status.h */
+
+/*! Accumulated results for one occupation probability of a sweep. */
+typedef struct {
+    double probability; /*!< occupation probability of the grid point */
+    int percolation_count; /*!< how many realizations had a percolating cluster */
+    int realizations; /*!< how many realizations have been sampled */
+    int cluster_sizes_total_count; /*!< total number of different cluster sizes */
+    int * cluster_sizes; /*!< sizes of clusters */
+    int * cluster_sizes_counts; /*!< count of clusters of each size */
+    int * cluster_sizes_percolated; /*!< percolating clusters of each size */
+    running_moments mean_cluster_size; /*!< mean size of the non percolating cluster of an occupied site */
+    running_moments second_moment; /*!< sum of s^2 n_s over non percolating clusters, per site */
+    running_moments strength; /*!< fraction of sites in percolating clusters (P infinity) */
+    phase_profile profile; /*!< time spent in each phase, if profiling is enabled (not checkpointed) */
+} sweep_point;
+
+/*! Initialize a sweep point with no accumulated realizations.
+
+    @param point pointer to the sweep point to be initialized.
+    @param probability the occupation probability of the point.
+*/
+void sweep_point_init(sweep_point * point, double probability);
+
+/*! Free the cluster statistics accumulated in a sweep point.
+
+    The percolation and realization counters are kept, so that they can still
+    be used after the cluster statistics have been written out.
+
+    @param point pointer to the sweep point to be cleared.
+*/
+void sweep_point_clear(sweep_point * point);
+
+/*! Accumulate the statistics of an already labeled lattice into a sweep
+    point.
+
+    Its cluster statistics and percolation are aggregated into the point,
+    together with the running moments of its observables.
+
+    @param point pointer to the sweep point where results are accumulated.
+    @param lattice pointer to the labeled lattice.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+*/
+void sweep_point_accumulate(sweep_point * point, const int * lattice,
+                            int rows, int columns);
+
+/*! Accumulate the cluster statistics of one lattice realization into a
+    sweep point.
+
+    This is what sweep_point_accumulate does once the statistics of a
+    labeled lattice are computed, for lattices that are never stored whole
+    (e.g. the cubic ones of cubic.h).
+
+    @param point pointer to the sweep point where results are accumulated.
+    @param cluster_sizes_total_count the number of different cluster sizes.
+    @param cluster_sizes the different cluster sizes of the lattice.
+    @param cluster_sizes_counts the number of clusters of each size.
+    @param cluster_sizes_percolated the number of percolating clusters of
+        each size.
+    @param sites the number of sites in the lattice.
+
+    @see cluster_statistics for the layout of the statistics arrays.
+*/
+void sweep_point_add_clusters(sweep_point * point, int cluster_sizes_total_count,
+                              const int * cluster_sizes,
+                              const int * cluster_sizes_counts,
+                              const int * cluster_sizes_percolated, long sites);
+
+/*! Function that samples one lattice realization with the given
+    probability and computes its cluster statistics.
+
+    Its first argument is the data given to sweep_points_run. The statistics
+    arrays have the layout of cluster_statistics and are free'd by the
+    caller.
+*/
+typedef void (*sweep_sampling_function)(void * data, double probability,
+                                        int * cluster_sizes_total_count,
+                                        int ** cluster_sizes,
+                                        int ** cluster_sizes_counts,
+                                        int ** cluster_sizes_percolated);
+
+/*! Add the results accumulated in a sweep point to another one with the
+    same probability.
+
+    @param point pointer to the sweep point where results are accumulated.
+    @param other pointer to the sweep point to be added; it is not modified.
+*/
+void sweep_point_merge(sweep_point * point, const sweep_point * other);
+
+/*! Sample new lattice realizations and accumulate their statistics.
+
+    Each realization is populated using the global random number generator,
+    labeled, and its cluster statistics and percolation are aggregated into
+    the point, together with the running moments of its observables. If a
+    pipeline was set with sweep_set_pipeline the realizations are sampled by
+    its threads instead (see sweep_pipeline_sample), and if bonds were set
+    with sweep_set_bonds their bonds are populated instead of the sites (bond
+    percolation).
+
+    @param point pointer to the sweep point where results are accumulated.
+    @param lattice pointer to a lattice used as scratch space.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param nrealizations how many realizations to sample.
+*/
+void sweep_point_sample(sweep_point * point, int * lattice, int rows, int columns,
+                        int nrealizations);
+
+/*! Sample new lattice realizations and accumulate the statistics of
+    concentric sub-boxes of each of them.
+
+    Each realization of the largest lattice is populated using the global
+    random number generator and its sub-boxes are labeled at once with
+    label_nested_boxes, so that every box size shares the same realizations.
+
+    @param points array with one sweep point per box size where results are
+        accumulated (all with the same probability).
+    @param lattice pointer to a lattice used as scratch space.
+    @param size the number of rows and columns of the largest lattice.
+    @param box_sizes the sizes of the sub-boxes, in increasing order.
+    @param box_count the number of sub-boxes.
+    @param boxes array of pointers to lattices of the matching sizes used as
+        scratch space for the labeled sub-boxes.
+    @param nrealizations how many realizations to sample.
+
+    @see label_nested_boxes
+*/
+void sweep_points_sample_nested(sweep_point * points, int * lattice, int size,
+                                const int * box_sizes, int box_count,
+                                int ** boxes, int nrealizations);
+
+/*! Run a sweep with a fixed number of realizations per point, for lattices
+    that are not sampled by sweep_point_sample (e.g. those of cubic.h and
+    graph.h).
+
+    The realizations of each point are sampled with the given function and
+    accumulated with sweep_point_add_clusters, and the cluster statistics of
+    the point are written to print/data and cleared. Then the percolation
+    probability and the observables of all the points are written.
+
+    @param points array of sweep points, initialized with sweep_point_init.
+    @param npoints the number of points.
+    @param probability_center the central probability of the grid.
+    @param decay the exponential decay coefficient of the grid.
+    @param nrepetitions how many realizations to sample for each point.
+    @param sample function that samples a realization.
+    @param data pointer given to the sampling function.
+    @param sites the number of sites in each lattice.
+    @param rows the number of rows of the lattice, for the output files.
+    @param columns the number of columns of the lattice, for the output files.
+    @param seed the random number generator seed of the sweep.
+    @param status pointer to the status file of the run, or NULL for none.
+*/
+void sweep_points_run(sweep_point * points, int npoints, double probability_center,
+                      double decay, int nrepetitions, sweep_sampling_function sample,
+                      void * data, long sites, int rows, int columns,
+                      unsigned int seed, struct run_status * status);
+
+/*! Write the running moments of the observables of sweep points to a file.
+
+    @param path path to the folder where the data will be written.
+    @param points array of sweep points.
+    @param npoints the number of points.
+    @param probability_center the central probability of the grid.
+    @param decay the exponential decay coefficient of the grid.
+    @param rows the number of rows in the lattice.
+    @param columns the number of columns in the lattice.
+    @param seed the random number generator seed of the sweep.
+
+    @see write_probability_sweep_observables
+*/
+void sweep_points_write_observables(const char * path, const sweep_point * points,
+                                    int npoints, double probability_center,
+                                    double decay, int rows, int columns,
+                                    unsigned int seed);
+
+/*! Store every realization sampled by sweep_point_sample in a corpus.
+
+    The realizations are stored after being labeled, so the corpus keeps
+    their labels if it was created with them.
+
+    @param corpus pointer to a corpus created with create_lattice_corpus, or
+        NULL to stop storing realizations.
+*/
+void sweep_set_corpus(lattice_corpus * corpus);
+
+/*! Sample the realizations of sweep_point_sample with the threads of a
+    pipeline.
+
+    @param pipeline pointer to a pipeline created with create_sweep_pipeline,
+        or NULL to go back to sampling in the calling thread.
+*/
+void sweep_set_pipeline(struct sweep_pipeline * pipeline);
+
+/*! Sample bond percolation instead of site percolation in
+    sweep_point_sample.
+
+    @param bonds pointer to bonds with the size of the lattice, created with
+        allocate_bond_lattice, or NULL to go back to site percolation.
+*/
+void sweep_set_bonds(struct bond_lattice * bonds);
+
+/*! Accumulate cluster sizes in logarithmic bins instead of exactly.
+
+    While enabled, the cluster_sizes of every sweep point hold the smallest
+    size of each bin (see cluster_size_bin) and the counts hold the totals of
+    the whole bin, so the cost of aggregating a realization and the length of
+    the statistics only grow with the logarithm of the lattice size. Bins with
+    no clusters are kept, with zero counts.
+
+    @param bins_per_decade the number of logarithmic bins per decade, or 0 to
+        go back to exact cluster sizes.
+    @param exact_sizes the largest size that is not binned; it is raised to
+        the minimum allowed by the number of bins if needed.
+    @return The exact_sizes actually used.
+*/
+int sweep_set_log_bins(int bins_per_decade, int exact_sizes);
+
+/*! Accumulate the statistics of realizations stored in a corpus.
+
+    @param point pointer to the sweep point where results are accumulated.
+    @param corpus pointer to a corpus opened with open_lattice_corpus.
+    @param first index of the first realization to replay.
+    @param nrealizations how many consecutive realizations to replay.
+    @param lattice pointer to a lattice of the size of the corpus used as
+        scratch space.
+
+    @see read_lattice_corpus
+*/
+void sweep_point_replay(sweep_point * point, const lattice_corpus * corpus,
+                        long first, long nrealizations, int * lattice);
+
+#endif /* SWEEP_H */
@@ -0,0 +1,777 @@
+/* Copyright 2017 Federico Cerisola */
+/* MIT License (see root directory) */
+
+/* headers */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "random.h"
+#include "lattice.h"
+#include "clusters.h"
+#include "cubic.h"
+#include "graph.h"
+#include "bonds.h"
+#include "cli.h"
+
+/* a labeling kernel: labels the clusters of a populated lattice in place */
+typedef void (*labeling_kernel)(int * lattice, int rows, int columns);
+
+static void label_clusters_with_geometry(int * lattice, int rows, int columns)
+{
+    cluster_geometry * geometry;
+
+    label_clusters_geometry(lattice, rows, columns, &geometry);
+    free(geometry);
+}
+
+static void label_square_graph(int * lattice, int rows, int columns)
+{
+    site_graph * graph;
+
+    graph = create_square_graph(rows, columns);
+    label_graph_clusters(graph, lattice);
+    free_site_graph(graph);
+}
+
+/* every labeling kernel is checked against the reference; alternative fast
+   paths are validated by adding them here */
+static const struct {
+    const char * name;
+    labeling_kernel label;
+} kernels[] = {
+    {"label_clusters", label_clusters},
+    {"label_clusters_geometry", label_clusters_with_geometry},
+    {"label_clusters_runs", label_clusters_runs},
+    {"label_graph_clusters", label_square_graph}
+};
+
+/* a lattice used as input of the checks */
+typedef struct {
+    char name[64];
+    int rows;
+    int columns;
+    int * occupancy;
+} validation_case;
+
+/* reference labeling: depth-first search from every unvisited occupied site;
+   returns the number of clusters, labeled from 1 */
+static int reference_label(const int * occupancy, int rows, int columns,
+                           int * labels, int * stack)
+{
+    int i;
+    int site;
+    int row;
+    int column;
+    int stack_size;
+    int cluster_count;
+
+    for (i = 0; i < rows*columns; i++) {
+        labels[i] = 0;
+    }
+    cluster_count = 0;
+    for (i = 0; i < rows*columns; i++) {
+        if (!occupancy[i] || labels[i]) {
+            continue;
+        }
+        cluster_count++;
+        labels[i] = cluster_count;
+        stack[0] = i;
+        stack_size = 1;
+        while (stack_size > 0) {
+            site = stack[--stack_size];
+            row = site / columns;
+            column = site % columns;
+            if (row > 0 && occupancy[site - columns] && !labels[site - columns]) {
+                labels[site - columns] = cluster_count;
+                stack[stack_size++] = site - columns;
+            }
+            if (row < rows - 1 && occupancy[site + columns] && !labels[site + columns]) {
+                labels[site + columns] = cluster_count;
+                stack[stack_size++] = site + columns;
+            }
+            if (column > 0 && occupancy[site - 1] && !labels[site - 1]) {
+                labels[site - 1] = cluster_count;
+                stack[stack_size++] = site - 1;
+            }
+            if (column < columns - 1 && occupancy[site + 1] && !labels[site + 1]) {
+                labels[site + 1] = cluster_count;
+                stack[stack_size++] = site + 1;
+            }
+        }
+    }
+
+    return cluster_count;
+}
+
+/* check that two labelings describe the same partition of the sites */
+static char same_partition(const int * labels, const int * reference, int size)
+{
+    int i;
+    int max_label;
+    int * to_reference;
+    int * from_reference;
+    char same;
+
+    max_label = 0;
+    for (i = 0; i < size; i++) {
+        if (labels[i] < 0) {
+            return 0;
+        }
+        max_label = labels[i] > max_label ? labels[i] : max_label;
+        max_label = reference[i] > max_label ? reference[i] : max_label;
+    }
+    to_reference = (int *)calloc(max_label + 1, sizeof(int));
+    from_reference = (int *)calloc(max_label + 1, sizeof(int));
+
+    same = 1;
+    for (i = 0; i < size && same; i++) {
+        if ((labels[i] == 0) != (reference[i] == 0)) {
+            same = 0;
+        } else if (labels[i] == 0) {
+            continue;
+        } else if (to_reference[labels[i]] == 0 && from_reference[reference[i]] == 0) {
+            to_reference[labels[i]] = reference[i];
+            from_reference[reference[i]] = labels[i];
+        } else if (to_reference[labels[i]] != reference[i] ||
+                   from_reference[reference[i]] != labels[i]) {
+            same = 0;
+        }
+    }
+
+    free(to_reference);
+    free(from_reference);
+
+    return same;
+}
+
+/* run every check on a lattice; returns the number of failures */
+static int validate_case(const validation_case * c)
+{
+    int i;
+    int k;
+    int size;
+    int cluster_count;
+    int failures;
+    int * reference;
+    int * lattice;
+    int * stack;
+    int * reference_sizes; /* size of each reference cluster */
+    char * reference_borders; /* sides touched by each cluster: 1 top, 2 bottom, 4 left, 8 right */
+    int * expected_counts; /* clusters of each size */
+    int * expected_percolated; /* spanning clusters of each size */
+    int * found_counts;
+    int * found_percolated;
+    char expected_percolates;
+    int statistics_count;
+    int * cluster_sizes;
+    int * cluster_sizes_counts;
+    int * cluster_sizes_percolated;
+    site_graph * graph;
+
+    size = c->rows*c->columns;
+    reference = (int *)malloc(size*sizeof(int));
+    lattice = (int *)malloc(size*sizeof(int));
+    stack = (int *)malloc(size*sizeof(int));
+    expected_counts = (int *)calloc(size + 1, sizeof(int));
+    expected_percolated = (int *)calloc(size + 1, sizeof(int));
+    found_counts = (int *)malloc((size + 1)*sizeof(int));
+    found_percolated = (int *)malloc((size + 1)*sizeof(int));
+
+    /* expected results from the reference labeling */
+    cluster_count = reference_label(c->occupancy, c->rows, c->columns, reference, stack);
+    reference_sizes = (int *)calloc(cluster_count + 1, sizeof(int));
+    reference_borders = (char *)calloc(cluster_count + 1, sizeof(char));
+    for (i = 0; i < size; i++) {
+        if (!reference[i]) {
+            continue;
+        }
+        reference_sizes[reference[i]] += 1;
+        reference_borders[reference[i]] |= (i / c->columns == 0) |
+                                           (i / c->columns == c->rows - 1) << 1 |
+                                           (i % c->columns == 0) << 2 |
+                                           (i % c->columns == c->columns - 1) << 3;
+    }
+    expected_percolates = 0;
+    for (k = 1; k <= cluster_count; k++) {
+        expected_counts[reference_sizes[k]] += 1;
+        if ((reference_borders[k] & 3) == 3 || (reference_borders[k] & 12) == 12) {
+            expected_percolated[reference_sizes[k]] += 1;
+            expected_percolates = 1;
+        }
+    }
+
+    failures = 0;
+    for (k = 0; k < (int)(sizeof(kernels)/sizeof(kernels[0])); k++) {
+        memcpy(lattice, c->occupancy, size*sizeof(int));
+        kernels[k].label(lattice, c->rows, c->columns);
+
+        if (!same_partition(lattice, reference, size)) {
+            printf("FAIL %s: %s partition differs from the reference\n",
+                   c->name, kernels[k].name);
+            failures++;
+            continue;
+        }
+
+        if (has_percolating_cluster(lattice, c->rows, c->columns) != expected_percolates) {
+            printf("FAIL %s: has_percolating_cluster after %s returned %d\n",
+                   c->name, kernels[k].name, !expected_percolates);
+            failures++;
+        }
+
+        cluster_statistics(lattice, c->rows, c->columns, &statistics_count,
+                           &cluster_sizes, &cluster_sizes_counts,
+                           &cluster_sizes_percolated, NULL, NULL);
+        for (i = 0; i <= size; i++) {
+            found_counts[i] = 0;
+            found_percolated[i] = 0;
+        }
+        for (i = 0; i < statistics_count; i++) {
+            found_counts[cluster_sizes[i]] += cluster_sizes_counts[i];
+            found_percolated[cluster_sizes[i]] += cluster_sizes_percolated[i];
+        }
+        if (memcmp(found_counts, expected_counts, (size + 1)*sizeof(int)) != 0 ||
+            memcmp(found_percolated, expected_percolated, (size + 1)*sizeof(int)) != 0) {
+            printf("FAIL %s: cluster_statistics after %s differs from the reference\n",
+                   c->name, kernels[k].name);
+            failures++;
+        }
+        free(cluster_sizes);
+        free(cluster_sizes_counts);
+        free(cluster_sizes_percolated);
+    }
+
+    /* the spanning test that does not label the lattice */
+    memcpy(lattice, c->occupancy, size*sizeof(int));
+    if (lattice_percolates(lattice, c->rows, c->columns) != expected_percolates) {
+        printf("FAIL %s: lattice_percolates returned %d\n", c->name, !expected_percolates);
+        failures++;
+    }
+
+    /* the spanning test and statistics of the graph engine, from the
+       boundaries of the square graph */
+    graph = create_square_graph(c->rows, c->columns);
+    memcpy(lattice, c->occupancy, size*sizeof(int));
+    label_graph_clusters(graph, lattice);
+    if (graph_has_percolating_cluster(graph, lattice) != expected_percolates) {
+        printf("FAIL %s: graph_has_percolating_cluster returned %d\n", c->name,
+               !expected_percolates);
+        failures++;
+    }
+    graph_cluster_statistics(graph, lattice, &statistics_count, &cluster_sizes,
+                             &cluster_sizes_counts, &cluster_sizes_percolated);
+    for (i = 0; i <= size; i++) {
+        found_counts[i] = 0;
+        found_percolated[i] = 0;
+    }
+    for (i = 0; i < statistics_count; i++) {
+        found_counts[cluster_sizes[i]] += cluster_sizes_counts[i];
+        found_percolated[cluster_sizes[i]] += cluster_sizes_percolated[i];
+    }
+    if (memcmp(found_counts, expected_counts, (size + 1)*sizeof(int)) != 0 ||
+        memcmp(found_percolated, expected_percolated, (size + 1)*sizeof(int)) != 0) {
+        printf("FAIL %s: graph_cluster_statistics differs from the reference\n", c->name);
+        failures++;
+    }
+    free(cluster_sizes);
+    free(cluster_sizes_counts);
+    free(cluster_sizes_percolated);
+    free_site_graph(graph);
+
+    free(reference);
+    free(lattice);
+    free(stack);
+    free(reference_sizes);
+    free(reference_borders);
+    free(expected_counts);
+    free(expected_percolated);
+    free(found_counts);
+    free(found_percolated);
+
+    return failures;
+}
+
+/* check the streamed labeling of a cubic lattice against a depth-first
+   search over the whole cube; returns the number of failures */
+static int validate_cubic_case(const char * name, const int * occupancy, int size,
+                               cubic_labeler * labeler)
+{
+    int i;
+    int k;
+    int site;
+    int row;
+    int column;
+    int plane;
+    int area;
+    int volume;
+    int stack_size;
+    int cluster_size;
+    int borders;
+    int * labels;
+    int * stack;
+    int * expected_counts;
+    int * expected_percolated;
+    int * found_counts;
+    int * found_percolated;
+    int statistics_count;
+    int * cluster_sizes;
+    int * cluster_sizes_counts;
+    int * cluster_sizes_percolated;
+    int failures;
+
+    area = size*size;
+    volume = area*size;
+    labels = (int *)calloc(volume, sizeof(int));
+    stack = (int *)malloc(volume*sizeof(int));
+    expected_counts = (int *)calloc(volume + 1, sizeof(int));
+    expected_percolated = (int *)calloc(volume + 1, sizeof(int));
+    found_counts = (int *)calloc(volume + 1, sizeof(int));
+    found_percolated = (int *)calloc(volume + 1, sizeof(int));
+
+    for (i = 0; i < volume; i++) {
+        if (!occupancy[i] || labels[i]) {
+            continue;
+        }
+        labels[i] = 1;
+        stack[0] = i;
+        stack_size = 1;
+        cluster_size = 0;
+        borders = 0;
+        while (stack_size > 0) {
+            site = stack[--stack_size];
+            cluster_size++;
+            plane = site / area;
+            row = (site % area) / size;
+            column = site % size;
+            borders |= (column == 0) | (column == size - 1) << 1 | (row == 0) << 2 |
+                       (row == size - 1) << 3 | (plane == 0) << 4 | (plane == size - 1) << 5;
+            if (column > 0 && occupancy[site - 1] && !labels[site - 1]) {
+                labels[site - 1] = 1;
+                stack[stack_size++] = site - 1;
+            }
+            if (column < size - 1 && occupancy[site + 1] && !labels[site + 1]) {
+                labels[site + 1] = 1;
+                stack[stack_size++] = site + 1;
+            }
+            if (row > 0 && occupancy[site - size] && !labels[site - size]) {
+                labels[site - size] = 1;
+                stack[stack_size++] = site - size;
+            }
+            if (row < size - 1 && occupancy[site + size] && !labels[site + size]) {
+                labels[site + size] = 1;
+                stack[stack_size++] = site + size;
+            }
+            if (plane > 0 && occupancy[site - area] && !labels[site - area]) {
+                labels[site - area] = 1;
+                stack[stack_size++] = site - area;
+            }
+            if (plane < size - 1 && occupancy[site + area] && !labels[site + area]) {
+                labels[site + area] = 1;
+                stack[stack_size++] = site + area;
+            }
+        }
+        expected_counts[cluster_size] += 1;
+        if ((borders & 3) == 3 || (borders & 12) == 12 || (borders & 48) == 48) {
+            expected_percolated[cluster_size] += 1;
+        }
+    }
+
+    for (k = 0; k < size; k++) {
+        memcpy(cubic_labeler_plane(labeler), occupancy + k*area, area*sizeof(int));
+        label_cubic_plane(labeler);
+    }
+    cubic_cluster_statistics(labeler, &statistics_count, &cluster_sizes,
+                             &cluster_sizes_counts, &cluster_sizes_percolated);
+    for (i = 0; i < statistics_count; i++) {
+        found_counts[cluster_sizes[i]] += cluster_sizes_counts[i];
+        found_percolated[cluster_sizes[i]] += cluster_sizes_percolated[i];
+    }
+
+    failures = 0;
+    if (memcmp(found_counts, expected_counts, (volume + 1)*sizeof(int)) != 0 ||
+        memcmp(found_percolated, expected_percolated, (volume + 1)*sizeof(int)) != 0) {
+        printf("FAIL %s: cubic_cluster_statistics differs from the reference\n", name);
+        failures++;
+    }
+
+    free(cluster_sizes);
+    free(cluster_sizes_counts);
+    free(cluster_sizes_percolated);
+    free(labels);
+    free(stack);
+    free(expected_counts);
+    free(expected_percolated);
+    free(found_counts);
+    free(found_percolated);
+
+    return failures;
+}
+
+/* check that the adjacency of a lattice graph is symmetric, has no self
+   loops and has the expected number of edges; returns the number of
+   failures */
+static int validate_graph(const char * name, const site_graph * graph, int max_degree,
+                          long edges)
+{
+    int v;
+    int k;
+    int q;
+    char found;
+
+    if (graph->offsets[graph->nodes] != 2*edges) {
+        printf("FAIL %s: %d neighbors instead of %ld\n", name,
+               graph->offsets[graph->nodes], 2*edges);
+        return 1;
+    }
+    for (v = 0; v < graph->nodes; v++) {
+        if (graph->offsets[v + 1] - graph->offsets[v] > max_degree) {
+            printf("FAIL %s: node %d has %d neighbors\n", name, v,
+                   graph->offsets[v + 1] - graph->offsets[v]);
+            return 1;
+        }
+        for (k = graph->offsets[v]; k < graph->offsets[v + 1]; k++) {
+            found = 0;
+            for (q = graph->offsets[graph->neighbors[k]];
+                 q < graph->offsets[graph->neighbors[k] + 1]; q++) {
+                found |= graph->neighbors[q] == v;
+            }
+            if (graph->neighbors[k] == v || !found) {
+                printf("FAIL %s: edge %d-%d is not symmetric\n", name, v,
+                       graph->neighbors[k]);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* check the clusters of a bond lattice against those of the graph with its
+   open bonds as edges, and that no bond is open past the last row or
+   column; returns the number of failures */
+static int validate_bond_case(const char * name, const bond_lattice * bonds)
+{
+    int i;
+    int j;
+    int k;
+    int edges;
+    int set_bits;
+    int size;
+    int * endpoints;
+    int * labels;
+    int * reference;
+    site_graph * graph;
+    char same;
+
+    size = bonds->rows*bonds->columns;
+    endpoints = (int *)malloc((4*size + 1)*sizeof(int));
+    edges = 0;
+    for (i = 0; i < bonds->rows; i++) {
+        for (j = 0; j < bonds->columns; j++) {
+            k = i*bonds->words + j/64;
+            if (j < bonds->columns - 1 && ((bonds->horizontal[k] >> (j % 64)) & 1)) {
+                endpoints[2*edges] = i*bonds->columns + j;
+                endpoints[2*edges + 1] = i*bonds->columns + j + 1;
+                edges++;
+            }
+            if (i < bonds->rows - 1 && ((bonds->vertical[k] >> (j % 64)) & 1)) {
+                endpoints[2*edges] = i*bonds->columns + j;
+                endpoints[2*edges + 1] = (i + 1)*bonds->columns + j;
+                edges++;
+            }
+        }
+    }
+    set_bits = 0;
+    for (k = 0; k < bonds->rows*bonds->words; k++) {
+        for (j = 0; j < 64; j++) {
+            set_bits += ((bonds->horizontal[k] >> j) & 1) + ((bonds->vertical[k] >> j) & 1);
+        }
+    }
+    if (set_bits != edges) {
+        printf("FAIL %s: %d bonds open past the edges\n", name, set_bits - edges);
+        free(endpoints);
+        return 1;
+    }
+
+    graph = create_site_graph(size, edges, endpoints);
+    labels = allocate_lattice(bonds->rows, bonds->columns, 0);
+    reference = allocate_lattice(bonds->rows, bonds->columns, 0);
+    for (k = 0; k < size; k++) {
+        reference[k] = 1;
+    }
+    label_graph_clusters(graph, reference);
+    label_bond_clusters(bonds, labels);
+    same = same_partition(labels, reference, size);
+    if (!same) {
+        printf("FAIL %s: bond clusters differ from the reference\n", name);
+    }
+
+    free_site_graph(graph);
+    free(endpoints);
+    free(labels);
+    free(reference);
+
+    return !same;
+}
+
+/* check that the bonds open in low are also open in high; returns the
+   number of failures */
+static int validate_bond_nesting(const char * name, const bond_lattice * low,
+                                 const bond_lattice * high)
+{
+    int k;
+
+    for (k = 0; k < low->rows*low->words; k++) {
+        if ((low->horizontal[k] & ~high->horizontal[k]) ||
+            (low->vertical[k] & ~high->vertical[k])) {
+            printf("FAIL %s: bonds of word %d are not nested\n", name, k);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* adversarial patterns, indexed by site */
+static int pattern_site(const char * pattern, int row, int column, int rows, int columns)
+{
+    if (strcmp(pattern, "full") == 0) {
+        return 1;
+    } else if (strcmp(pattern, "empty") == 0) {
+        return 0;
+    } else if (strcmp(pattern, "checkerboard") == 0) {
+        return (row + column) % 2 == 0;
+    } else if (strcmp(pattern, "vertical_stripes") == 0) {
+        return column % 2 == 0;
+    } else if (strcmp(pattern, "horizontal_stripes") == 0) {
+        return row % 2 == 0;
+    } else if (strcmp(pattern, "comb") == 0) {
+        /* teeth hanging from the first row */
+        return row == 0 || (column % 2 == 0 && row < rows - 1);
+    } else if (strcmp(pattern, "inverted_comb") == 0) {
+        /* teeth joined only at the last row, so every tooth gets its own
+           label until the last row merges them all */
+        return row == rows - 1 || (column % 2 == 0 && row > 0);
+    } else if (strcmp(pattern, "serpentine") == 0) {
+        /* a single path going back and forth over the rows */
+        return row % 2 == 0 ||
+               (row % 4 == 1 && column == columns - 1) ||
+               (row % 4 == 3 && column == 0);
+    } else if (strcmp(pattern, "frame") == 0) {
+        return row == 0 || column == 0 || row == rows - 1 || column == columns - 1;
+    } else if (strcmp(pattern, "diagonals") == 0) {
+        /* connected only through next-nearest neighbours */
+        return (row - column) % 3 == 0;
+    }
+    return 0;
+}
+
+/* a square spiral wound inwards, separated by empty rings */
+static void fill_spiral(int * occupancy, int rows, int columns)
+{
+    int i;
+    int top;
+    int bottom;
+    int left;
+    int right;
+
+    for (i = 0; i < rows*columns; i++) {
+        occupancy[i] = 0;
+    }
+    top = 0;
+    left = 0;
+    bottom = rows - 1;
+    right = columns - 1;
+    while (top <= bottom && left <= right) {
+        for (i = left; i <= right; i++) {
+            occupancy[top*columns + i] = 1;
+        }
+        for (i = top; i <= bottom; i++) {
+            occupancy[i*columns + right] = 1;
+        }
+        if (top + 2 <= bottom) {
+            for (i = left; i <= right; i++) {
+                occupancy[bottom*columns + i] = 1;
+            }
+        }
+        if (left + 2 <= right && top + 2 <= bottom) {
+            for (i = top + 2; i <= bottom; i++) {
+                occupancy[i*columns + left] = 1;
+            }
+            if (left + 1 < right - 1) {
+                occupancy[(top + 2)*columns + left + 1] = 1;
+            }
+        }
+        top += 2;
+        left += 2;
+        bottom -= 2;
+        right -= 2;
+    }
+}
+
+/* main body function */
+int main(int argc, char ** argv)
+{
+    static const char * patterns[] = {
+        "full", "empty", "checkerboard", "vertical_stripes", "horizontal_stripes",
+        "comb", "inverted_comb", "serpentine", "frame", "diagonals"
+    };
+    static const int shapes[][2] = {
+        {1, 1}, {1, 2}, {2, 1}, {1, 37}, {37, 1}, {2, 2}, {3, 5}, {5, 3},
+        {16, 16}, {17, 64}, {64, 17}, {128, 128}
+    };
+    static const double probabilities[] = {0, 0.1, 0.3, 0.5, 0.5927, 0.7, 0.9, 1};
+    static const int cubic_sizes[] = {1, 2, 3, 5, 8, 17};
+    static const double cubic_probabilities[] = {0, 0.1, 0.2, 0.3116, 0.4, 0.6, 1};
+    static const double bond_probabilities[] = {0, 0.25, 0.5, 0.75, 1};
+    static const double nested_bond_probabilities[][2] = {
+        {0, 0.25}, {0.45, 0.55}, {0.5, 0.5 + 1e-9}, {0.75, 1}
+    };
+    char name[64];
+    int size;
+    int * cube;
+    cubic_labeler * labeler;
+    site_graph * graph;
+    bond_lattice * bonds;
+    bond_lattice * higher_bonds;
+    pcg32_random_t bonds_state; /* random number generator state shared by nested bond lattices */
+    long vertical_edges;
+    const char * option;
+    int repetitions; /* random lattices of each shape and probability */
+    unsigned int random_seed;
+    validation_case c;
+    int cases;
+    int failures;
+    int i, j, k, n;
+
+    /* read optional arguments */
+    repetitions = (option = extract_option(&argc, argv, "repetitions")) ? atoi(option) : 20;
+    random_seed = (option = extract_option(&argc, argv, "seed")) ? atoi(option) : 1;
+    if (argc > 1) {
+        printf("usage: [--repetitions=N] [--seed=SEED]\n");
+        return 1;
+    }
+
+    srand_pcg(random_seed);
+
+    cases = 0;
+    failures = 0;
+    for (i = 0; i < (int)(sizeof(shapes)/sizeof(shapes[0])); i++) {
+        c.rows = shapes[i][0];
+        c.columns = shapes[i][1];
+        c.occupancy = allocate_lattice(c.rows, c.columns, 0);
+
+        /* adversarial lattices */
+        for (j = 0; j < (int)(sizeof(patterns)/sizeof(patterns[0])); j++) {
+            sprintf(c.name, "%s %dx%d", patterns[j], c.rows, c.columns);
+            for (k = 0; k < c.rows*c.columns; k++) {
+                c.occupancy[k] = pattern_site(patterns[j], k / c.columns, k % c.columns,
+                                              c.rows, c.columns);
+            }
+            failures += validate_case(&c);
+            cases++;
+        }
+        sprintf(c.name, "spiral %dx%d", c.rows, c.columns);
+        fill_spiral(c.occupancy, c.rows, c.columns);
+        failures += validate_case(&c);
+        cases++;
+
+        /* random lattices */
+        for (j = 0; j < (int)(sizeof(probabilities)/sizeof(probabilities[0])); j++) {
+            for (n = 0; n < repetitions; n++) {
+                sprintf(c.name, "random p=%g %dx%d #%d", probabilities[j], c.rows,
+                        c.columns, n);
+                populate_lattice(probabilities[j], c.occupancy, c.rows, c.columns, 0);
+                failures += validate_case(&c);
+                cases++;
+            }
+        }
+
+        /* lattices of the graph engine other than the square one */
+        sprintf(name, "triangular graph %dx%d", c.rows, c.columns);
+        graph = create_triangular_graph(c.rows, c.columns);
+        failures += validate_graph(name, graph, 6, 3L*c.rows*c.columns - 2L*(c.rows + c.columns) + 1);
+        free_site_graph(graph);
+        sprintf(name, "honeycomb graph %dx%d", c.rows, c.columns);
+        graph = create_honeycomb_graph(c.rows, c.columns);
+        vertical_edges = 0;
+        for (k = 1; k < c.rows*c.columns; k++) {
+            vertical_edges += k >= c.columns && (k / c.columns + k % c.columns) % 2 == 0;
+        }
+        failures += validate_graph(name, graph, 3, ((long)c.rows)*(c.columns - 1) + vertical_edges);
+        free_site_graph(graph);
+        cases += 2;
+
+        /* bond lattices */
+        bonds = allocate_bond_lattice(c.rows, c.columns);
+        for (j = 0; j < (int)(sizeof(bond_probabilities)/sizeof(bond_probabilities[0])); j++) {
+            for (n = 0; n < repetitions; n++) {
+                sprintf(name, "bonds p=%g %dx%d #%d", bond_probabilities[j], c.rows,
+                        c.columns, n);
+                populate_bonds(bond_probabilities[j], bonds, 0);
+                failures += validate_bond_case(name, bonds);
+                cases++;
+            }
+        }
+
+        /* lattices drawn from the same random numbers at increasing
+           probabilities, as in the bisection search */
+        higher_bonds = allocate_bond_lattice(c.rows, c.columns);
+        for (j = 0; j < (int)(sizeof(nested_bond_probabilities)/sizeof(nested_bond_probabilities[0])); j++) {
+            for (n = 0; n < repetitions; n++) {
+                sprintf(name, "nested bonds p=%g<%g %dx%d #%d", nested_bond_probabilities[j][0],
+                        nested_bond_probabilities[j][1], c.rows, c.columns, n);
+                get_state_pcg(&bonds_state);
+                populate_bonds_nested(nested_bond_probabilities[j][0], bonds, 0);
+                set_state_pcg(&bonds_state);
+                populate_bonds_nested(nested_bond_probabilities[j][1], higher_bonds, 0);
+                failures += validate_bond_nesting(name, bonds, higher_bonds);
+                failures += validate_bond_case(name, higher_bonds);
+                cases++;
+            }
+        }
+        free_bond_lattice(higher_bonds);
+        free_bond_lattice(bonds);
+
+        free(c.occupancy);
+    }
+
+    /* cubic lattices: every pattern stacked in all the planes, a three
+       dimensional checkerboard and random cubes */
+    for (i = 0; i < (int)(sizeof(cubic_sizes)/sizeof(cubic_sizes[0])); i++) {
+        size = cubic_sizes[i];
+        cube = (int *)malloc(size*size*size*sizeof(int));
+        labeler = create_cubic_labeler(size);
+
+        for (j = 0; j < (int)(sizeof(patterns)/sizeof(patterns[0])); j++) {
+            sprintf(name, "stacked %s %dx%dx%d", patterns[j], size, size, size);
+            for (k = 0; k < size*size*size; k++) {
+                cube[k] = pattern_site(patterns[j], (k % (size*size)) / size, k % size,
+                                       size, size);
+            }
+            failures += validate_cubic_case(name, cube, size, labeler);
+            cases++;
+        }
+        sprintf(name, "checkerboard %dx%dx%d", size, size, size);
+        for (k = 0; k < size*size*size; k++) {
+            cube[k] = (k / (size*size) + (k % (size*size)) / size + k % size) % 2 == 0;
+        }
+        failures += validate_cubic_case(name, cube, size, labeler);
+        cases++;
+
+        for (j = 0; j < (int)(sizeof(cubic_probabilities)/sizeof(cubic_probabilities[0])); j++) {
+            for (n = 0; n < repetitions; n++) {
+                sprintf(name, "random p=%g %dx%dx%d #%d", cubic_probabilities[j], size,
+                        size, size, n);
+                populate_lattice(cubic_probabilities[j], cube, size*size, size, 0);
+                failures += validate_cubic_case(name, cube, size, labeler);
+                cases++;
+            }
+        }
+
+        free_cubic_labeler(labeler);
+        free(cube);
+    }
+
+    printf("%d lattices checked, %d failures\n", cases, failures);
+
+    return failures > 0;
+}
@@ -13,6 +13,9 @@
 #include "lattice.h"
 #include "clusters.h"
 #include "io_helpers.h"
+#include "profiling.h"
+#include "status.h"
+#include "cli.h"
 
 /* main body function */
 int main(int argc, char ** argv)
@@ -30,12 +33,39 @@ int main(int argc, char ** argv)
     int window_sizes_count;
     int concentration;
     int output_interval;
+    const char * format_option;
+    char profile; /* whether to measure the time spent in each phase */
+    phase_profile run_profile; /* time spent in each phase */
+    const char * status_path; /* file where the progress is reported (NULL for none) */
+    const char * status_option;
+    double status_interval; /* seconds between rewrites of the status file */
+    run_status * status;
     int l;
     int i, j, k, n;
 
+    /* read optional arguments */
+    if ((format_option = extract_option(&argc, argv, "format")) &&
+        !set_output_format(format_option)) {
+        printf("--format must be either csv or binary\n");
+        return 1;
+    }
+    if (extract_flag(&argc, argv, "huge-pages") && !set_lattice_huge_pages(1)) {
+        printf("huge pages are not available, using regular pages\n");
+    }
+    profile = extract_flag(&argc, argv, "profile");
+    if (profile && !enable_profiling()) {
+        printf("hardware counters are not available, profiling wall time only\n");
+    }
+    status_path = extract_option(&argc, argv, "status");
+    status_interval = 10;
+    if ((status_option = extract_option(&argc, argv, "status-interval"))) {
+        status_interval = atof(status_option);
+    }
+
     /* read input arguments; if none provided fallback to default values */
     if (argc < 4) {
-        printf("usage: L nrepetitions probability (seed)\n");
+        printf("usage: L nrepetitions probability (seed) [--format=csv|binary] [--huge-pages]"
+               " [--profile] [--status=FILE] [--status-interval=SECONDS]\n");
         return 1;
     }
     L = atoi(argv[1]);
@@ -63,11 +93,24 @@ int main(int argc, char ** argv)
         percolating_cluster_mass[i] = 0;
     }
 
+    /* the progress is periodically reported for monitoring */
+    status = NULL;
+    if (status_path) {
+        status = open_run_status(status_path, "windows_mass", L, L, status_interval);
+        if (!status) {
+            printf("could not write the status file %s\n", status_path);
+            return 1;
+        }
+    }
+
     /* calculate percolating cluster mass per window size */
+    profile_init(&run_profile);
+    PROFILE_START();
     for (n = 0; n < N; n++) {
         percolating_cluster_idx = -1;
         while (percolating_cluster_idx < 0) {
             populate_lattice(probability, lattice, L, L, 0);
+            update_run_status(status, 1, n, N, N - n, ((double)n)/N);
             concentration = 0;
             for (i = 0; i < L*L; i++) {
                 concentration += lattice[i];
@@ -76,7 +119,9 @@ int main(int argc, char ** argv)
                 ((double)concentration)/(L*L) > probability*1.0005) {
                 continue;
             }
+            PROFILE_PHASE(&run_profile, PHASE_GENERATION);
             label_clusters(lattice, L, L);
+            PROFILE_PHASE(&run_profile, PHASE_LABELING);
             for (i = 0; i < L; i++) {
                 for (j = 0; j < L; j++) {
                     if (lattice[i] && lattice[i] == lattice[(L-1)*L + j]) {
@@ -90,6 +135,7 @@ int main(int argc, char ** argv)
                 }
                 if (percolating_cluster_idx) break;
             }
+            PROFILE_PHASE(&run_profile, PHASE_PERCOLATION);
             if (percolating_cluster_idx < 0) continue;
             if (lattice[(int)(L/2.0)*L + (int)(L/2.0)] != lattice[percolating_cluster_idx]) {
                 percolating_cluster_idx = -1;
@@ -111,14 +157,23 @@ int main(int argc, char ** argv)
             }
             free(window);
         }
+        PROFILE_PHASE(&run_profile, PHASE_STATISTICS);
         /* print progress to stdout */
-        if ((n+1) % output_interval == 0) {
+        if (output_interval > 0 && (n+1) % output_interval == 0) {
             printf("finished with round %d out of %d\n", n+1, N);
         }
     }
 
+    close_run_status(status);
+
+    set_output_profile(profile ? &run_profile : NULL);
     write_mass_windowing_results("print/data", window_size, percolating_cluster_mass,
         window_sizes_count, probability, N, L, L, random_seed);
+    PROFILE_PHASE(&run_profile, PHASE_OUTPUT);
+    if (profile) {
+        printf("time spent in each phase:\n");
+        print_profile(&run_profile);
+    }
 
     free(lattice);
     free(window_size);